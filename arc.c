@@ -0,0 +1,695 @@
+/**
+ * @file    arc.c
+ *
+ * @brief   Draw arcs of circles and ellipses and rotated ellipses
+ *
+ * @note    Arcs are drawn by the circle and ellipse routines of bresenham.c
+ *          thru a context whose sinks keep only the points (and the parts of
+ *          the spans) inside the sector of the arc. So the mirroring of
+ *          mark.c and the scanline coalescing of the fill mode are reused.
+ *          The sector test uses only integer cross products.
+ *
+ * @note    A rotated ellipse is the conic a*x*x + b*x*y + c*y*y = f, with
+ *          integer coefficients. Since it is symmetric about the center, only
+ *          the upper half is traced, one row at a time, and each run is
+ *          mirrored thru the center. Two cursors follow the right and the
+ *          left crossings of the conic with the edges between the rows (the
+ *          value of the conic and its gradient are updated with additions
+ *          only). The points of a row are those between the crossings of its
+ *          two edges, so thin ellipses stay connected. In fill mode, the
+ *          rows go from the left to the right points.
+ *
+ * @note    Sines and cosines are computed with integers (CORDIC)
+ *
+ * @note    The decision terms of the rotated ellipses grow as r^4*ARC_SCALE^2.
+ *          LONG128 is used if available (radii up to ARC_ROTMAXR). Otherwise,
+ *          LONG64 limits the radii to a few hundred.
+ *
+ * @author  Hans
+ *
+ * @version 1.0
+ *
+ * @date    17/10/2026
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <limits.h>
+#include "arc.h"
+#include "bresenham.h"
+#include "mark.h"
+
+#ifdef LONG128
+#define ARCWIDE         LONG128
+#define ARC_ROTMAXR     (1<<22)
+#else
+#define ARCWIDE         LONG64
+#define ARC_ROTMAXR     200
+#endif
+
+#define ARC_INF         ((LONG64) 1<<40)    // Unbounded side of a span
+
+
+/**
+ * @brief   Arc tangent of 2^-i in 1/64 degree, scaled by 2^16
+ */
+static const LONG64 arcatan[] = {
+    188743680, 111421900, 58872272, 29884485, 15000234, 7507429, 3754631,
+    1877430, 938729, 469366, 234683, 117342, 58671, 29335, 14668, 7334, 3667,
+    1833, 917, 458, 229, 115, 57, 29
+};
+
+#define ARC_CORDICGAIN  652032874           // 2^30 times the CORDIC gain
+
+
+/**
+ * @brief   Cosine and sine of an angle (1/64 degree), scaled by ARC_SCALE
+ *
+ * @note    Multiples of 90 degrees are exact
+ */
+void ArcSinCos(INT angle, INT *c, INT *s) {
+LONG64 x,y,z,t;
+int neg = 0;
+
+    angle %= ARC_FULL;
+    if( angle < 0 ) angle += ARC_FULL;
+    if( angle % (90*ARC_DEGREE) == 0 ) {
+        switch( angle/(90*ARC_DEGREE) ) {
+        case 0: *c =  ARC_SCALE; *s = 0;           break;
+        case 1: *c = 0;          *s =  ARC_SCALE;  break;
+        case 2: *c = -ARC_SCALE; *s = 0;           break;
+        default:*c = 0;          *s = -ARC_SCALE;  break;
+        }
+        return;
+    }
+
+    // CORDIC converges in [-90,90] degrees
+    if( angle > 90*ARC_DEGREE && angle < 270*ARC_DEGREE ) {
+        angle -= 180*ARC_DEGREE;
+        neg = 1;
+    } else if( angle >= 270*ARC_DEGREE ) {
+        angle -= ARC_FULL;
+    }
+    x = ARC_CORDICGAIN;
+    y = 0;
+    z = (LONG64) angle << 16;
+    for(int i=0;i<(int) (sizeof(arcatan)/sizeof(arcatan[0]));i++) {
+        t = x;
+        if( z >= 0 ) {
+            x -= y >> i;
+            y += t >> i;
+            z -= arcatan[i];
+        } else {
+            x += y >> i;
+            y -= t >> i;
+            z += arcatan[i];
+        }
+    }
+    // From 2^30 to ARC_SCALE, rounded
+    x = (x + (1<<15)) >> 16;
+    y = (y + (1<<15)) >> 16;
+    *c = (INT) (neg ? -x : x);
+    *s = (INT) (neg ? -y : y);
+}
+
+
+/*
+ * @brief   Integer division rounding toward -infinity and +infinity
+ *
+ * @note    Divisor can be negative
+ */
+///@{
+static LONG64 arcfloordiv(LONG64 a, LONG64 b) {
+LONG64 q = a/b;
+
+    if( a%b != 0 && ((a < 0) != (b < 0)) ) q--;
+    return q;
+}
+
+static LONG64 arcceildiv(LONG64 a, LONG64 b) {
+LONG64 q = a/b;
+
+    if( a%b != 0 && ((a < 0) == (b < 0)) ) q++;
+    return q;
+}
+///@}
+
+
+/**
+ * @brief   Sector of an arc
+ *
+ * @note    Directions are scaled by ARC_SCALE, with y up. A point p is in the
+ *          sector when it is counterclockwise from s and clockwise from e
+ *          (both, or one of them if the sweep is larger than 180 degrees)
+ */
+typedef struct {
+    DrawContextType    *ctx;                // Context of the caller
+    INT                 xc,yc;
+    LONG64              sx,sy;              // Start direction
+    LONG64              ex,ey;              // End direction
+    int                 wide;               // Sweep larger than 180 degrees
+} ArcSectorType;
+
+
+/**
+ * @brief   Set the sector from a1 to a2
+ *
+ * @return  0 if the arc is the whole figure
+ */
+static int arcsector(ArcSectorType *sec, DrawContextType *ctx, INT xc, INT yc,
+                     INT a1, INT a2) {
+INT c,s,sweep;
+
+    sweep = (INT) (((LONG64) a2-a1) % ARC_FULL);
+    if( sweep < 0 ) sweep += ARC_FULL;
+    if( sweep == 0 ) return 0;
+
+    sec->ctx = ctx;
+    sec->xc = xc;
+    sec->yc = yc;
+    ArcSinCos(a1,&c,&s);
+    sec->sx = c;
+    sec->sy = s;
+    ArcSinCos(a2,&c,&s);
+    sec->ex = c;
+    sec->ey = s;
+    sec->wide = sweep > 180*ARC_DEGREE;
+    return 1;
+}
+
+
+/**
+ * @brief   Test a point (relative to the center, y down)
+ */
+static int arcinside(ArcSectorType *sec, LONG64 x, LONG64 y) {
+int cs,ce;
+
+    cs = sec->sx*(-y) - sec->sy*x >= 0;
+    ce = x*sec->ey - (-y)*sec->ex >= 0;
+    return sec->wide ? (cs || ce) : (cs && ce);
+}
+
+
+/**
+ * @brief   Part of a row where p*x <= q
+ */
+static void archalfplane(LONG64 p, LONG64 q, LONG64 *lo, LONG64 *hi) {
+
+    if( p > 0 ) {
+        *lo = -ARC_INF;
+        *hi = arcfloordiv(q,p);
+    } else if( p < 0 ) {
+        *lo = arcceildiv(q,p);
+        *hi = ARC_INF;
+    } else if( q >= 0 ) {
+        *lo = -ARC_INF;
+        *hi = ARC_INF;
+    } else {
+        *lo = 1;
+        *hi = 0;
+    }
+}
+
+
+/**
+ * @brief   Send the part of a span (relative to the center) inside the sector
+ *
+ * @note    The sector cuts a row in one piece (sweep up to 180 degrees) or two
+ *          pieces (larger sweeps)
+ */
+static void arcspan(ArcSectorType *sec, LONG64 x1, LONG64 x2, LONG64 y) {
+LONG64 lo1,hi1,lo2,hi2,a1,b1,a2,b2;
+
+    archalfplane(sec->sy,sec->sx*(-y),&lo1,&hi1);
+    archalfplane(-sec->ey,-sec->ex*(-y),&lo2,&hi2);
+
+    if( !sec->wide ) {
+        a1 = (x1 > lo1) ? x1 : lo1;
+        if( lo2 > a1 ) a1 = lo2;
+        b1 = (x2 < hi1) ? x2 : hi1;
+        if( hi2 < b1 ) b1 = hi2;
+        if( a1 <= b1 )
+            MARKHRUN(sec->ctx,(INT) (sec->xc+a1),(INT) (sec->xc+b1),(INT) (sec->yc+y));
+        return;
+    }
+
+    a1 = (x1 > lo1) ? x1 : lo1;
+    b1 = (x2 < hi1) ? x2 : hi1;
+    a2 = (x1 > lo2) ? x1 : lo2;
+    b2 = (x2 < hi2) ? x2 : hi2;
+    if( a1 > b1 ) {
+        a1 = a2;
+        b1 = b2;
+    } else if( a2 <= b2 ) {
+        if( a2 <= b1+1 && a1 <= b2+1 ) {
+            // Overlapping or adjacent. Merge them
+            if( a2 < a1 ) a1 = a2;
+            if( b2 > b1 ) b1 = b2;
+        } else {
+            MARKHRUN(sec->ctx,(INT) (sec->xc+a2),(INT) (sec->xc+b2),(INT) (sec->yc+y));
+        }
+    }
+    if( a1 <= b1 )
+        MARKHRUN(sec->ctx,(INT) (sec->xc+a1),(INT) (sec->xc+b1),(INT) (sec->yc+y));
+}
+
+
+/**
+ * @brief   Sinks of the context used to draw an arc. They forward to the
+ *          context of the caller what is inside the sector
+ *
+ * @note    The points and spans are already clipped
+ */
+///@{
+static void arcpointsink(DrawContextType *sub, INT x, INT y) {
+ArcSectorType *sec = (ArcSectorType *) sub->user;
+
+    if( arcinside(sec,(LONG64) x-sec->xc,(LONG64) y-sec->yc) )
+        MARKPOINTIN(sec->ctx,x,y);
+}
+
+static void archrunsink(DrawContextType *sub, INT x1, INT x2, INT y) {
+ArcSectorType *sec = (ArcSectorType *) sub->user;
+
+    arcspan(sec,(LONG64) x1-sec->xc,(LONG64) x2-sec->xc,(LONG64) y-sec->yc);
+}
+///@}
+
+
+/**
+ * @brief   Build the context used to draw an arc
+ *
+ * @note    The whole figure is walked by the copy, so a dash goes along it
+ *          and the arc shows its part. The phase is copied back after
+ */
+static void arccontext(DrawContextType *sub, ArcSectorType *sec) {
+
+    *sub = *sec->ctx;
+    sub->linemode = MARK_LINE_POINTS;
+    sub->point = arcpointsink;
+    sub->hrun = archrunsink;
+    sub->vrun = 0;
+    sub->user = sec;
+    sub->fillpending = 0;
+}
+
+
+/**
+ * @brief   Conic a*x*x + b*x*y + c*y*y - 4*f, with doubled coordinates (y down)
+ */
+typedef struct {
+    ARCWIDE     a,b,c,f;
+} ArcConicType;
+
+/**
+ * @brief   A cursor on the edge between two rows, following a crossing of the
+ *          conic
+ *
+ * @note    X and Y are doubled coordinates (both odd: pixel corners). p is the
+ *          value of the conic and (px,py) its gradient, updated incrementally.
+ */
+typedef struct {
+    INT         X,Y;
+    ARCWIDE     p,px,py;
+} ArcEdgeType;
+
+
+static void arcedge(ArcConicType *q, ArcEdgeType *e, INT X, INT Y) {
+
+    e->X = X;
+    e->Y = Y;
+    e->p = q->a*X*X + q->b*X*Y + q->c*Y*Y - 4*q->f;
+    e->px = 2*q->a*X + q->b*Y;
+    e->py = q->b*X + 2*q->c*Y;
+}
+
+
+/**
+ * @brief   Move the cursor by one pixel (two units of the doubled coordinates)
+ */
+///@{
+static void arcedgex(ArcConicType *q, ArcEdgeType *e, int d) {
+
+    e->p += 2*d*e->px + 4*q->a;
+    e->px += 4*d*q->a;
+    e->py += 2*d*q->b;
+    e->X += 2*d;
+}
+
+static void arcedgey(ArcConicType *q, ArcEdgeType *e, int d) {
+
+    e->p += 2*d*e->py + 4*q->c;
+    e->py += 4*d*q->c;
+    e->px += 2*d*q->b;
+    e->Y += 2*d;
+}
+///@}
+
+
+/**
+ * @brief   Nearest pixel to the right crossing of the edge
+ *
+ * @note    The cursor goes to the first corner right of the vertex of the row
+ *          that is outside (or on) the conic. Then the crossing is in the
+ *          pixel on its left. This works even if both crossings are between
+ *          two corners (thin ellipses).
+ */
+static INT arcright(ArcConicType *q, ArcEdgeType *e) {
+
+    if( e->px >= 0 && e->p >= 0 ) {
+        while( e->px-4*q->a >= 0 && e->p-2*e->px+4*q->a >= 0 )
+            arcedgex(q,e,-1);
+    } else {
+        while( !(e->px >= 0 && e->p >= 0) )
+            arcedgex(q,e,1);
+    }
+    return (e->X-1)/2;
+}
+
+
+/**
+ * @brief   Nearest pixel to the left crossing of the edge
+ */
+static INT arcleft(ArcConicType *q, ArcEdgeType *e) {
+
+    if( e->px <= 0 && e->p >= 0 ) {
+        while( e->px+4*q->a <= 0 && e->p+2*e->px+4*q->a >= 0 )
+            arcedgex(q,e,1);
+    } else {
+        while( !(e->px <= 0 && e->p >= 0) )
+            arcedgex(q,e,-1);
+    }
+    return (e->X+1)/2;
+}
+
+
+/**
+ * @brief   Pixels of a row between the crossings of its top edge (t, already
+ *          in the row above) and its bottom edge (b)
+ */
+static void arcbetween(INT t, INT b, INT *x1, INT *x2) {
+
+    if( t < b ) {
+        *x1 = t+1;
+        *x2 = b;
+    } else if( t > b ) {
+        *x1 = b;
+        *x2 = t-1;
+    } else {
+        *x1 = *x2 = b;
+    }
+}
+
+
+/**
+ * @brief   Plot a run (relative to the center), clipped
+ */
+static void arcpoints(DrawContextType *ctx, MarkClipType *clip, int inside,
+                      INT xc, INT yc, INT x1, INT x2, INT y) {
+INT py;
+
+    py = yc+y;
+    if( !inside && (py < clip->ymin || py > clip->ymax) ) return;
+    for(INT x=x1;x<=x2;x++) {
+        if( inside || (xc+x >= clip->xmin && xc+x <= clip->xmax) )
+            MARKPOINTIN(ctx,xc+x,py);
+    }
+}
+
+
+/**
+ * @brief   Fill a row (relative to the center), clipped
+ */
+static void arcrow(DrawContextType *ctx, MarkClipType *clip,
+                   INT xc, INT yc, INT x1, INT x2, INT y) {
+INT px1,px2,py;
+
+    py = yc+y;
+    if( py < clip->ymin || py > clip->ymax ) return;
+    px1 = xc+x1;
+    px2 = xc+x2;
+    if( px1 > clip->xmax || px2 < clip->xmin ) return;
+    if( px1 < clip->xmin ) px1 = clip->xmin;
+    if( px2 > clip->xmax ) px2 = clip->xmax;
+    MARKHRUN(ctx,px1,px2,py);
+}
+
+
+/**
+ * @brief   Integer square root (floor)
+ */
+static ARCWIDE arcisqrt(ARCWIDE n) {
+ARCWIDE r = 0, bit;
+
+    if( n <= 0 ) return 0;
+    bit = (ARCWIDE) 1 << (sizeof(ARCWIDE)*8-2);
+    while( bit > n ) bit >>= 2;
+    while( bit != 0 ) {
+        if( n >= r+bit ) {
+            n -= r+bit;
+            r = (r>>1)+bit;
+        } else {
+            r >>= 1;
+        }
+        bit >>= 2;
+    }
+    return r;
+}
+
+
+/**
+ * @brief   Round n/ARC_SCALE to the nearest integer
+ */
+static INT arcscale(LONG64 n) {
+
+    return (INT) ((n >= 0) ? (n+ARC_SCALE/2)/ARC_SCALE : -((-n+ARC_SCALE/2)/ARC_SCALE));
+}
+
+
+/**
+ * @brief   Draw an ellipse rotated by angle (1/64 degree, counterclockwise)
+ *
+ * @note    Ellipses with a zero radius are drawn as lines
+ *
+ * @note    In fill mode, each row is sent once
+ */
+void drawellipserotctx(DrawContextType *ctx, INT xc, INT yc, INT rx, INT ry,
+                       INT angle) {
+ArcConicType q;
+ArcEdgeType re,le;
+MarkClipType clip;
+MarkClipResultType cr;
+ARCWIDE rx2,ry2,n,t;
+INT c,s,bx,by,x0,xe,ye,y;
+INT rt,rb,lt,lb,r1,r2,l1,l2;
+int top,inside;
+
+    if( rx < 0 || ry < 0 ) return;
+    if( rx > ARC_ROTMAXR || ry > ARC_ROTMAXR ) return;
+    ArcSinCos(angle,&c,&s);
+
+    // Segments
+    if( rx == 0 || ry == 0 ) {
+        if( MarkEllipseRange(xc,yc,rx > ry ? rx : ry,rx > ry ? rx : ry) == MARK_RANGE_NONE )
+            return;
+        if( ry == 0 ) {
+            bx = arcscale((LONG64) rx*c);
+            by = -arcscale((LONG64) rx*s);
+        } else {
+            bx = -arcscale((LONG64) ry*s);
+            by = -arcscale((LONG64) ry*c);
+        }
+        drawlinebctx(ctx,xc-bx,yc-by,xc+bx,yc+by);
+        return;
+    }
+
+    // Coefficients. With u = c*x-s*y and v = -s*x-c*y (axes of the ellipse),
+    // ry2*u*u + rx2*v*v = rx2*ry2*(c*c+s*s)
+    rx2 = (ARCWIDE) rx*rx;
+    ry2 = (ARCWIDE) ry*ry;
+    n = (ARCWIDE) c*c + (ARCWIDE) s*s;
+    q.a = ry2*c*c + rx2*s*s;
+    q.c = ry2*s*s + rx2*c*c;
+    q.b = 2*(rx2-ry2)*c*s;
+    q.f = rx2*ry2*n;
+
+    // Bounding box (half sizes sqrt(c/n) and sqrt(a/n))
+    bx = (INT) arcisqrt(q.c/n)+1;
+    by = (INT) arcisqrt(q.a/n)+1;
+    if( MarkEllipseRange(xc,yc,bx,by) == MARK_RANGE_NONE ) return;
+    if( !MarkGetClip(ctx,&clip) ) return;
+    cr = MarkClipBox(ctx,xc-bx,yc-by,xc+bx,yc+by);
+    if( cr == MARK_OUTSIDE ) return;
+    inside = cr == MARK_INSIDE;
+
+    // Rightmost point: xe = sqrt(c/n) rounded, in the row -b*xe/(2*c) rounded.
+    // The leftmost point is its mirror
+    xe = (INT) arcisqrt(q.c/n);
+    t = (ARCWIDE) (2*xe+1)*(2*xe+1);
+    if( t*n <= 4*q.c ) xe++;
+    t = arcisqrt(q.c*n);
+    ye = (INT) (((q.b < 0 ? -q.b : q.b) + t)/(2*t));
+    if( q.b > 0 ) ye = -ye;
+
+    // The cursors start near the crossings of the x axis, at the bottom edge
+    // of the row 0
+    x0 = (INT) arcisqrt(q.f/q.a);
+    arcedge(&q,&re,2*x0+1,1);
+    arcedge(&q,&le,-2*x0-1,1);
+    rb = arcright(&q,&re);
+    lb = arcleft(&q,&le);
+    rt = rb;
+    lt = lb;
+
+    for(y=0;;y--) {
+        // Top edge of the row. There is no crossing above the top
+        arcedgey(&q,&re,-1);
+        arcedgey(&q,&le,-1);
+        top = (ARCWIDE) re.Y*re.Y*n > 4*q.a;
+        if( top ) {
+            // The cap: the whole chord of the bottom edge
+            l1 = r1 = lb;
+            l2 = r2 = rb;
+        } else {
+            rt = arcright(&q,&re);
+            lt = arcleft(&q,&le);
+            arcbetween(rt,rb,&r1,&r2);
+            arcbetween(lt,lb,&l1,&l2);
+        }
+        if( y == ye && xe > r2 ) r2 = xe;
+        if( y == -ye && -xe < l1 ) l1 = -xe;
+
+        if( y == 0 ) {
+            // The left side is the mirror of the right one
+            if( r1 <= 0 ) {
+                if( -r1 > r2 ) r2 = -r1;
+                if( ctx->drawmode == MARK_FILL )
+                    arcrow(ctx,&clip,xc,yc,-r2,r2,0);
+                else
+                    arcpoints(ctx,&clip,inside,xc,yc,-r2,r2,0);
+            } else {
+                if( ctx->drawmode == MARK_FILL ) {
+                    arcrow(ctx,&clip,xc,yc,-r2,r2,0);
+                } else {
+                    arcpoints(ctx,&clip,inside,xc,yc,r1,r2,0);
+                    arcpoints(ctx,&clip,inside,xc,yc,-r2,-r1,0);
+                }
+            }
+        } else if( ctx->drawmode == MARK_FILL ) {
+            if( r1 < l1 ) l1 = r1;
+            if( l2 > r2 ) r2 = l2;
+            arcrow(ctx,&clip,xc,yc,l1,r2,y);
+            arcrow(ctx,&clip,xc,yc,-r2,-l1,-y);
+        } else if( l1 <= r2+1 && r1 <= l2+1 ) {
+            // The sides meet. Each point once
+            if( r1 < l1 ) l1 = r1;
+            if( l2 > r2 ) r2 = l2;
+            arcpoints(ctx,&clip,inside,xc,yc,l1,r2,y);
+            arcpoints(ctx,&clip,inside,xc,yc,-r2,-l1,-y);
+        } else {
+            arcpoints(ctx,&clip,inside,xc,yc,r1,r2,y);
+            arcpoints(ctx,&clip,inside,xc,yc,l1,l2,y);
+            arcpoints(ctx,&clip,inside,xc,yc,-r2,-r1,-y);
+            arcpoints(ctx,&clip,inside,xc,yc,-l2,-l1,-y);
+        }
+        if( top ) break;
+        rb = rt;
+        lb = lt;
+    }
+}
+
+
+/**
+ * @brief   Draw an arc of a circle
+ *
+ * @note    In fill mode, a pie slice is drawn
+ */
+void drawarcctx(DrawContextType *ctx, INT xc, INT yc, INT r, INT a1, INT a2) {
+ArcSectorType sec;
+DrawContextType sub;
+
+    if( !arcsector(&sec,ctx,xc,yc,a1,a2) ) {
+        drawcirclebctx(ctx,xc,yc,r);
+        return;
+    }
+    arccontext(&sub,&sec);
+    drawcirclebctx(&sub,xc,yc,r);
+    ctx->patternphase = sub.patternphase;
+}
+
+
+/**
+ * @brief   Draw an arc of an ellipse (axes horizontal and vertical)
+ *
+ * @note    The angles are those of the points, not the parametric ones
+ */
+void drawellipsearcctx(DrawContextType *ctx, INT xc, INT yc, INT rx, INT ry,
+                       INT a1, INT a2) {
+ArcSectorType sec;
+DrawContextType sub;
+
+    if( !arcsector(&sec,ctx,xc,yc,a1,a2) ) {
+        drawellipsebctx(ctx,xc,yc,rx,ry);
+        return;
+    }
+    arccontext(&sub,&sec);
+    drawellipsebctx(&sub,xc,yc,rx,ry);
+    ctx->patternphase = sub.patternphase;
+}
+
+
+/**
+ * @brief   Draw an arc of a rotated ellipse
+ *
+ * @note    The angles of the arc are measured from the x axis of the screen,
+ *          not from the axes of the ellipse
+ */
+void drawellipserotarcctx(DrawContextType *ctx, INT xc, INT yc, INT rx, INT ry,
+                          INT angle, INT a1, INT a2) {
+ArcSectorType sec;
+DrawContextType sub;
+
+    if( !arcsector(&sec,ctx,xc,yc,a1,a2) ) {
+        drawellipserotctx(ctx,xc,yc,rx,ry,angle);
+        return;
+    }
+    arccontext(&sub,&sec);
+    drawellipserotctx(&sub,xc,yc,rx,ry,angle);
+    ctx->patternphase = sub.patternphase;
+}
+
+
+/**
+ * @brief   Old interface. Draw on markscreen using the global variables
+ *
+ * @note    A context is built from them at each call (see MarkGlobalContext)
+ */
+///@{
+void drawarc(INT xc, INT yc, INT r, INT a1, INT a2) {
+DrawContextType ctx;
+
+    MarkGlobalContext(&ctx);
+    drawarcctx(&ctx,xc,yc,r,a1,a2);
+}
+
+void drawellipsearc(INT xc, INT yc, INT rx, INT ry, INT a1, INT a2) {
+DrawContextType ctx;
+
+    MarkGlobalContext(&ctx);
+    drawellipsearcctx(&ctx,xc,yc,rx,ry,a1,a2);
+}
+
+void drawellipserot(INT xc, INT yc, INT rx, INT ry, INT angle) {
+DrawContextType ctx;
+
+    MarkGlobalContext(&ctx);
+    drawellipserotctx(&ctx,xc,yc,rx,ry,angle);
+}
+
+void drawellipserotarc(INT xc, INT yc, INT rx, INT ry, INT angle, INT a1, INT a2) {
+DrawContextType ctx;
+
+    MarkGlobalContext(&ctx);
+    drawellipserotarcctx(&ctx,xc,yc,rx,ry,angle,a1,a2);
+}
+///@}
@@ -0,0 +1,46 @@
+#ifndef ARC_H
+#define ARC_H
+/**
+ * @file    arc.h
+ * @brief   Arcs of circles and ellipses and rotated ellipses
+ *
+ * @note    Angles are in 1/64 degree (as in X11), counterclockwise on the
+ *          screen from the positive x axis. The arc goes counterclockwise
+ *          from a1 to a2. If a1 == a2 (modulo 360 degrees), the whole figure
+ *          is drawn. In fill mode, a pie slice is drawn.
+ *
+ * @version 1.0
+ * Date:    17/10/2026
+ *
+ */
+
+#ifndef INT
+#define INT     int
+#endif
+
+#ifndef LONG
+#define LONG    long
+#endif
+
+#include "mark.h"
+
+#define ARC_DEGREE      64
+#define ARC_FULL        (360*ARC_DEGREE)
+#define ARC_SCALE       (1<<14)         // Scale of the results of ArcSinCos
+
+void drawarc(INT xc, INT yc, INT r, INT a1, INT a2);
+void drawellipsearc(INT xc, INT yc, INT rx, INT ry, INT a1, INT a2);
+void drawellipserot(INT xc, INT yc, INT rx, INT ry, INT angle);
+void drawellipserotarc(INT xc, INT yc, INT rx, INT ry, INT angle, INT a1, INT a2);
+
+void drawarcctx(DrawContextType *ctx, INT xc, INT yc, INT r, INT a1, INT a2);
+void drawellipsearcctx(DrawContextType *ctx, INT xc, INT yc, INT rx, INT ry,
+                       INT a1, INT a2);
+void drawellipserotctx(DrawContextType *ctx, INT xc, INT yc, INT rx, INT ry,
+                       INT angle);
+void drawellipserotarcctx(DrawContextType *ctx, INT xc, INT yc, INT rx, INT ry,
+                          INT angle, INT a1, INT a2);
+
+void ArcSinCos(INT angle, INT *c, INT *s);
+
+#endif // ARC_H
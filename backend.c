@@ -0,0 +1,166 @@
+/**
+ * @file    backend.c
+ *
+ * @brief   Registry of drawing backends
+ *
+ * @note    The Bresenham, midpoint and Wu (antialiased) families are built
+ *          in. Other families (e.g., using SIMD instructions) can be added
+ *          with DrawBackendRegister, with a supported function that checks
+ *          the CPU (see DrawBackendCPUHas).
+ *
+ * @note    A program can pick a family by name or let the registry choose
+ *          the best one supported by the host
+ *
+ * @note    Registration is not thread safe. Register before starting threads
+ *
+ * @author  Hans
+ *
+ * @version 1.0
+ *
+ * @date    17/10/2026
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "backend.h"
+#include "bresenham.h"
+#include "midpoint.h"
+#include "wu.h"
+
+
+/**
+ * @brief   Built in families
+ *
+ * @note    Bresenham is the default. Both aliased families have about the
+ *          same throughput (see bench), but the Bresenham one has the batch
+ *          routines and the direct bitmap loops
+ */
+static const DrawBackendType backendbresenham = {
+    "bresenham", drawlinebctx, drawcirclebctx, drawellipsebctx, 0, 20, 0
+};
+
+static const DrawBackendType backendmidpoint = {
+    "midpoint",  drawlinemctx, drawcirclemctx, drawellipsemctx, 0, 10, 0
+};
+
+static const DrawBackendType backendwu = {
+    "wu",        drawlinewctx, drawcirclewctx, drawellipsewctx, 0, 0,  1
+};
+
+static const DrawBackendType *backends[DRAWBACKEND_MAX] = {
+    &backendbresenham, &backendmidpoint, &backendwu
+};
+static int nbackends = 3;
+
+
+/**
+ * @brief   Add a family to the registry
+ *
+ * @note    A family with the name of a registered one replaces it
+ *
+ * @return  0 if the registry is full
+ */
+int DrawBackendRegister(const DrawBackendType *backend) {
+
+    if( !backend || !backend->name ) return 0;
+    for(int i=0;i<nbackends;i++) {
+        if( strcmp(backends[i]->name,backend->name) == 0 ) {
+            backends[i] = backend;
+            return 1;
+        }
+    }
+    if( nbackends == DRAWBACKEND_MAX ) return 0;
+    backends[nbackends++] = backend;
+    return 1;
+}
+
+
+/**
+ * @brief   Registered families, in registration order
+ */
+///@{
+int DrawBackendCount(void) {
+
+    return nbackends;
+}
+
+const DrawBackendType *DrawBackendGet(int i) {
+
+    if( i < 0 || i >= nbackends ) return 0;
+    return backends[i];
+}
+///@}
+
+
+/**
+ * @brief   Check if the host supports a family
+ */
+static int DrawBackendSupported(const DrawBackendType *backend) {
+
+    return !backend->supported || backend->supported();
+}
+
+
+/**
+ * @brief   Find a supported family by name
+ *
+ * @return  NULL if not found or not supported
+ */
+const DrawBackendType *DrawBackendFind(const char *name) {
+
+    if( !name ) return 0;
+    for(int i=0;i<nbackends;i++) {
+        if( strcmp(backends[i]->name,name) == 0 )
+            return DrawBackendSupported(backends[i]) ? backends[i] : 0;
+    }
+    return 0;
+}
+
+
+/**
+ * @brief   Supported family with the highest priority
+ */
+const DrawBackendType *DrawBackendBest(void) {
+const DrawBackendType *best = 0;
+
+    for(int i=0;i<nbackends;i++) {
+        if( backends[i]->priority <= 0 ) continue;
+        if( !DrawBackendSupported(backends[i]) ) continue;
+        if( !best || backends[i]->priority > best->priority )
+            best = backends[i];
+    }
+    return best;
+}
+
+
+/**
+ * @brief   Select a family by name. NULL or "auto" selects the best one
+ *
+ * @return  NULL if not found or not supported
+ */
+const DrawBackendType *DrawBackendSelect(const char *name) {
+
+    if( !name || strcmp(name,"auto") == 0 )
+        return DrawBackendBest();
+    return DrawBackendFind(name);
+}
+
+
+/**
+ * @brief   Check a CPU feature (e.g., "sse2", "avx2")
+ *
+ * @note    Only on x86 with GCC or clang. Elsewhere, always 0
+ */
+int DrawBackendCPUHas(const char *feature) {
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+    __builtin_cpu_init();
+    if( strcmp(feature,"sse2") == 0 )    return __builtin_cpu_supports("sse2");
+    if( strcmp(feature,"sse4.1") == 0 )  return __builtin_cpu_supports("sse4.1");
+    if( strcmp(feature,"avx") == 0 )     return __builtin_cpu_supports("avx");
+    if( strcmp(feature,"avx2") == 0 )    return __builtin_cpu_supports("avx2");
+    if( strcmp(feature,"avx512f") == 0 ) return __builtin_cpu_supports("avx512f");
+#endif
+    return 0;
+}
@@ -0,0 +1,54 @@
+#ifndef BACKEND_H
+#define BACKEND_H
+/**
+ * @file    backend.h
+ * @brief   Registry of drawing backends (families of line, circle and
+ *          ellipse routines)
+ *
+ * @version 1.0
+ * Date:    17/10/2026
+ *
+ */
+
+#ifndef INT
+#define INT     int
+#endif
+
+#ifndef LONG
+#define LONG    long
+#endif
+
+#include "mark.h"
+
+/**
+ * @brief  A family of drawing routines
+ *
+ * @note   supported is called to check if the CPU can run the family. When
+ *         NULL, it runs everywhere
+ *
+ * @note   When selecting automatically, the supported family with the
+ *         highest priority is used. Families with priority 0 (e.g., the
+ *         antialiased ones, which need a gray level screen) are only used
+ *         when selected by name
+ */
+typedef struct {
+    const char *name;
+    void (*line)(DrawContextType *ctx, INT x1, INT y1, INT x2, INT y2);
+    void (*circle)(DrawContextType *ctx, INT xc, INT yc, INT r);
+    void (*ellipse)(DrawContextType *ctx, INT xc, INT yc, INT rx, INT ry);
+    int  (*supported)(void);
+    int         priority;
+    int         antialiased;        // Draws thru the blend sink
+} DrawBackendType;
+
+#define DRAWBACKEND_MAX     16
+
+int  DrawBackendRegister(const DrawBackendType *backend);
+int  DrawBackendCount(void);
+const DrawBackendType *DrawBackendGet(int i);
+const DrawBackendType *DrawBackendFind(const char *name);
+const DrawBackendType *DrawBackendBest(void);
+const DrawBackendType *DrawBackendSelect(const char *name);
+int  DrawBackendCPUHas(const char *feature);
+
+#endif // BACKEND_H
@@ -0,0 +1,740 @@
+/**
+ * @file    bench.c
+ *
+ * @brief   Throughput benchmark of the drawing routines
+ *
+ * @note    Each test draws a random workload many times and reports, as CSV,
+ *          the time per call and per pixel. The pixels are counted in a
+ *          separate pass with counting sinks, so the timed passes use the
+ *          default sinks and there is no overhead.
+ *
+ * @note    The backends of the registry are run in the same process. The
+ *          aliased ones (Bresenham, midpoint) are compared with lines in
+ *          each octant (short and long), circles and ellipses from tiny to
+ *          huge radii (huge ones are clipped), in contour and fill modes.
+ *          Then, the antialiased routines are compared with the aliased ones.
+ *          Then, the Bresenham routines with callback sinks are compared
+ *          with the loops of drawloop.h inlined for the same sinks.
+ *
+ * @note    At last, a second CSV table compares the mirror and path orders
+ *          of circles and ellipses (MARK_ORDER_MIRROR and MARK_ORDER_PATH)
+ *          on big canvases: time per pixel, row changes per pixel (the rows
+ *          of a PBM screen are far apart in memory) and, on Linux when
+ *          allowed, hardware cache misses per pixel (-1 if not available).
+ *
+ * @note    Usage: bench [shapes [seed]]
+ *
+ * @note    The optimization level is the one in CFLAGS. Use, for example,
+ *          make CFLAGS=-O2 bench
+ *
+ * @author  Hans
+ *
+ * @version 1.3
+ *
+ * @date    17/10/2026
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+#include "screen.h"
+#include "mark.h"
+#include "backend.h"
+#include "bresenham.h"
+#include "drawloop.h"
+
+#define BENCH_WIDTH         1024
+#define BENCH_HEIGHT        1024
+#define BENCH_SHAPES        1000
+#define BENCH_MINTIME       0.1         // seconds for each test
+#define BENCH_BIGPBM        16384       // Side of the big canvases (32 MB)
+#define BENCH_BIGPGM        8192        //  (64 MB)
+#define BENCH_BIGSHAPES     16
+
+
+/**
+ * @brief   Parameters of a shape, as in the draw routines
+ */
+typedef struct {
+    INT     a,b,c,d;
+} BenchShapeType;
+
+typedef enum { BENCH_LINE, BENCH_CIRCLE, BENCH_ELLIPSE } BenchFigureType;
+
+static const char *benchfigurenames[] = { "line", "circle", "ellipse" };
+
+/**
+ * @brief   A test: a backend, a figure, the screen format and the draw mode
+ */
+typedef struct {
+    BenchFigureType         figure;
+    const char             *workload;
+    const DrawBackendType  *backend;
+    ImageFormatType         fmt;
+    MarkDrawModeType        drawmode;
+    BenchShapeType         *shapes;
+} BenchTestType;
+
+
+/**
+ * @brief   Draw a shape with the backend of a test
+ */
+static void benchdraw(BenchTestType *t, DrawContextType *ctx, BenchShapeType *s) {
+
+    switch(t->figure) {
+    case BENCH_LINE:    t->backend->line(ctx,s->a,s->b,s->c,s->d);    break;
+    case BENCH_CIRCLE:  t->backend->circle(ctx,s->a,s->b,s->c);       break;
+    case BENCH_ELLIPSE: t->backend->ellipse(ctx,s->a,s->b,s->c,s->d); break;
+    }
+}
+
+
+/**
+ * @brief   Counting sinks. The counter is in the user field of the context
+ */
+///@{
+static void countpoint(DrawContextType *ctx, INT x, INT y) {
+    (*(unsigned long *) ctx->user)++;
+}
+static void counthrun(DrawContextType *ctx, INT x1, INT x2, INT y) {
+    (*(unsigned long *) ctx->user) += (x1<x2?x2-x1:x1-x2)+1;
+}
+static void countvrun(DrawContextType *ctx, INT x, INT y1, INT y2) {
+    (*(unsigned long *) ctx->user) += (y1<y2?y2-y1:y1-y2)+1;
+}
+static void countblend(DrawContextType *ctx, INT x, INT y, INT alpha) {
+    (*(unsigned long *) ctx->user)++;
+}
+///@}
+
+
+/**
+ * @brief   Random integer in [lo,hi]
+ */
+static INT benchrand(INT lo, INT hi) {
+
+    return lo+(INT) (rand()%(hi-lo+1));
+}
+
+
+/**
+ * @brief   Random workloads inside the screen
+ */
+///@{
+static void benchlines(BenchShapeType *s, int n) {
+
+    for(int i=0;i<n;i++) {
+        s[i].a = benchrand(0,BENCH_WIDTH-1);
+        s[i].b = benchrand(0,BENCH_HEIGHT-1);
+        s[i].c = benchrand(0,BENCH_WIDTH-1);
+        s[i].d = benchrand(0,BENCH_HEIGHT-1);
+    }
+}
+
+static void benchcircles(BenchShapeType *s, int n) {
+
+    for(int i=0;i<n;i++) {
+        s[i].c = benchrand(1,BENCH_WIDTH/4);
+        s[i].a = benchrand(s[i].c,BENCH_WIDTH-1-s[i].c);
+        s[i].b = benchrand(s[i].c,BENCH_HEIGHT-1-s[i].c);
+        s[i].d = s[i].c;
+    }
+}
+
+static void benchellipses(BenchShapeType *s, int n) {
+
+    for(int i=0;i<n;i++) {
+        s[i].c = benchrand(1,BENCH_WIDTH/4);
+        s[i].d = benchrand(1,BENCH_HEIGHT/4);
+        s[i].a = benchrand(s[i].c,BENCH_WIDTH-1-s[i].c);
+        s[i].b = benchrand(s[i].d,BENCH_HEIGHT-1-s[i].d);
+    }
+}
+///@}
+
+
+/**
+ * @brief   Lines in one octant with the major length in [lo,hi]
+ *
+ * @note    Octants as in the README: octants 0, 3, 4 and 7 are x major, the
+ *          sign of x is negative in octants 2 to 5 and the one of y in 4 to 7.
+ *          Lines are inside the screen
+ */
+static void benchlinesoct(BenchShapeType *s, int n, int oct, INT lo, INT hi) {
+INT major,minor,dx,dy;
+int xmajor = (oct == 0 || oct == 3 || oct == 4 || oct == 7);
+
+    for(int i=0;i<n;i++) {
+        major = benchrand(lo,hi);
+        minor = benchrand(0,major-1);
+        dx = xmajor ? major : minor;
+        dy = xmajor ? minor : major;
+        if( oct >= 2 && oct <= 5 ) dx = -dx;
+        if( oct >= 4 ) dy = -dy;
+        s[i].a = benchrand(dx<0?-dx:0,BENCH_WIDTH-1-(dx>0?dx:0));
+        s[i].b = benchrand(dy<0?-dy:0,BENCH_HEIGHT-1-(dy>0?dy:0));
+        s[i].c = s[i].a+dx;
+        s[i].d = s[i].b+dy;
+    }
+}
+
+
+/**
+ * @brief   Circles (rx == ry) or ellipses with radii in [lo,hi]
+ *
+ * @note    When the figure fits, it is inside the screen. If not, the center
+ *          is in the screen and the figure is clipped
+ */
+static void benchcurves(BenchShapeType *s, int n, int circle, INT lo, INT hi) {
+
+    for(int i=0;i<n;i++) {
+        s[i].c = benchrand(lo,hi);
+        s[i].d = circle ? s[i].c : benchrand(lo,hi);
+        if( 2*s[i].c < BENCH_WIDTH && 2*s[i].d < BENCH_HEIGHT ) {
+            s[i].a = benchrand(s[i].c,BENCH_WIDTH-1-s[i].c);
+            s[i].b = benchrand(s[i].d,BENCH_HEIGHT-1-s[i].d);
+        } else {
+            s[i].a = benchrand(0,BENCH_WIDTH-1);
+            s[i].b = benchrand(0,BENCH_HEIGHT-1);
+        }
+    }
+}
+
+
+/**
+ * @brief   Elapsed time in seconds
+ */
+static double benchtime(struct timespec *t0) {
+struct timespec t1;
+
+    clock_gettime(CLOCK_MONOTONIC,&t1);
+    return (t1.tv_sec-t0->tv_sec)+(t1.tv_nsec-t0->tv_nsec)*1e-9;
+}
+
+
+/**
+ * @brief   Print a CSV line
+ */
+static void benchprint(BenchFigureType figure, const char *workload, const char *algorithm,
+                       ImageFormatType fmt, MarkDrawModeType drawmode,
+                       unsigned long calls, unsigned long pixels, double secs) {
+
+    printf("%s,%s,%s,%s,%s,%lu,%lu,%.3f,%.3f,%.0f,%.0f\n",
+           benchfigurenames[figure],workload,algorithm,
+           fmt==PBM?"pbm":fmt==PGM?"pgm":"ppm",
+           drawmode==MARK_FILL?"fill":"contour",
+           calls,pixels,
+           secs*1e9/calls,pixels?secs*1e9/pixels:0.0,
+           pixels/secs,calls/secs);
+}
+
+
+/**
+ * @brief   Run a test and print a CSV line
+ */
+static void benchrun(BenchTestType *t, int n) {
+ScreenType *screen;
+DrawContextType ctx;
+struct timespec t0;
+unsigned long pixels,passes;
+double secs;
+
+    screen = ScreenCreateFormat(BENCH_WIDTH,BENCH_HEIGHT,t->fmt);
+    if( !screen ) return;
+
+    // Count the pixels of a pass
+    pixels = 0;
+    MarkContextInit(&ctx,screen);
+    ctx.drawmode = t->drawmode;
+    ctx.point = countpoint;
+    ctx.hrun = counthrun;
+    ctx.vrun = countvrun;
+    ctx.blend = countblend;
+    ctx.user = &pixels;
+    for(int i=0;i<n;i++)
+        benchdraw(t,&ctx,&(t->shapes[i]));
+
+    // Timed passes
+    MarkContextInit(&ctx,screen);
+    ctx.drawmode = t->drawmode;
+    passes = 0;
+    clock_gettime(CLOCK_MONOTONIC,&t0);
+    do {
+        for(int i=0;i<n;i++)
+            benchdraw(t,&ctx,&(t->shapes[i]));
+        passes++;
+        secs = benchtime(&t0);
+    } while( secs < BENCH_MINTIME );
+
+    benchprint(t->figure,t->workload,t->backend->name,t->fmt,t->drawmode,
+               passes*n,pixels*passes,secs);
+
+    ScreenDestroy(screen);
+}
+
+
+/**
+ * @brief   Workloads of the comparison between the families
+ */
+///@{
+static const struct {
+    const char *name;
+    INT         lo,hi;
+} benchlinelengths[] = {
+    { "short", 1,   16  },
+    { "long",  256, 768 },
+};
+
+static const struct {
+    const char *name;
+    INT         lo,hi;
+} benchradii[] = {
+    { "tiny",   1,   4    },
+    { "small",  5,   32   },
+    { "medium", 33,  256  },
+    { "huge",   257, 4096 },
+};
+///@}
+
+
+/**
+ * @brief   Run a test with each aliased backend
+ */
+static void benchbackends(BenchTestType *t, int n) {
+
+    for(int i=0;i<DrawBackendCount();i++) {
+        t->backend = DrawBackendGet(i);
+        if( t->backend->antialiased ) continue;
+        if( t->backend->supported && !t->backend->supported() ) continue;
+        benchrun(t,n);
+    }
+}
+
+
+/**
+ * @brief   Compare the aliased backends (Bresenham, midpoint, ...) for lines
+ *          in each octant and circles and ellipses of each size, in contour
+ *          and fill modes
+ */
+static void benchfamilies(BenchShapeType *shapes, int n) {
+char workload[32];
+BenchTestType t;
+
+    t.fmt = PBM;
+    t.shapes = shapes;
+    t.workload = workload;
+
+    t.figure = BENCH_LINE;
+    t.drawmode = MARK_CONTOUR;
+    for(unsigned l=0;l<sizeof(benchlinelengths)/sizeof(benchlinelengths[0]);l++) {
+        for(int oct=0;oct<8;oct++) {
+            snprintf(workload,sizeof(workload),"%s-oct%d",benchlinelengths[l].name,oct);
+            benchlinesoct(shapes,n,oct,benchlinelengths[l].lo,benchlinelengths[l].hi);
+            benchbackends(&t,n);
+        }
+    }
+
+    for(int circle=1;circle>=0;circle--) {
+        t.figure = circle ? BENCH_CIRCLE : BENCH_ELLIPSE;
+        for(unsigned r=0;r<sizeof(benchradii)/sizeof(benchradii[0]);r++) {
+            t.workload = benchradii[r].name;
+            benchcurves(shapes,n,circle,benchradii[r].lo,benchradii[r].hi);
+            for(int mode=0;mode<2;mode++) {
+                t.drawmode = mode ? MARK_FILL : MARK_CONTOUR;
+                benchbackends(&t,n);
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief   Compare the antialiased backends with the best aliased one, on
+ *          PBM (production) and PGM (same target as antialiased) screens
+ */
+static void benchantialiased(BenchShapeType **shapes, int n) {
+BenchTestType t;
+
+    t.workload = "random";
+    t.drawmode = MARK_CONTOUR;
+    for(int f=BENCH_LINE;f<=BENCH_ELLIPSE;f++) {
+        t.figure = (BenchFigureType) f;
+        t.shapes = shapes[f];
+        t.backend = DrawBackendBest();
+        t.fmt = PBM;
+        benchrun(&t,n);
+        t.fmt = PGM;
+        benchrun(&t,n);
+        for(int i=0;i<DrawBackendCount();i++) {
+            t.backend = DrawBackendGet(i);
+            if( !t.backend->antialiased ) continue;
+            if( t.backend->supported && !t.backend->supported() ) continue;
+            benchrun(&t,n);
+        }
+    }
+}
+
+
+/**
+ * @brief   Sinks of the comparison between callbacks and inlined loops
+ */
+typedef enum { BENCH_SINK_BITMAP, BENCH_SINK_COUNT, BENCH_SINK_SPANS } BenchSinkType;
+
+static const char *benchsinknames[] = { "sink-bitmap", "sink-count", "sink-spans" };
+
+#define BENCH_SPANS         65536
+
+typedef struct {
+    BenchSinkType       sink;
+    ScreenType         *screen;
+    unsigned long       count;
+    DrawSpanListType    spans;
+} BenchSinkStateType;
+
+
+/**
+ * @brief   Callback sinks for the same targets as the inlined loops
+ */
+///@{
+static void bitmappoint(DrawContextType *ctx, INT x, INT y) {
+    ScreenDrawPoint(ctx->screen,x,y);
+}
+static void spanspoint(DrawContextType *ctx, INT x, INT y) {
+    DrawSpanAddPoint(&(((BenchSinkStateType *) ctx->user)->spans),x,y);
+}
+static void spanshrun(DrawContextType *ctx, INT x1, INT x2, INT y) {
+    DrawSpanAdd(&(((BenchSinkStateType *) ctx->user)->spans),x1<x2?x1:x2,x1<x2?x2:x1,y);
+}
+///@}
+
+
+/**
+ * @brief   Draw the shapes with the inlined loop of a sink
+ */
+static void benchinline(BenchSinkStateType *st, BenchFigureType figure, MarkDrawModeType drawmode,
+                        BenchShapeType *s, int n) {
+int fill = drawmode == MARK_FILL;
+
+    for(int i=0;i<n;i++,s++) {
+        st->spans.n = 0;
+        switch(st->sink) {
+        case BENCH_SINK_BITMAP:
+            if( figure == BENCH_LINE )         drawlinebitmap(st->screen,s->a,s->b,s->c,s->d);
+            else if( figure == BENCH_CIRCLE )  fill ? drawcirclefillbitmap(st->screen,s->a,s->b,s->c)
+                                                    : drawcirclebitmap(st->screen,s->a,s->b,s->c);
+            else                               fill ? drawellipsefillbitmap(st->screen,s->a,s->b,s->c,s->d)
+                                                    : drawellipsebitmap(st->screen,s->a,s->b,s->c,s->d);
+            break;
+        case BENCH_SINK_COUNT:
+            if( figure == BENCH_LINE )         drawlinecount(&st->count,s->a,s->b,s->c,s->d);
+            else if( figure == BENCH_CIRCLE )  fill ? drawcirclefillcount(&st->count,s->a,s->b,s->c)
+                                                    : drawcirclecount(&st->count,s->a,s->b,s->c);
+            else                               fill ? drawellipsefillcount(&st->count,s->a,s->b,s->c,s->d)
+                                                    : drawellipsecount(&st->count,s->a,s->b,s->c,s->d);
+            break;
+        case BENCH_SINK_SPANS:
+            if( figure == BENCH_LINE )         drawlinespans(&st->spans,s->a,s->b,s->c,s->d);
+            else if( figure == BENCH_CIRCLE )  fill ? drawcirclefillspans(&st->spans,s->a,s->b,s->c)
+                                                    : drawcirclespans(&st->spans,s->a,s->b,s->c);
+            else                               fill ? drawellipsefillspans(&st->spans,s->a,s->b,s->c,s->d)
+                                                    : drawellipsespans(&st->spans,s->a,s->b,s->c,s->d);
+            break;
+        }
+    }
+}
+
+
+/**
+ * @brief   Draw the shapes with the Bresenham routines and callback sinks
+ */
+static void benchcallback(BenchSinkStateType *st, BenchFigureType figure, MarkDrawModeType drawmode,
+                          BenchShapeType *s, int n) {
+DrawContextType ctx;
+
+    MarkContextInit(&ctx,st->screen);
+    ctx.drawmode = drawmode;
+    ctx.user = st;
+    switch(st->sink) {
+    case BENCH_SINK_BITMAP:
+        ctx.point = bitmappoint;
+        break;
+    case BENCH_SINK_COUNT:
+        ctx.point = countpoint;
+        ctx.hrun = counthrun;
+        ctx.user = &st->count;
+        break;
+    case BENCH_SINK_SPANS:
+        ctx.point = spanspoint;
+        ctx.hrun = spanshrun;
+        break;
+    }
+    for(int i=0;i<n;i++,s++) {
+        st->spans.n = 0;
+        switch(figure) {
+        case BENCH_LINE:    drawlinebctx(&ctx,s->a,s->b,s->c,s->d);    break;
+        case BENCH_CIRCLE:  drawcirclebctx(&ctx,s->a,s->b,s->c);       break;
+        case BENCH_ELLIPSE: drawellipsebctx(&ctx,s->a,s->b,s->c,s->d); break;
+        }
+    }
+}
+
+
+/**
+ * @brief   Compare the callback sinks with the loops of drawloop.h, for each
+ *          sink, figure and mode
+ *
+ * @note    The shapes are inside the screen, since the inlined loops do not
+ *          clip
+ */
+static void benchsinks(BenchShapeType **shapes, int n) {
+BenchSinkStateType st;
+DrawSpanType *spans;
+struct timespec t0;
+unsigned long pixels,passes;
+double secs;
+
+    spans = (DrawSpanType *) malloc(BENCH_SPANS*sizeof(DrawSpanType));
+    st.screen = ScreenCreate(BENCH_WIDTH,BENCH_HEIGHT);
+    if( !spans || !st.screen ) {
+        free(spans);
+        ScreenDestroy(st.screen);
+        return;
+    }
+    DrawSpanListInit(&st.spans,spans,BENCH_SPANS);
+
+    for(int f=BENCH_LINE;f<=BENCH_ELLIPSE;f++) {
+        for(int mode=0;mode<(f==BENCH_LINE?1:2);mode++) {
+            MarkDrawModeType drawmode = mode ? MARK_FILL : MARK_CONTOUR;
+
+            // Pixels of a pass
+            st.sink = BENCH_SINK_COUNT;
+            st.count = 0;
+            benchinline(&st,(BenchFigureType) f,drawmode,shapes[f],n);
+            pixels = st.count;
+
+            for(int sink=BENCH_SINK_BITMAP;sink<=BENCH_SINK_SPANS;sink++) {
+                st.sink = (BenchSinkType) sink;
+                for(int inlined=0;inlined<2;inlined++) {
+                    passes = 0;
+                    clock_gettime(CLOCK_MONOTONIC,&t0);
+                    do {
+                        if( inlined )
+                            benchinline(&st,(BenchFigureType) f,drawmode,shapes[f],n);
+                        else
+                            benchcallback(&st,(BenchFigureType) f,drawmode,shapes[f],n);
+                        passes++;
+                        secs = benchtime(&t0);
+                    } while( secs < BENCH_MINTIME );
+                    benchprint((BenchFigureType) f,benchsinknames[sink],
+                               inlined?"bresenham-inline":"bresenham-callback",
+                               PBM,drawmode,passes*n,pixels*passes,secs);
+                }
+            }
+        }
+    }
+
+    ScreenDestroy(st.screen);
+    free(spans);
+}
+
+
+/**
+ * @brief   Hardware cache misses of this thread (-1 if not available)
+ */
+///@{
+static int benchmissesopen(void) {
+#ifdef __linux__
+struct perf_event_attr attr;
+
+    memset(&attr,0,sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int) syscall(__NR_perf_event_open,&attr,0,-1,-1,0);
+#else
+    return -1;
+#endif
+}
+
+static void benchmissesstart(int fd) {
+#ifdef __linux__
+    if( fd < 0 ) return;
+    ioctl(fd,PERF_EVENT_IOC_RESET,0);
+    ioctl(fd,PERF_EVENT_IOC_ENABLE,0);
+#endif
+}
+
+static double benchmissesstop(int fd) {
+#ifdef __linux__
+long long count;
+
+    if( fd < 0 ) return -1;
+    ioctl(fd,PERF_EVENT_IOC_DISABLE,0);
+    if( read(fd,&count,sizeof(count)) != sizeof(count) ) return -1;
+    return (double) count;
+#else
+    return -1;
+#endif
+}
+///@}
+
+
+/**
+ * @brief   Sink counting the points and the changes of row
+ */
+typedef struct {
+    unsigned long   points,rows;
+    INT             y;
+} BenchRowsType;
+
+static void rowspoint(DrawContextType *ctx, INT x, INT y) {
+BenchRowsType *r = (BenchRowsType *) ctx->user;
+
+    if( r->points == 0 || y != r->y ) r->rows++;
+    r->points++;
+    r->y = y;
+}
+
+
+/**
+ * @brief   Compare the mirror and path orders of circles and ellipses on big
+ *          canvases (contour mode, default sinks)
+ */
+static void benchorder(int n) {
+static const struct {
+    ImageFormatType fmt;
+    INT             size;
+} canvases[] = { { PBM, BENCH_BIGPBM }, { PGM, BENCH_BIGPGM } };
+BenchShapeType *shapes;
+BenchTestType t;
+BenchRowsType rows;
+DrawContextType ctx;
+MarkPointType *buf;
+ScreenType *screen;
+struct timespec t0;
+unsigned long passes;
+double secs,misses;
+int fd;
+
+    if( n > BENCH_BIGSHAPES ) n = BENCH_BIGSHAPES;
+    shapes = (BenchShapeType *) malloc(n*sizeof(BenchShapeType));
+    buf = (MarkPointType *) malloc((size_t) BENCH_BIGPBM*sizeof(MarkPointType));
+    if( !shapes || !buf ) {
+        free(shapes);
+        free(buf);
+        return;
+    }
+    fd = benchmissesopen();
+
+    printf("\nfigure,canvas,algorithm,format,order,pixels,ns_per_pixel,rows_per_pixel,misses_per_pixel\n");
+    for(int c=0;c<2;c++) {
+        INT size = canvases[c].size;
+
+        screen = ScreenCreateFormat(size,size,canvases[c].fmt);
+        if( !screen ) continue;
+        for(int f=BENCH_CIRCLE;f<=BENCH_ELLIPSE;f++) {
+            // Big figures inside the canvas
+            for(int i=0;i<n;i++) {
+                shapes[i].c = benchrand(size/8,size/2-1);
+                shapes[i].d = f == BENCH_CIRCLE ? shapes[i].c : benchrand(size/8,size/2-1);
+                shapes[i].a = benchrand(shapes[i].c,size-1-shapes[i].c);
+                shapes[i].b = benchrand(shapes[i].d,size-1-shapes[i].d);
+            }
+            t.figure = (BenchFigureType) f;
+            t.shapes = shapes;
+            t.drawmode = MARK_CONTOUR;
+            t.fmt = canvases[c].fmt;
+            for(int b=0;b<DrawBackendCount();b++) {
+                t.backend = DrawBackendGet(b);
+                if( t.backend->antialiased ) continue;
+                if( t.backend->supported && !t.backend->supported() ) continue;
+                for(int order=MARK_ORDER_MIRROR;order<=MARK_ORDER_PATH;order++) {
+                    // Points and changes of row of a pass
+                    MarkContextInit(&ctx,screen);
+                    MarkContextSetOrder(&ctx,(MarkOrderType) order,buf,BENCH_BIGPBM);
+                    ctx.point = rowspoint;
+                    ctx.user = &rows;
+                    rows.points = rows.rows = 0;
+                    for(int i=0;i<n;i++)
+                        benchdraw(&t,&ctx,&shapes[i]);
+
+                    MarkContextInit(&ctx,screen);
+                    MarkContextSetOrder(&ctx,(MarkOrderType) order,buf,BENCH_BIGPBM);
+                    passes = 0;
+                    benchmissesstart(fd);
+                    clock_gettime(CLOCK_MONOTONIC,&t0);
+                    do {
+                        for(int i=0;i<n;i++)
+                            benchdraw(&t,&ctx,&shapes[i]);
+                        passes++;
+                        secs = benchtime(&t0);
+                    } while( secs < BENCH_MINTIME );
+                    misses = benchmissesstop(fd);
+
+                    printf("%s,%dx%d,%s,%s,%s,%lu,%.3f,%.3f,%.3f\n",
+                           benchfigurenames[f],(int) size,(int) size,t.backend->name,
+                           t.fmt==PBM?"pbm":"pgm",order==MARK_ORDER_PATH?"path":"mirror",
+                           rows.points*passes,secs*1e9/(rows.points*passes),
+                           (double) rows.rows/rows.points,
+                           misses < 0 ? -1.0 : misses/(rows.points*passes));
+                }
+            }
+        }
+        ScreenDestroy(screen);
+    }
+
+#ifdef __linux__
+    if( fd >= 0 ) close(fd);
+#endif
+    free(shapes);
+    free(buf);
+}
+
+
+int main(int argc, char *argv[]) {
+int n = BENCH_SHAPES;
+BenchShapeType *lines,*circles,*ellipses,*work;
+BenchShapeType *random[3];
+
+    if( argc > 1 ) n = atoi(argv[1]);
+    if( n <= 0 ) n = BENCH_SHAPES;
+    srand(argc > 2 ? (unsigned) atoi(argv[2]) : 1);
+
+    lines    = (BenchShapeType *) malloc(n*sizeof(BenchShapeType));
+    circles  = (BenchShapeType *) malloc(n*sizeof(BenchShapeType));
+    ellipses = (BenchShapeType *) malloc(n*sizeof(BenchShapeType));
+    work     = (BenchShapeType *) malloc(n*sizeof(BenchShapeType));
+    if( !lines || !circles || !ellipses || !work ) {
+        fprintf(stderr,"No memory\n");
+        return 1;
+    }
+    benchlines(lines,n);
+    benchcircles(circles,n);
+    benchellipses(ellipses,n);
+
+    random[BENCH_LINE] = lines;
+    random[BENCH_CIRCLE] = circles;
+    random[BENCH_ELLIPSE] = ellipses;
+
+    printf("figure,workload,algorithm,format,mode,calls,pixels,ns_per_call,ns_per_pixel,pixels_per_s,calls_per_s\n");
+    benchfamilies(work,n);
+    benchantialiased(random,n);
+    benchsinks(random,n);
+    benchorder(n);
+
+    free(lines);
+    free(circles);
+    free(ellipses);
+    free(work);
+    return 0;
+}
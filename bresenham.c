@@ -6,7 +6,8 @@
  * @note   Integer types used are specified by preprocessor symbols INT and LONG
  *         to enhance portability
  *
- * @note   LONG is only used for ellipses
+ * @note   LONG is only used for ellipses. Their decision terms use LONG64
+ *         or LONG128 (see MarkEllipseRange)
  *
  *
  * @author  Hans
@@ -20,6 +21,7 @@
 #include <stdio.h>
 #include "bresenham.h"
 #include "mark.h"
+#include "curve.h"
 
 
 /**
@@ -73,15 +75,93 @@
 #define ABS(X)  ((X)>0?(X):-(X))
 
 
+/**
+ * @brief   Clip a line against the screen
+ *
+ * @note    The start point, the end point (only the major axis is used) and the
+ *          error term are updated to the first and last points inside the screen.
+ *          The points drawn are the same as those of the unclipped line.
+ *
+ * @note    Points must be already ordered (dy>=0) and key computed
+ *
+ * @return  0 if the line is outside the screen
+ */
+static int cliplineb(DrawContextType *ctx, int key, INT *x1, INT *y1, INT *x2, INT *y2, int *eps) {
+MarkClipType clip;
+MarkLineStepType ls;
+LONG64 n1,n2,k;
+INT dx,dy;
+int r;
+
+    if( !MarkGetClip(ctx,&clip) ) return 0;
+
+    dx = *x2 - *x1;
+    dy = *y2 - *y1;
+    switch(key) {
+    case OCT0:
+    case OCT3: // x is the major axis
+        ls.len = ABS(dx);
+        ls.major = *x1;
+        ls.majorinc = (key==OCT0)?1:-1;
+        ls.minor = *y1;
+        ls.minorinc = 1;
+        ls.p = 2*(LONG64)dy;
+        ls.q = ls.len;
+        ls.r = ls.len?2*ls.len:1;
+        r = MarkClipLineSteps(&ls,clip.xmin,clip.xmax,clip.ymin,clip.ymax,&n1,&n2);
+        if( !r ) return 0;
+        k = MarkLineStepsK(&ls,n1);
+        *x1 = ls.major + n1*ls.majorinc;
+        *y1 = ls.minor + k;
+        *x2 = ls.major + n2*ls.majorinc;
+        break;
+    case OCT1:
+    case OCT2: // y is the major axis
+        ls.len = dy;
+        ls.major = *y1;
+        ls.majorinc = 1;
+        ls.minor = *x1;
+        ls.minorinc = (key==OCT1)?1:-1;
+        ls.p = 2*(LONG64)ABS(dx);
+        ls.q = ls.len;
+        ls.r = ls.len?2*ls.len:1;
+        r = MarkClipLineSteps(&ls,clip.ymin,clip.ymax,clip.xmin,clip.xmax,&n1,&n2);
+        if( !r ) return 0;
+        k = MarkLineStepsK(&ls,n1);
+        *y1 = ls.major + n1;
+        *x1 = ls.minor + k*ls.minorinc;
+        *y2 = ls.major + n2;
+        break;
+    default:
+        return 0;
+    }
+    // Error term after n1 steps
+    *eps = n1*(ls.p/2) - k*ls.len;
+    return 1;
+}
+
+
 /**
  * @brief   Draw a line using Bresenham algorithm
+ *
+ * @note    The line is clipped against the screen before the loop. Points are
+ *          then plotted without bounds checking.
+ *
+ * @note    Dashed lines (MarkContextSetPattern) are drawn by drawsegmentctx
  */
 
-void drawlineb(INT x1, INT y1, INT x2, INT y2 ) {
+void drawlinebctx(DrawContextType *ctx, INT x1, INT y1, INT x2, INT y2 ) {
 int x,y;
 int key;
 int eps;
 INT t;
+INT s;
+
+    // Dashed lines carry the phase thru drawsegmentctx (same points)
+    if( ctx->patternlen ) {
+        drawsegmentctx(ctx,x1,y1,x2,y2,1);
+        return;
+    }
 
     INT dx = x2 - x1;
     INT dy = y2 - y1;
@@ -105,15 +185,75 @@ INT t;
 
     // Preparing cycle
     eps = 0;
+    if( !cliplineb(ctx,key,&x1,&y1,&x2,&y2,&eps) ) return;
     x = x1;
     y = y1;
 
     // Every octant has a different way to cycle and increment.
     // A jump done once is faster than testing and/or using additions instead of increment
+    if( ctx->linemode==MARK_LINE_RUNS ) {
+        // Same stepping, but points sharing a row (column) are emitted as a run
+        switch(key){
+        case OCT0: // 1st octant
+            s = x1;
+            for(x=x1; x<=x2;x++) {
+                eps += dy;
+                if( (eps<<1) >= dx ) {
+                    MARKHRUN(ctx,s,x,y);
+                    s = x+1;
+                    y++;
+                    eps -= dx;
+                }
+            }
+            if( s <= x2 ) MARKHRUN(ctx,s,x2,y);
+            break;
+        case OCT1: // 2nd octant
+            s = y1;
+            for(y=y1; y<=y2;y++) {
+                eps += dx;
+                if( (eps<<1) >= dy ) {
+                    MARKVRUN(ctx,x,s,y);
+                    s = y+1;
+                    x++;
+                    eps -= dy;
+                }
+            }
+            if( s <= y2 ) MARKVRUN(ctx,x,s,y2);
+            break;
+        case OCT2: // 3rd octant
+            s = y1;
+            for(y=y1; y<=y2;y++) {
+                eps -= dx;
+                if( (eps<<1) >= dy ) {
+                    MARKVRUN(ctx,x,s,y);
+                    s = y+1;
+                    x--;
+                    eps -= dy;
+                }
+            }
+            if( s <= y2 ) MARKVRUN(ctx,x,s,y2);
+            break;
+        case OCT3: // 4th octant
+            s = x1;
+            for(x=x1; x>=x2;x--) {
+                eps += dy;
+                if( (eps<<1) >= -dx ) {
+                    MARKHRUN(ctx,x,s,y);
+                    s = x-1;
+                    y++;
+                    eps += dx;
+                }
+            }
+            if( s >= x2 ) MARKHRUN(ctx,x2,s,y);
+            break;
+        }
+        return;
+    }
+
     switch(key){
     case OCT0: // 1st octant
         for(x=x1; x<=x2;x++) {
-            MARKPOINT(x,y);
+            MARKPOINTIN(ctx,x,y);
             eps += dy;
             if( (eps<<1) >= dx ) {
                 y++;
@@ -123,7 +263,7 @@ INT t;
         break;
     case OCT1: // 2nd octant
         for(y=y1; y<=y2;y++) {
-            MARKPOINT(x,y);
+            MARKPOINTIN(ctx,x,y);
             eps += dx;
             if( (eps<<1) >= dy ) {
                 x++;
@@ -133,7 +273,7 @@ INT t;
         break;
     case OCT2: // 3rd octant
         for(y=y1; y<=y2;y++) {
-            MARKPOINT(x,y);
+            MARKPOINTIN(ctx,x,y);
             eps -= dx;
             if( (eps<<1) >= dy ) {
                 x--;
@@ -143,7 +283,7 @@ INT t;
         break;
     case OCT3: // 4th octant
         for(x=x1; x>=x2;x--) {
-            MARKPOINT(x,y);
+            MARKPOINTIN(ctx,x,y);
             eps += dy;
             if( (eps<<1) >= -dx ) {
                 y++;
@@ -155,29 +295,85 @@ INT t;
 }
 
 
+/**
+ * @brief   yr of the circle loop at column xr (while xr < yr)
+ *
+ * @note    The error term of the loop is e = 2*(xr+1)^2+yr^2+(yr-1)^2+
+ *          4*(r-yr)-2*r^2, and yr is kept while it is negative. yr only moves
+ *          one step in the octant, so it is the largest yr that passes the test
+ */
+static INT circleby(INT r, INT xr) {
+INT lo = 0, hi = r, m;
+
+    while( lo < hi ) {
+        m = lo+(hi-lo+1)/2;
+        if( 2*(LONGWIDE) xr*xr+(LONGWIDE) m*m+((LONGWIDE) m-1)*(m-1)+4*((LONGWIDE) r-m) <
+            2*(LONGWIDE) r*r ) lo = m;
+        else hi = m-1;
+    }
+    return lo;
+}
+
+
 /**
  * @brief   Draw a circle using Bresenham algorithm
+ *
+ * @note    Circles outside the screen are rejected. Circles completely inside
+ *          the screen are drawn without bounds checking. For the others, only
+ *          the steps that can reach the screen are walked (see
+ *          MarkCurveWindows): the loop jumps from one window to the next.
+ *
+ * @note    In fill mode, each row is filled once. Rows yc+-xr are final at
+ *          once, since xr changes at every step. Rows yc+-yr are coalesced.
+ *
+ * @note    With a dash pattern, each step is on or off for the 8 octants, so
+ *          the dash starts at the axes. In MARK_ORDER_PATH, the dash goes
+ *          along the whole circle instead (see markorderrun)
  */
 
-void drawcircleb(INT xc, INT yc, INT r) {
+void drawcirclebctx(DrawContextType *ctx, INT xc, INT yc, INT r) {
 INT xr,yr;
-int e;
+int e,ph,nw,k;
+MarkClipResultType c;
+MarkWindowType w[MARK_CURVEWINDOWS];
+
+    // A dashed contour is walked anyway, for the phase of the next figure
+    c = MarkClipBox(ctx,xc-r,yc-r,xc+r,yc+r);
+    if( c == MARK_OUTSIDE && (!ctx->patternlen || ctx->drawmode == MARK_FILL) ) return;
+    nw = c == MARK_PARTIAL ? MarkCurveWindows(ctx,xc,yc,r,r,0,1,w) : -1;
+    if( nw == 0 ) return;
+    k = 0;
 
     xr = 0;
     yr = r;
     e = 3 - (r+r);
+    ph = ctx->patternphase;
+    if( ctx->drawmode==MARK_FILL ) MARKFILLBEGIN(ctx,xc,yc);
+    else MARKCONTOURBEGIN(ctx,xc,yc);
     do {
-        // Mirrored
-        if( markdrawmode==MARK_FILL ) {
-              MARKFILL(xc,yc,xr,yr);
-        } else {
-              MARKCONTOUROCT(xc,yc,xr,yr);
+        if( nw > 0 ) {
+            // Next column in a window, or jump to the column before the next
+            // window (yr is not known past the diagonal)
+            while( k < nw && xr > w[k].hi ) k++;
+            if( k == nw ) break;
+            if( xr+1 < w[k].lo ) {
+                xr = (INT) w[k].lo-1;
+                yr = circleby(r,xr);
+                if( yr <= xr ) break;
+                e = (int) (2*((LONGWIDE) xr+1)*(xr+1)+(LONGWIDE) yr*yr+((LONGWIDE) yr-1)*(yr-1)+
+                           4*((LONGWIDE) r-yr)-2*(LONGWIDE) r*r);
+            }
         }
-        // Transposed
-        if( markdrawmode==MARK_FILL ) {
-              MARKFILL(xc,yc,xr,yr);
+        // Mirrored and transposed (each distinct point once)
+        if( ctx->drawmode==MARK_FILL ) {
+              if( xr < yr ) MARKFILL(ctx,xc,yc,yr,xr);
+              MARKFILLROW(ctx,xr,yr);
+        } else if( ctx->patternlen && !ctx->ordering && !MARKPATTERNBIT(ctx,ph) ) {
+              // Off in the dash pattern: the same step of the 8 octants
+        } else if( c == MARK_INSIDE ) {
+              MARKCONTOUROCTIN(ctx,xc,yc,xr,yr);
         } else {
-              MARKCONTOUROCT(xc,yc,xr,yr);
+              MARKCONTOUROCT(ctx,xc,yc,xr,yr);
         }
         if( e < 0 ) {
             e = e + 4*xr + 6;
@@ -186,9 +382,167 @@ int e;
             e = e + 4*(xr-yr) + 10;
         }
         xr++;
+        if( ctx->patternlen ) MARKPATTERNSTEP(ctx,ph);
     } while( xr <= yr);
+    if( ctx->drawmode==MARK_FILL ) {
+        MARKFILLEND(ctx);
+    } else {
+        if( ctx->patternlen && !ctx->ordering ) ctx->patternphase = ph;
+        MARKCONTOUREND(ctx);
+    }
+}
+
+
+
+/**
+ * @brief   Ellipse loop for a width T of the decision terms
+ *
+ * @note    It is generated for LONG64 and, if available, LONG128. Both draw
+ *          the same points. The narrower one is used when the radii allow it
+ *          (see MarkEllipseRange)
+ */
+#define ELLIPSEB(NAME,T) \
+static void NAME(DrawContextType *ctx, MarkClipResultType c, \
+                 INT xc, INT yc, INT rx, INT ry) { \
+MarkWindowType wx[MARK_CURVEWINDOWS],wy[MARK_CURVEWINDOWS]; \
+INT x,y,x1,y1; \
+T d; \
+T dx,dy; \
+T rx2,ry2; \
+T rx2_x2,ry2_x2; \
+int nx,ny,kx,ky; \
+ \
+    /* Partly visible: windows of the steps in x (octant 0) and in y */ \
+    nx = ny = -1; \
+    if( c == MARK_PARTIAL ) { \
+        nx = MarkCurveWindows(ctx,xc,yc,rx,ry,0,0,wx); \
+        ny = MarkCurveWindows(ctx,xc,yc,rx,ry,1,0,wy); \
+        if( nx == 0 && ny == 0 ) return; \
+    } \
+    kx = 0; \
+    ky = ny-1; \
+ \
+    /* Precalculate squares and double squares */ \
+    rx2 = (T) rx*rx; \
+    ry2 = (T) ry*ry; \
+    rx2_x2 = 2*rx2; \
+    ry2_x2 = 2*ry2; \
+ \
+    x = 0; \
+    y = ry; \
+    if( ctx->drawmode==MARK_FILL ) { \
+        MARKFILLBEGIN(ctx,xc,yc); \
+        MARKFILLROW(ctx,x,y); \
+    } else if( c == MARK_INSIDE ) { \
+        MARKCONTOURBEGIN(ctx,xc,yc); \
+        MARKCONTOURQUADIN(ctx,xc,yc,x,y); \
+    } else { \
+        MARKCONTOURBEGIN(ctx,xc,yc); \
+        MARKCONTOURQUAD(ctx,xc,yc,x,y); \
+    } \
+ \
+    /* Decision factor */ \
+    d = 4*ry2 - 4*rx2*ry + rx2; \
+    dx = 4*ry2_x2*x; \
+    dy = 4*rx2_x2*y; \
+ \
+    /* Octant 0 */ \
+    while( dx < dy ) { \
+        if( nx >= 0 ) { \
+            /* Jump to the column before the next window, or to the turn */ \
+            while( kx < nx && x+1 > wx[kx].hi ) kx++; \
+            if( kx == nx || x+1 < wx[kx].lo ) { \
+                x1 = MarkEllipseTurn(rx,ry,&y1); \
+                if( kx < nx && wx[kx].lo-1 < x1 ) { \
+                    x = (INT) wx[kx].lo-1; \
+                    y = MarkEllipseY(rx,ry,x); \
+                } else { \
+                    x = x1; \
+                    y = y1; \
+                } \
+                dx = 4*ry2_x2*x; \
+                dy = 4*rx2_x2*y; \
+                d = 4*ry2*((T) x+1)*((T) x+1) + rx2*(2*(T) y-1)*(2*(T) y-1) - 4*rx2*ry2; \
+                if( dx >= dy ) break; \
+            } \
+        } \
+        x++; \
+        dx += 4*ry2_x2; \
+        if( d < 0 ) { \
+            d += dx + 4*ry2; \
+        } else { \
+            y--; \
+            dy -= 4*rx2_x2; \
+            d += dx - dy + 4*ry2; \
+        } \
+        if( ctx->drawmode==MARK_FILL ) { \
+            MARKFILLROW(ctx,x,y); \
+        } else if( c == MARK_INSIDE ) { \
+            MARKCONTOURQUADIN(ctx,xc,yc,x,y); \
+        } else { \
+            MARKCONTOURQUAD(ctx,xc,yc,x,y); \
+        } \
+    } \
+ \
+    /* Decision factor */ \
+    d = ry2*(2*x+1)*(2*x+1) + rx2*(2*y-2)*(2*y-2)-4*rx2*ry2; \
+    /* Octant 1 */ \
+    x1 = x; \
+    while( y>0 ) { \
+        if( ny >= 0 ) { \
+            /* Jump to the row after the last one of the next window */ \
+            while( ky >= 0 && y-1 < wy[ky].lo ) ky--; \
+            y1 = ky < 0 ? 0 : (INT) wy[ky].hi; \
+            if( y1+1 < y ) { \
+                y = y1+1; \
+                x = MarkEllipseX(rx,ry,y); \
+                if( x < x1 ) x = x1; \
+                dx = 4*ry2_x2*x; \
+                dy = 4*rx2_x2*y; \
+                d = ry2*(2*(T) x+1)*(2*(T) x+1) + rx2*(2*(T) y-2)*(2*(T) y-2)-4*rx2*ry2; \
+            } \
+        } \
+        y--; \
+        dy -= 4*rx2_x2; \
+        if( d > 0 ) { \
+            d -= dy - 4*rx2; \
+        } else { \
+            x++; \
+            dx += 4*ry2_x2; \
+            d += dx - dy + 4*rx2; \
+        } \
+        if( ctx->drawmode==MARK_FILL ) { \
+             MARKFILLROW(ctx,x,y); \
+        } else if( c == MARK_INSIDE ) { \
+             MARKCONTOURQUADIN(ctx,xc,yc,x,y); \
+        } else { \
+             MARKCONTOURQUAD(ctx,xc,yc,x,y); \
+        } \
+    } \
+    /* Flat ellipses (ry small) reach y = 0 before the tip */ \
+    while( x < rx ) { \
+        if( nx >= 0 ) { \
+            while( kx < nx && x+1 > wx[kx].hi ) kx++; \
+            if( kx == nx ) break; \
+            if( x+1 < wx[kx].lo ) x = (INT) wx[kx].lo-1; \
+        } \
+        x++; \
+        if( ctx->drawmode==MARK_FILL ) { \
+             MARKFILLROW(ctx,x,y); \
+        } else if( c == MARK_INSIDE ) { \
+             MARKCONTOURQUADIN(ctx,xc,yc,x,y); \
+        } else { \
+             MARKCONTOURQUAD(ctx,xc,yc,x,y); \
+        } \
+    } \
+    if( ctx->drawmode==MARK_FILL ) MARKFILLEND(ctx); \
+    else MARKCONTOUREND(ctx); \
 }
 
+ELLIPSEB(ellipseb64,LONG64)
+#ifdef LONG128
+ELLIPSEB(ellipseb128,LONG128)
+#endif
 
 
 /**
@@ -197,66 +551,337 @@ int e;
  * @note    Ellipse axes are horizontal and vertical
  *
  * @note    Draw in first quadrant and mirror the points to other quadrants
+ *
+ * @note    Ellipses outside the screen are rejected. Ellipses completely inside
+ *          the screen are drawn without bounds checking. For the others, each
+ *          region jumps over the steps that cannot reach the screen (see
+ *          MarkCurveWindows), from the point found with MarkEllipseY or
+ *          MarkEllipseX and its decision terms computed again.
+ *
+ * @note    In fill mode, points of the same row are coalesced and each row
+ *          is filled once
+ *
+ * @note    Large radii use 128 bit decision terms. Ellipses out of range
+ *          (see MarkEllipseRange) are not drawn
  */
-void drawellipseb(INT xc, INT yc, INT rx, INT ry) {
-INT x,y;
-LONG d;
-LONG dx,dy;
-LONG rx2,ry2;
-LONG rx2_x2,ry2_x2;
-
-
-    // Precalculate squares and double squares
-    rx2 = rx*rx;
-    ry2 = ry*ry;
-    rx2_x2 = 2*rx2;
-    ry2_x2 = 2*ry2;
-
-    x = 0;
-    y = ry;
-    MARKCONTOURQUAD(xc,yc,x,y);
-    // Others??
-
-    // Decision factor
-    d = 4*ry2 - 4*rx2*ry + rx2;
-    dx = 4*ry2_x2*x;
-    dy = 4*rx2_x2*y;
-
-    // Octant 0
-    while( dx < dy ) {
-        x++;
-        dx += 4*ry2_x2;
-        if( d < 0 ) {
-            d += dx + 4*ry2;
-        } else {
-            y--;
-            dy -= 4*rx2_x2;
-            d += dx - dy + 4*ry2;
+void drawellipsebctx(DrawContextType *ctx, INT xc, INT yc, INT rx, INT ry) {
+MarkRangeType range;
+MarkClipResultType c;
+
+    range = MarkEllipseRange(xc,yc,rx,ry);
+    if( range == MARK_RANGE_NONE ) return;
+
+    // A dashed contour in path order is walked anyway, for the phase
+    c = MarkClipBox(ctx,xc-rx,yc-ry,xc+rx,yc+ry);
+    if( c == MARK_OUTSIDE && (!ctx->patternlen || ctx->order != MARK_ORDER_PATH ||
+                              ctx->drawmode == MARK_FILL) ) return;
+
+#ifdef LONG128
+    if( range == MARK_RANGE_LONG128 ) {
+        ellipseb128(ctx,c,xc,yc,rx,ry);
+        return;
+    }
+#endif
+    ellipseb64(ctx,c,xc,yc,rx,ry);
+}
+
+
+/**
+ * @brief   Direct bitmap loops for each octant, used by the batch routines
+ *
+ * @note    The line must be already clipped. A byte pointer and a bit mask
+ *          are stepped instead of computing the address of every point.
+ */
+///@{
+static void lineoct0b(ScreenType *screen, INT x, INT y, INT x2, INT dx, INT dy, int eps) {
+unsigned char *p = &(screen->data[y*screen->wbytes+(x>>3)]);
+unsigned m = 0x80>>(x&7);
+INT wid = screen->wbytes;
+
+    SCREENCOUNT(screen,x2-x+1);
+    for(; x<=x2; x++) {
+        *p |= m;
+        eps += dy;
+        if( (eps<<1) >= dx ) {
+            p += wid;
+            eps -= dx;
         }
-        if( markdrawmode==MARK_FILL ) {
-            MARKFILL(xc,yc,x,y);
-        } else {
-            MARKCONTOURQUAD(xc,yc,x,y);
+        m >>= 1;
+        if( !m ) {
+            m = 0x80;
+            p++;
         }
     }
+}
 
-    // Decision factor
-    d = ry2*(2*x+1)*(2*x+1) + rx2*(2*y-2)*(2*y-2)-4*rx2*ry2;
-    // Octant 1
-    while( y>0 ) {
-        y--;
-        dy -= 4*rx2_x2;
-        if( d > 0 ) {
-            d -= dy - 4*rx2;
-        } else {
-            x++;
-            dx += ry2_x2;
-            d += dx - dy + 4*rx2;
+static void lineoct1b(ScreenType *screen, INT x, INT y, INT y2, INT dx, INT dy, int eps) {
+unsigned char *p = &(screen->data[y*screen->wbytes+(x>>3)]);
+unsigned m = 0x80>>(x&7);
+INT wid = screen->wbytes;
+
+    SCREENCOUNT(screen,y2-y+1);
+    for(; y<=y2; y++) {
+        *p |= m;
+        p += wid;
+        eps += dx;
+        if( (eps<<1) >= dy ) {
+            eps -= dy;
+            m >>= 1;
+            if( !m ) {
+                m = 0x80;
+                p++;
+            }
         }
-        if( markdrawmode==MARK_FILL ) {
-             MARKFILL(xc,yc,x,y);
-        } else {
-             MARKCONTOURQUAD(xc,yc,x,y);
+    }
+}
+
+static void lineoct2b(ScreenType *screen, INT x, INT y, INT y2, INT dx, INT dy, int eps) {
+unsigned char *p = &(screen->data[y*screen->wbytes+(x>>3)]);
+unsigned m = 0x80>>(x&7);
+INT wid = screen->wbytes;
+
+    SCREENCOUNT(screen,y2-y+1);
+    for(; y<=y2; y++) {
+        *p |= m;
+        p += wid;
+        eps -= dx;
+        if( (eps<<1) >= dy ) {
+            eps -= dy;
+            m <<= 1;
+            if( m > 0x80 ) {
+                m = 0x01;
+                p--;
+            }
         }
     }
 }
+
+static void lineoct3b(ScreenType *screen, INT x, INT y, INT x2, INT dx, INT dy, int eps) {
+unsigned char *p = &(screen->data[y*screen->wbytes+(x>>3)]);
+unsigned m = 0x80>>(x&7);
+INT wid = screen->wbytes;
+
+    SCREENCOUNT(screen,x-x2+1);
+    for(; x>=x2; x--) {
+        *p |= m;
+        eps += dy;
+        if( (eps<<1) >= -dx ) {
+            p += wid;
+            eps += dx;
+        }
+        m <<= 1;
+        if( m > 0x80 ) {
+            m = 0x01;
+            p--;
+        }
+    }
+}
+///@}
+
+
+/**
+ * @brief   Octant code of a line (after reduction to the upper semiplane)
+ */
+static int linekeyb(INT x1, INT y1, INT x2, INT y2) {
+INT dx = x2 - x1;
+INT dy = y2 - y1;
+int key = 0;
+
+    if( dy < 0 ) {
+        dy = -dy;
+        dx = -dx;
+    }
+    if( dx < 0 ) key |= 2;
+    if( dy > ABS(dx) ) key |= 1;
+    return key;
+}
+
+
+/**
+ * @brief   Draw many lines using Bresenham algorithm
+ *
+ * @note    Endpoints are given as arrays (structure of arrays)
+ *
+ * @note    Lines are sorted by octant code, so the octant is selected once
+ *          for each group. With the default sinks (and solid lines), points are
+ *          written directly into the bitmap (the bounding box of each line is
+ *          recorded as changed). Otherwise, drawlinebctx is used for each line.
+ */
+void drawlinesbctx(DrawContextType *ctx, const INT *x1, const INT *y1,
+                   const INT *x2, const INT *y2, int n) {
+int *order;
+unsigned char *key;
+int start[5];
+INT xa,ya,xb,yb,dx,dy,t;
+int eps;
+
+    if( n <= 0 ) return;
+
+    order = 0;
+    key = 0;
+    if( ctx->point == MarkScreenPoint && ctx->linemode == MARK_LINE_POINTS &&
+        ctx->screen && !ctx->patternlen ) {
+        order = (int *) malloc(n*sizeof(int));
+        key = (unsigned char *) malloc(n);
+    }
+    if( !order || !key ) {
+        free(order);
+        free(key);
+        for(int i=0;i<n;i++)
+            drawlinebctx(ctx,x1[i],y1[i],x2[i],y2[i]);
+        return;
+    }
+
+    // Counting sort by octant code
+    for(int k=0;k<5;k++) start[k] = 0;
+    for(int i=0;i<n;i++) {
+        key[i] = linekeyb(x1[i],y1[i],x2[i],y2[i]);
+        start[key[i]+1]++;
+    }
+    for(int k=0;k<4;k++) start[k+1] += start[k];
+    for(int i=0;i<n;i++)
+        order[start[key[i]]++] = i;
+    for(int k=3;k>0;k--) start[k] = start[k-1];
+    start[0] = 0;
+
+    for(int k=0;k<4;k++) {
+        for(int j=start[k];j<start[k+1];j++) {
+            int i = order[j];
+            xa = x1[i];
+            ya = y1[i];
+            xb = x2[i];
+            yb = y2[i];
+            if( yb < ya ) {
+                t = xa; xa = xb; xb = t;
+                t = ya; ya = yb; yb = t;
+            }
+            dx = xb - xa;
+            dy = yb - ya;
+            eps = 0;
+            if( !cliplineb(ctx,k,&xa,&ya,&xb,&yb,&eps) ) continue;
+            ScreenMarkDirty(ctx->screen,xa<xb?xa:xb,ya,xa<xb?xb:xa,yb);
+            switch(k) {
+            case OCT0: lineoct0b(ctx->screen,xa,ya,xb,dx,dy,eps); break;
+            case OCT1: lineoct1b(ctx->screen,xa,ya,yb,dx,dy,eps); break;
+            case OCT2: lineoct2b(ctx->screen,xa,ya,yb,dx,dy,eps); break;
+            case OCT3: lineoct3b(ctx->screen,xa,ya,xb,dx,dy,eps); break;
+            }
+        }
+    }
+
+    free(order);
+    free(key);
+}
+
+
+/**
+ * @brief   Draw many circles using Bresenham algorithm
+ *
+ * @note    Centers and radii are given as arrays (structure of arrays)
+ *
+ * @note    With the default sinks, contours of circles inside the screen are
+ *          written directly into the bitmap, using a pointer for each of the
+ *          four rows touched at each step (the bounding box is recorded as
+ *          changed). Other circles use drawcirclebctx.
+ */
+void drawcirclesbctx(DrawContextType *ctx, const INT *xc, const INT *yc,
+                     const INT *r, int n) {
+ScreenType *screen = ctx->screen;
+unsigned char *p1,*p2,*p3,*p4;
+INT xr,yr,wid;
+int e;
+
+    for(int i=0;i<n;i++) {
+        if( ctx->point != MarkScreenPoint || ctx->drawmode == MARK_FILL ||
+            ctx->order == MARK_ORDER_PATH || ctx->patternlen || r[i] <= 0 ||
+            MarkClipBox(ctx,xc[i]-r[i],yc[i]-r[i],xc[i]+r[i],yc[i]+r[i]) != MARK_INSIDE ) {
+            drawcirclebctx(ctx,xc[i],yc[i],r[i]);
+            continue;
+        }
+        ScreenMarkDirty(screen,xc[i]-r[i],yc[i]-r[i],xc[i]+r[i],yc[i]+r[i]);
+        wid = screen->wbytes;
+        xr = 0;
+        yr = r[i];
+        e = 3 - (yr+yr);
+        // Rows yc+yr, yc-yr, yc+xr and yc-xr
+        p1 = &(screen->data[(yc[i]+yr)*wid]);
+        p2 = &(screen->data[(yc[i]-yr)*wid]);
+        p3 = &(screen->data[yc[i]*wid]);
+        p4 = p3;
+        do {
+            INT c1 = xc[i]-xr, c2 = xc[i]+xr;
+            INT c3 = xc[i]-yr, c4 = xc[i]+yr;
+            // Rows yc+-yr: columns xc+-xr
+            p1[c2>>3] |= 0x80>>(c2&7);
+            p2[c2>>3] |= 0x80>>(c2&7);
+            if( xr != 0 ) {
+                p1[c1>>3] |= 0x80>>(c1&7);
+                p2[c1>>3] |= 0x80>>(c1&7);
+            }
+            // Rows yc+-xr: columns xc+-yr (not on the diagonal)
+            if( xr != yr ) {
+                p3[c4>>3] |= 0x80>>(c4&7);
+                p3[c3>>3] |= 0x80>>(c3&7);
+                if( xr != 0 ) {
+                    p4[c4>>3] |= 0x80>>(c4&7);
+                    p4[c3>>3] |= 0x80>>(c3&7);
+                }
+            }
+            SCREENCOUNT(screen,(xr?4:2)+(xr!=yr?(xr?4:2):0));
+            if( e < 0 ) {
+                e = e + 4*xr + 6;
+            } else {
+                yr--;
+                p1 -= wid;
+                p2 += wid;
+                e = e + 4*(xr-yr) + 10;
+            }
+            xr++;
+            p3 += wid;
+            p4 -= wid;
+        } while( xr <= yr );
+    }
+}
+
+
+/**
+ * @brief   Old interface. Draw on markscreen using the global variables
+ *
+ * @note    A context is built from them at each call (see MarkGlobalContext)
+ */
+///@{
+void drawlineb(INT x1, INT y1, INT x2, INT y2) {
+DrawContextType ctx;
+
+    MarkGlobalContext(&ctx);
+    drawlinebctx(&ctx,x1,y1,x2,y2);
+}
+
+void drawcircleb(INT xc, INT yc, INT r) {
+DrawContextType ctx;
+
+    MarkGlobalContext(&ctx);
+    drawcirclebctx(&ctx,xc,yc,r);
+}
+
+void drawellipseb(INT xc, INT yc, INT rx, INT ry) {
+DrawContextType ctx;
+
+    MarkGlobalContext(&ctx);
+    drawellipsebctx(&ctx,xc,yc,rx,ry);
+}
+
+void drawlinesb(const INT *x1, const INT *y1, const INT *x2, const INT *y2, int n) {
+DrawContextType ctx;
+
+    MarkGlobalContext(&ctx);
+    drawlinesbctx(&ctx,x1,y1,x2,y2,n);
+}
+
+void drawcirclesb(const INT *xc, const INT *yc, const INT *r, int n) {
+DrawContextType ctx;
+
+    MarkGlobalContext(&ctx);
+    drawcirclesbctx(&ctx,xc,yc,r,n);
+}
+///@}
@@ -17,10 +17,23 @@
 #define LONG    long
 #endif
 
+#include "mark.h"
+
 
 void drawlineb(INT x1, INT y1, INT x2, INT y2);
 void drawcircleb(INT xc, INT yc, INT r);
 void drawellipseb(INT xc, INT yc, INT rx, INT ry);
 
+void drawlinebctx(DrawContextType *ctx, INT x1, INT y1, INT x2, INT y2);
+void drawcirclebctx(DrawContextType *ctx, INT xc, INT yc, INT r);
+void drawellipsebctx(DrawContextType *ctx, INT xc, INT yc, INT rx, INT ry);
+
+void drawlinesb(const INT *x1, const INT *y1, const INT *x2, const INT *y2, int n);
+void drawcirclesb(const INT *xc, const INT *yc, const INT *r, int n);
+void drawlinesbctx(DrawContextType *ctx, const INT *x1, const INT *y1,
+                   const INT *x2, const INT *y2, int n);
+void drawcirclesbctx(DrawContextType *ctx, const INT *xc, const INT *yc,
+                     const INT *r, int n);
+
 
 #endif// BRESENHAM_H
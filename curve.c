@@ -0,0 +1,688 @@
+/**
+ * @file    curve.c
+ *
+ * @brief   Draw quadratic and cubic Bézier curves, polylines and polygons,
+ *          and fill polygons
+ *
+ * @note    The segments of polylines and polygons are the lines of
+ *          bresenham.c (same points), but walked from the first vertex to the
+ *          second one, so a joint is sent once and the points are in order.
+ *
+ * @note    Curves use adaptive forward differencing with integers. The
+ *          polynomial is kept as a*s^3 + b*s^2 + c*s + d, where s counts the
+ *          steps, in fixed point. A step is one shift of the polynomial
+ *          (additions only). The step is halved (a/8, b/4, c/2) when it could
+ *          move more than one pixel and doubled (a*8, b*4, c*2) while the
+ *          doubled step would not. The fixed point has enough bits for the smallest
+ *          step, so halving is exact and the curve ends exactly at the last
+ *          control point.
+ *
+ * @note    Polygons are filled by scanlines, with an active edge table. The
+ *          edges are stepped with integers, as lines.
+ *
+ * @note    The points of a curve go thru a pen that drops repeated points and
+ *          the corners of the staircases (a point between two diagonal
+ *          neighbors), so the curves are thin and 8-connected.
+ *
+ * @note    The fixed point values grow as 2^15*size^4, where size is the
+ *          largest distance from the first control point. LONG128 is used if
+ *          available (sizes up to CURVE_MAXSIZE). Otherwise, LONG64 limits
+ *          the size to a few thousands. Larger curves are not drawn.
+ *
+ * @author  Hans
+ *
+ * @version 1.0
+ *
+ * @date    17/10/2026
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <limits.h>
+#include "curve.h"
+#include "mark.h"
+
+#ifdef LONG128
+#define CURVEWIDE       LONG128
+#define CURVE_MAXSIZE   (1<<26)
+#else
+#define CURVEWIDE       LONG64
+#define CURVE_MAXSIZE   (1<<11)
+#endif
+
+#define ABS(X)  ((X)>0?(X):-(X))
+
+
+/**
+ * @brief   Send a run of a segment, walked from s to e (row or column t)
+ */
+static void curverun(DrawContextType *ctx, int xmajor, INT s, INT e, INT t, int dashed, int phase) {
+
+    if( dashed ) {
+        if( xmajor )
+            MarkPatternHorizRun(ctx,s,e,t,phase);
+        else
+            MarkPatternVertRun(ctx,t,s,e,phase);
+    } else if( xmajor ) {
+        MARKHRUN(ctx,s < e ? s : e,s < e ? e : s,t);
+    } else {
+        MARKVRUN(ctx,t,s < e ? s : e,s < e ? e : s);
+    }
+}
+
+
+/**
+ * @brief   Draw a segment from (x1,y1) to (x2,y2)
+ *
+ * @note    The points are the same as the ones of drawlinebctx, sent in order.
+ *          The first one is sent only if first is not zero.
+ *
+ * @note    In MARK_LINE_RUNS mode, points sharing a row (column) are sent as a
+ *          run
+ *
+ * @note    With a dash pattern, the phase is carried thru the loop and goes
+ *          on after the last point (even if clipped). Runs are sent thru
+ *          MarkPatternHorizRun and MarkPatternVertRun.
+ */
+void drawsegmentctx(DrawContextType *ctx, INT x1, INT y1, INT x2, INT y2, int first) {
+MarkClipType clip;
+MarkLineStepType ls;
+LONG64 n1,n2,n,k,rem,cnt,len;
+INT dx,dy,t,x,y,s,e;
+int rev,xmajor,runs,dashed,p0,ph,ps;
+
+    // The pattern goes on after the segment, even if it is clipped
+    dashed = ctx->patternlen > 0;
+    p0 = ctx->patternphase;
+    if( dashed ) {
+        len = (LONG64) ABS((LONG64) x2-x1) > (LONG64) ABS((LONG64) y2-y1) ?
+              (LONG64) ABS((LONG64) x2-x1) : (LONG64) ABS((LONG64) y2-y1);
+        ctx->patternphase = (int) ((p0+len+(first ? 1 : 0))%ctx->patternlen);
+    }
+
+    if( !MarkGetClip(ctx,&clip) ) return;
+
+    // Same ordering as drawlinebctx (dy >= 0), walked back if swapped
+    rev = y2 < y1;
+    if( rev ) {
+        t = x1; x1 = x2; x2 = t;
+        t = y1; y1 = y2; y2 = t;
+    }
+    dx = x2 - x1;
+    dy = y2 - y1;
+    xmajor = dy <= ABS(dx);
+    if( xmajor ) {
+        ls.len = ABS(dx);
+        ls.major = x1;
+        ls.majorinc = (dx >= 0)?1:-1;
+        ls.minor = y1;
+        ls.minorinc = 1;
+        ls.p = 2*(LONG64)dy;
+        ls.q = ls.len;
+        ls.r = ls.len?2*ls.len:1;
+        if( !MarkClipLineSteps(&ls,clip.xmin,clip.xmax,clip.ymin,clip.ymax,&n1,&n2) )
+            return;
+    } else {
+        ls.len = dy;
+        ls.major = y1;
+        ls.majorinc = 1;
+        ls.minor = x1;
+        ls.minorinc = (dx >= 0)?1:-1;
+        ls.p = 2*(LONG64)ABS(dx);
+        ls.q = ls.len;
+        ls.r = ls.len?2*ls.len:1;
+        if( !MarkClipLineSteps(&ls,clip.ymin,clip.ymax,clip.xmin,clip.xmax,&n1,&n2) )
+            return;
+    }
+
+    // The first point is step 0, or the last step if walked back
+    if( !first ) {
+        if( !rev && n1 == 0 ) n1 = 1;
+        if( rev && n2 == ls.len ) n2 = ls.len-1;
+        if( n1 > n2 ) return;
+    }
+
+    n = rev ? n2 : n1;
+    k = MarkLineStepsK(&ls,n);
+    rem = n*ls.p + ls.q - k*ls.r;
+    runs = ctx->linemode == MARK_LINE_RUNS;
+    s = e = ls.major + (INT) n*ls.majorinc;
+    // Phase of the first point: steps walked before it
+    ph = ps = 0;
+    if( dashed ) {
+        ph = (int) ((p0+(rev ? ls.len-n2 : n1)-(first ? 0 : 1))%ctx->patternlen);
+        ps = ph;
+    }
+    for(cnt=n2-n1+1;cnt>0;cnt--) {
+        e = ls.major + (INT) n*ls.majorinc;
+        if( !runs ) {
+            x = xmajor ? e : ls.minor + (INT) k*ls.minorinc;
+            y = xmajor ? ls.minor + (INT) k*ls.minorinc : e;
+            if( !dashed || MARKPATTERNBIT(ctx,ph) ) MARKPOINTIN(ctx,x,y);
+        }
+        if( dashed ) MARKPATTERNSTEP(ctx,ph);
+        if( cnt == 1 ) break;
+        // Next step. The minor axis changes at most by one
+        if( !rev ) {
+            n++;
+            rem += ls.p;
+            if( rem < ls.r ) continue;
+            rem -= ls.r;
+        } else {
+            n--;
+            rem -= ls.p;
+            if( rem >= 0 ) continue;
+            rem += ls.r;
+        }
+        if( runs ) {
+            curverun(ctx,xmajor,s,e,ls.minor + (INT) k*ls.minorinc,dashed,ps);
+            s = ls.major + (INT) n*ls.majorinc;
+            ps = ph;
+        }
+        k += rev ? -1 : 1;
+    }
+    if( runs )
+        curverun(ctx,xmajor,s,e,ls.minor + (INT) k*ls.minorinc,dashed,ps);
+}
+
+
+/**
+ * @brief   Draw a polyline of n vertices (n-1 segments)
+ */
+void drawpolylinectx(DrawContextType *ctx, const INT *x, const INT *y, int n) {
+
+    if( n <= 0 ) return;
+    if( n == 1 ) {
+        drawsegmentctx(ctx,x[0],y[0],x[0],y[0],1);
+        return;
+    }
+    for(int i=0;i<n-1;i++)
+        drawsegmentctx(ctx,x[i],y[i],x[i+1],y[i+1],i == 0);
+}
+
+
+/**
+ * @brief   Edge of a filled polygon
+ *
+ * @note    The edge crosses the row y at x + r/dy (0 <= r < dy). It is stepped
+ *          from one row to the next with an error term, as in Bresenham
+ *          (dx = q*dy + m). It covers the rows y1 <= y < y2. dir is the
+ *          winding (+1 going down, -1 going up).
+ */
+typedef struct {
+    INT         y1,y2;
+    INT         x;
+    LONG64      r,dx,dy,q,m;
+    int         dir;
+} CurveEdgeType;
+
+
+/**
+ * @brief   Integer division rounding toward -infinity (b > 0)
+ */
+static LONG64 curvefloordiv(LONG64 a, LONG64 b) {
+LONG64 q = a/b;
+
+    if( a%b != 0 && a < 0 ) q--;
+    return q;
+}
+
+
+/**
+ * @brief   Order of the edges by their first row
+ */
+static int curveedgecmp(const void *a, const void *b) {
+const CurveEdgeType *ea = (const CurveEdgeType *) a;
+const CurveEdgeType *eb = (const CurveEdgeType *) b;
+
+    return (ea->y1 > eb->y1) - (ea->y1 < eb->y1);
+}
+
+
+/**
+ * @brief   Order of the crossings of two edges
+ */
+static int curveedgeless(const CurveEdgeType *a, const CurveEdgeType *b) {
+
+    if( a->x != b->x ) return a->x < b->x;
+    return a->r*b->dy < b->r*a->dy;
+}
+
+
+/**
+ * @brief   Fill a polygon of n vertices
+ *
+ * @note    A pixel is filled if its center is inside. Centers on an edge are
+ *          inside if the polygon is on their right (or below, for the
+ *          horizontal edges). So polygons sharing an edge do not overlap and
+ *          a rectangle from (0,0) to (w,h) fills w*h pixels.
+ *
+ * @note    Scanline with an active edge table: the edges are sorted by their
+ *          first row, and the active ones by their crossing (insertion sort:
+ *          the order changes only where the edges cross). Each pair of
+ *          crossings is sent as a span, so the cost is O(rows+edges) calls.
+ *
+ * @note    Self-intersecting polygons use the even-odd or the non-zero rule
+ *
+ * @note    The rows are swept once, top down: a mapped screen reads them
+ *          ahead (see ScreenAdviseRows)
+ */
+void fillpolygonctx(DrawContextType *ctx, const INT *x, const INT *y, int n,
+                    CurveFillRuleType rule) {
+MarkClipType clip;
+CurveEdgeType *edges,*e,*t,**act;
+LONG64 ymin,ymax,row,k;
+INT x1 = 0,x2;
+int ne,na,next,w,w0,j;
+
+    if( n < 3 ) return;
+    if( !MarkGetClip(ctx,&clip) ) return;
+
+    edges = (CurveEdgeType *) malloc(n*sizeof(CurveEdgeType));
+    act = (CurveEdgeType **) malloc(n*sizeof(CurveEdgeType *));
+    if( !edges || !act ) {
+        free(edges);
+        free(act);
+        return;
+    }
+
+    // Edges, but the horizontal ones
+    ne = 0;
+    ymin = INT_MAX;
+    ymax = INT_MIN;
+    for(int i=0;i<n;i++) {
+        j = (i+1)%n;
+        if( y[i] == y[j] ) continue;
+        e = &edges[ne++];
+        e->dir = (y[i] < y[j]) ? 1 : -1;
+        if( e->dir > 0 ) {
+            e->y1 = y[i];
+            e->y2 = y[j];
+            e->x = x[i];
+            e->dx = (LONG64) x[j]-x[i];
+        } else {
+            e->y1 = y[j];
+            e->y2 = y[i];
+            e->x = x[j];
+            e->dx = (LONG64) x[i]-x[j];
+        }
+        e->dy = (LONG64) e->y2-e->y1;
+        e->r = 0;
+        e->q = curvefloordiv(e->dx,e->dy);
+        e->m = e->dx-e->q*e->dy;
+        if( e->y1 < ymin ) ymin = e->y1;
+        if( e->y2 > ymax ) ymax = e->y2;
+    }
+    qsort(edges,ne,sizeof(CurveEdgeType),curveedgecmp);
+
+    if( ymin < clip.ymin ) ymin = clip.ymin;
+    if( ymax > (LONG64) clip.ymax+1 ) ymax = (LONG64) clip.ymax+1;
+    if( ctx->screen && ymin < ymax )
+        ScreenAdviseRows(ctx->screen,(INT) ymin,(INT) (ymax-1),SCREEN_ADVISE_SEQUENTIAL);
+    na = 0;
+    next = 0;
+    for(row=ymin;row<ymax;row++) {
+        // Step the active edges to this row. Remove the ones that end
+        w = 0;
+        for(int i=0;i<na;i++) {
+            e = act[i];
+            if( e->y2 <= row ) continue;
+            e->x += (INT) e->q;
+            e->r += e->m;
+            if( e->r >= e->dy ) {
+                e->r -= e->dy;
+                e->x++;
+            }
+            act[w++] = e;
+        }
+        na = w;
+        // Add the edges that start (or all the ones above the clip)
+        for(;next < ne && edges[next].y1 <= row;next++) {
+            e = &edges[next];
+            if( e->y2 <= row ) continue;
+            k = curvefloordiv((row-e->y1)*e->dx,e->dy);
+            e->r = (row-e->y1)*e->dx-k*e->dy;
+            e->x = (INT) (e->x+k);
+            act[na++] = e;
+        }
+        // Sort by crossing
+        for(int i=1;i<na;i++) {
+            t = act[i];
+            for(j=i;j>0 && curveedgeless(t,act[j-1]);j--) act[j] = act[j-1];
+            act[j] = t;
+        }
+
+        // Spans. Pixel x is inside between the crossings xa and xb if
+        // xa <= x < xb
+        w = 0;
+        for(int i=0;i<na;i++) {
+            e = act[i];
+            w0 = w;
+            if( rule == CURVE_EVENODD )
+                w ^= 1;
+            else
+                w += e->dir;
+            if( w0 == 0 ) {
+                x1 = e->x + (e->r > 0);
+                continue;
+            }
+            if( w != 0 ) continue;
+            x2 = e->x + (e->r > 0) - 1;
+            if( x1 < clip.xmin ) x1 = clip.xmin;
+            if( x2 > clip.xmax ) x2 = clip.xmax;
+            if( x1 <= x2 ) MARKHRUN(ctx,x1,x2,(INT) row);
+        }
+    }
+    if( ctx->screen && ymin < ymax )
+        ScreenAdviseRows(ctx->screen,(INT) ymin,(INT) (ymax-1),SCREEN_ADVISE_RANDOM);
+    free(edges);
+    free(act);
+}
+
+
+/**
+ * @brief   Draw a closed polygon of n vertices (n segments)
+ *
+ * @note    Each segment sends all its points but the first one, so the first
+ *          vertex is sent by the last segment
+ *
+ * @note    In fill mode, the polygon is filled with the even-odd rule
+ */
+void drawpolygonctx(DrawContextType *ctx, const INT *x, const INT *y, int n) {
+
+    if( ctx->drawmode == MARK_FILL ) {
+        fillpolygonctx(ctx,x,y,n,CURVE_EVENODD);
+        return;
+    }
+    if( n <= 0 ) return;
+    if( n == 1 ) {
+        drawsegmentctx(ctx,x[0],y[0],x[0],y[0],1);
+        return;
+    }
+    for(int i=0;i<n;i++)
+        drawsegmentctx(ctx,x[i],y[i],x[(i+1)%n],y[(i+1)%n],0);
+}
+
+
+/**
+ * @brief   Pen used to send the points of a curve
+ *
+ * @note    The last point is held until the next one is known
+ */
+typedef struct {
+    DrawContextType    *ctx;
+    MarkClipType        clip;
+    int                 inside;             // Bounding box inside the clip
+    int                 n;                  // Points received (up to 2)
+    INT                 ax,ay;              // Last point sent
+    INT                 bx,by;              // Held point
+} CurvePenType;
+
+
+/**
+ * @brief   Send a point of the curve, if inside the clip and on in the dash
+ *          pattern (the phase goes on for clipped points too)
+ */
+static void curvesend(CurvePenType *pen, INT x, INT y) {
+DrawContextType *ctx = pen->ctx;
+int on = 1;
+
+    if( ctx->patternlen ) {
+        on = (int) MARKPATTERNBIT(ctx,ctx->patternphase);
+        MARKPATTERNSTEP(ctx,ctx->patternphase);
+    }
+    if( on && (pen->inside || (x >= pen->clip.xmin && x <= pen->clip.xmax &&
+                               y >= pen->clip.ymin && y <= pen->clip.ymax)) )
+        MARKPOINTIN(ctx,x,y);
+}
+
+
+static void curvepen(CurvePenType *pen, INT x, INT y) {
+
+    if( pen->n > 0 && x == pen->bx && y == pen->by ) return;
+    if( pen->n > 1 && ABS(x-pen->ax) == 1 && ABS(y-pen->ay) == 1 ) {
+        // Corner of a staircase. The held point is not needed
+        pen->bx = x;
+        pen->by = y;
+        return;
+    }
+    if( pen->n > 0 ) {
+        curvesend(pen,pen->bx,pen->by);
+        pen->ax = pen->bx;
+        pen->ay = pen->by;
+        pen->n = 2;
+    } else {
+        pen->n = 1;
+    }
+    pen->bx = x;
+    pen->by = y;
+}
+
+
+/**
+ * @brief   Nearest integer of v/2^f
+ */
+static INT curveround(CURVEWIDE v, int f) {
+CURVEWIDE one = (CURVEWIDE) 1 << f;
+CURVEWIDE q;
+
+    v += one/2;
+    q = v/one;
+    if( v%one != 0 && v < 0 ) q--;
+    return (INT) q;
+}
+
+
+/**
+ * @brief   Test if a step stays within one pixel of its start
+ *
+ * @note    The step a*s^3 + b*s^2 + c*s (0 <= s <= 1) is a Bézier curve whose
+ *          control points are 0, c/3, (2*c+b)/3 and a+b+c. It is inside
+ *          their hull, so loops shorter than a step are not missed.
+ */
+static int curvesmall(CURVEWIDE a, CURVEWIDE b, CURVEWIDE c, CURVEWIDE one) {
+
+    return ABS(c) <= 3*one && ABS(2*c+b) <= 3*one && ABS(a+b+c) <= one;
+}
+
+
+/**
+ * @brief   Draw a Bézier curve from its polynomial (degree 2 or 3)
+ *
+ * @note    (x0,y0) is the first control point and the coefficients are
+ *          relative to it. size is the largest distance between two
+ *          consecutive control points
+ */
+static void curvedraw(DrawContextType *ctx, INT x0, INT y0, const LONG64 *ax,
+                      const LONG64 *ay, int degree, LONG64 size,
+                      INT xmin, INT ymin, INT xmax, INT ymax) {
+CurvePenType pen;
+MarkClipResultType cr;
+CURVEWIDE a[2],b[2],c[2],d[2],one;
+LONG64 rem,step;
+int f,l,j;
+
+    if( !MarkGetClip(ctx,&pen.clip) ) return;
+    cr = MarkClipBox(ctx,xmin,ymin,xmax,ymax);
+    // Dashed curves are walked anyway, for the phase of the next figure
+    if( cr == MARK_OUTSIDE && !ctx->patternlen ) return;
+    pen.ctx = ctx;
+    pen.inside = cr == MARK_INSIDE;
+    pen.n = 0;
+
+    // Finest step: 2^-l, moving at most degree*size/2^l <= 1 pixel
+    for(l=0;((LONG64) 1 << l) < degree*size;l++);
+    f = 3*l+1;
+    one = (CURVEWIDE) 1 << f;
+
+    for(int i=0;i<2;i++) {
+        const LONG64 *p = i ? ay : ax;
+        a[i] = (CURVEWIDE) p[3] << f;
+        b[i] = (CURVEWIDE) p[2] << f;
+        c[i] = (CURVEWIDE) p[1] << f;
+        d[i] = 0;
+    }
+
+    curvepen(&pen,x0,y0);
+    rem = (LONG64) 1 << l;
+    j = 0;
+    while( rem > 0 ) {
+        step = (LONG64) 1 << (l-j);
+        // Halve while the step can move more than one pixel, or goes too far
+        while( j < l ) {
+            if( step <= rem && curvesmall(a[0],b[0],c[0],one) &&
+                curvesmall(a[1],b[1],c[1],one) )
+                break;
+            for(int i=0;i<2;i++) {
+                a[i] /= 8;
+                b[i] /= 4;
+                c[i] /= 2;
+            }
+            j++;
+            step >>= 1;
+        }
+        // Double while the doubled step moves at most one pixel
+        while( j > 0 && 2*step <= rem ) {
+            if( !curvesmall(8*a[0],4*b[0],2*c[0],one) ||
+                !curvesmall(8*a[1],4*b[1],2*c[1],one) )
+                break;
+            for(int i=0;i<2;i++) {
+                a[i] *= 8;
+                b[i] *= 4;
+                c[i] *= 2;
+            }
+            j--;
+            step <<= 1;
+        }
+
+        // Shift the polynomial by one step
+        for(int i=0;i<2;i++) {
+            d[i] += a[i]+b[i]+c[i];
+            c[i] += 3*a[i]+2*b[i];
+            b[i] += 3*a[i];
+        }
+        rem -= step;
+        curvepen(&pen,x0+curveround(d[0],f),y0+curveround(d[1],f));
+    }
+    if( pen.n > 0 ) curvesend(&pen,pen.bx,pen.by);
+}
+
+
+/**
+ * @brief   Bounding box of the control points and largest distance between
+ *          consecutive ones
+ *
+ * @return  0 if the curve is too large
+ */
+static int curvebox(const INT *x, const INT *y, int n, INT *xmin, INT *ymin,
+                    INT *xmax, INT *ymax, LONG64 *size) {
+LONG64 t;
+
+    *xmin = *xmax = x[0];
+    *ymin = *ymax = y[0];
+    *size = 0;
+    for(int i=1;i<n;i++) {
+        if( x[i] < *xmin ) *xmin = x[i];
+        if( x[i] > *xmax ) *xmax = x[i];
+        if( y[i] < *ymin ) *ymin = y[i];
+        if( y[i] > *ymax ) *ymax = y[i];
+        t = ABS((LONG64) x[i]-x[i-1]);
+        if( t > *size ) *size = t;
+        t = ABS((LONG64) y[i]-y[i-1]);
+        if( t > *size ) *size = t;
+    }
+    return (LONG64) *xmax-*xmin <= CURVE_MAXSIZE && (LONG64) *ymax-*ymin <= CURVE_MAXSIZE;
+}
+
+
+/**
+ * @brief   Draw a quadratic Bézier curve from (x0,y0) to (x2,y2)
+ *
+ * @note    Curves are open, so the fill mode draws the contour
+ */
+void drawquadbezierctx(DrawContextType *ctx, INT x0, INT y0, INT x1, INT y1,
+                       INT x2, INT y2) {
+INT px[3] = { x0, x1, x2 };
+INT py[3] = { y0, y1, y2 };
+LONG64 ax[4],ay[4],size;
+INT xmin,ymin,xmax,ymax;
+
+    if( !curvebox(px,py,3,&xmin,&ymin,&xmax,&ymax,&size) ) return;
+    for(int i=0;i<2;i++) {
+        LONG64 *a = i ? ay : ax;
+        INT *p = i ? py : px;
+        a[3] = 0;
+        a[2] = (LONG64) p[0]-2*(LONG64) p[1]+p[2];
+        a[1] = 2*((LONG64) p[1]-p[0]);
+        a[0] = 0;
+    }
+    curvedraw(ctx,x0,y0,ax,ay,2,size,xmin,ymin,xmax,ymax);
+}
+
+
+/**
+ * @brief   Draw a cubic Bézier curve from (x0,y0) to (x3,y3)
+ *
+ * @note    Curves are open, so the fill mode draws the contour
+ */
+void drawcubicbezierctx(DrawContextType *ctx, INT x0, INT y0, INT x1, INT y1,
+                        INT x2, INT y2, INT x3, INT y3) {
+INT px[4] = { x0, x1, x2, x3 };
+INT py[4] = { y0, y1, y2, y3 };
+LONG64 ax[4],ay[4],size;
+INT xmin,ymin,xmax,ymax;
+
+    if( !curvebox(px,py,4,&xmin,&ymin,&xmax,&ymax,&size) ) return;
+    for(int i=0;i<2;i++) {
+        LONG64 *a = i ? ay : ax;
+        INT *p = i ? py : px;
+        a[3] = -(LONG64) p[0]+3*(LONG64) p[1]-3*(LONG64) p[2]+p[3];
+        a[2] = 3*((LONG64) p[0]-2*(LONG64) p[1]+p[2]);
+        a[1] = 3*((LONG64) p[1]-p[0]);
+        a[0] = 0;
+    }
+    curvedraw(ctx,x0,y0,ax,ay,3,size,xmin,ymin,xmax,ymax);
+}
+
+
+/**
+ * @brief   Old interface. Draw on markscreen using the global variables
+ *
+ * @note    A context is built from them at each call (see MarkGlobalContext)
+ */
+///@{
+void drawquadbezier(INT x0, INT y0, INT x1, INT y1, INT x2, INT y2) {
+DrawContextType ctx;
+
+    MarkGlobalContext(&ctx);
+    drawquadbezierctx(&ctx,x0,y0,x1,y1,x2,y2);
+}
+
+void drawcubicbezier(INT x0, INT y0, INT x1, INT y1, INT x2, INT y2, INT x3, INT y3) {
+DrawContextType ctx;
+
+    MarkGlobalContext(&ctx);
+    drawcubicbezierctx(&ctx,x0,y0,x1,y1,x2,y2,x3,y3);
+}
+
+void drawpolyline(const INT *x, const INT *y, int n) {
+DrawContextType ctx;
+
+    MarkGlobalContext(&ctx);
+    drawpolylinectx(&ctx,x,y,n);
+}
+
+void drawpolygon(const INT *x, const INT *y, int n) {
+DrawContextType ctx;
+
+    MarkGlobalContext(&ctx);
+    drawpolygonctx(&ctx,x,y,n);
+}
+
+void fillpolygon(const INT *x, const INT *y, int n, CurveFillRuleType rule) {
+DrawContextType ctx;
+
+    MarkGlobalContext(&ctx);
+    fillpolygonctx(&ctx,x,y,n,rule);
+}
+///@}
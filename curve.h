@@ -0,0 +1,48 @@
+#ifndef CURVE_H
+#define CURVE_H
+/**
+ * @file    curve.h
+ * @brief   Quadratic and cubic Bézier curves, polylines and polygons (drawn
+ *          or filled)
+ *
+ * @note    Points are sent in order, from the first control point (vertex) to
+ *          the last one. A joint shared by two segments is sent once.
+ *
+ * @version 1.0
+ * Date:    17/10/2026
+ *
+ */
+
+#ifndef INT
+#define INT     int
+#endif
+
+#ifndef LONG
+#define LONG    long
+#endif
+
+#include "mark.h"
+
+/**
+ * @brief   Rules to fill self-intersecting polygons
+ */
+typedef enum { CURVE_EVENODD, CURVE_NONZERO } CurveFillRuleType;
+
+void drawquadbezier(INT x0, INT y0, INT x1, INT y1, INT x2, INT y2);
+void drawcubicbezier(INT x0, INT y0, INT x1, INT y1, INT x2, INT y2, INT x3, INT y3);
+void drawpolyline(const INT *x, const INT *y, int n);
+void drawpolygon(const INT *x, const INT *y, int n);
+void fillpolygon(const INT *x, const INT *y, int n, CurveFillRuleType rule);
+
+void drawquadbezierctx(DrawContextType *ctx, INT x0, INT y0, INT x1, INT y1,
+                       INT x2, INT y2);
+void drawcubicbezierctx(DrawContextType *ctx, INT x0, INT y0, INT x1, INT y1,
+                        INT x2, INT y2, INT x3, INT y3);
+void drawpolylinectx(DrawContextType *ctx, const INT *x, const INT *y, int n);
+void drawpolygonctx(DrawContextType *ctx, const INT *x, const INT *y, int n);
+void fillpolygonctx(DrawContextType *ctx, const INT *x, const INT *y, int n,
+                    CurveFillRuleType rule);
+
+void drawsegmentctx(DrawContextType *ctx, INT x1, INT y1, INT x2, INT y2, int first);
+
+#endif // CURVE_H
@@ -0,0 +1,346 @@
+/**
+ * @file    displaylist.c
+ *
+ * @brief   Record line, circle and ellipse commands and render them
+ *
+ * @note    The screen is split in horizontal bands of whole rows. Commands are
+ *          binned by the rows of their bounding box and each band is drawn by
+ *          a worker thread with a context clipped to the band. Since the rows
+ *          of the bitmap are packed, two bands never share a byte and no
+ *          locking is needed for the bitmap.
+ *
+ * @note    Clipping keeps the points of the unclipped figure, so the result is
+ *          bit identical to the serial rendering. The figures are walked only
+ *          over the rows of each band (see DisplayListRenderBand)
+ *
+ * @author  Hans
+ *
+ * @version 1.0
+ *
+ * @date    17/10/2026
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+#include "screen.h"
+#include "mark.h"
+#include "bresenham.h"
+#include "midpoint.h"
+#include "displaylist.h"
+
+/**
+ * @brief   Initial size and number of bands for each thread
+ */
+///@{
+#define DISPLAYLIST_INITIALSIZE     64
+#define DISPLAYLIST_BANDSPERTHREAD  4
+#define DISPLAYLIST_MAXTHREADS      64
+///@}
+
+
+/**
+ * @brief   Rendering job shared by the workers
+ */
+typedef struct {
+    DisplayListType    *dl;
+    ScreenType         *screen;
+    int                 nbands;
+    int                 bandheight;
+    int                *start;          // Bin of band b is bin[start[b]..start[b+1]-1]
+    int                *bin;            // Command indexes
+    int                 next;           // Next band to render
+    pthread_mutex_t     lock;
+} DisplayJobType;
+
+
+/**
+ * @brief   Create an empty display list
+ */
+DisplayListType *DisplayListCreate(void) {
+DisplayListType *dl;
+
+    dl = (DisplayListType *) malloc(sizeof(DisplayListType));
+    if( !dl )
+        return 0;
+
+    dl->cmd = (DisplayCommandType *) malloc(DISPLAYLIST_INITIALSIZE*sizeof(DisplayCommandType));
+    if( !dl->cmd ) {
+        free(dl);
+        return 0;
+    }
+    dl->n = 0;
+    dl->size = DISPLAYLIST_INITIALSIZE;
+    dl->algorithm = DISPLAY_BRESENHAM;
+    dl->drawmode = MARK_CONTOUR;
+
+    return dl;
+}
+
+
+/**
+ * @brief   Free a display list
+ */
+void DisplayListDestroy(DisplayListType *dl) {
+
+    if( !dl ) return;
+    free(dl->cmd);
+    free(dl);
+}
+
+
+/**
+ * @brief   Remove all commands
+ */
+void DisplayListClear(DisplayListType *dl) {
+
+    dl->n = 0;
+}
+
+
+/**
+ * @brief   Set algorithm and mode used by the next commands
+ */
+///@{
+void DisplayListSetAlgorithm(DisplayListType *dl, DisplayAlgorithmType algorithm) {
+
+    dl->algorithm = algorithm;
+}
+
+void DisplayListSetDrawMode(DisplayListType *dl, MarkDrawModeType drawmode) {
+
+    dl->drawmode = drawmode;
+}
+///@}
+
+
+/**
+ * @brief   Append a command
+ *
+ * @return  0 if there is no memory
+ */
+static int DisplayListAdd(DisplayListType *dl, DisplayCommandKindType kind,
+                          INT a, INT b, INT c, INT d, INT ymin, INT ymax) {
+DisplayCommandType *cmd;
+
+    if( dl->n == dl->size ) {
+        cmd = (DisplayCommandType *) realloc(dl->cmd,2*dl->size*sizeof(DisplayCommandType));
+        if( !cmd )
+            return 0;
+        dl->cmd = cmd;
+        dl->size *= 2;
+    }
+    cmd = &(dl->cmd[dl->n++]);
+    cmd->kind = kind;
+    cmd->algorithm = dl->algorithm;
+    cmd->drawmode = dl->drawmode;
+    cmd->a = a;
+    cmd->b = b;
+    cmd->c = c;
+    cmd->d = d;
+    cmd->ymin = ymin;
+    cmd->ymax = ymax;
+    return 1;
+}
+
+
+/**
+ * @brief   Record commands
+ *
+ * @note    Parameters are the same of the corresponding draw routines
+ *
+ * @return  0 if there is no memory
+ */
+///@{
+int DisplayListLine(DisplayListType *dl, INT x1, INT y1, INT x2, INT y2) {
+
+    return DisplayListAdd(dl,DISPLAY_LINE,x1,y1,x2,y2,y1<y2?y1:y2,y1<y2?y2:y1);
+}
+
+int DisplayListCircle(DisplayListType *dl, INT xc, INT yc, INT r) {
+
+    return DisplayListAdd(dl,DISPLAY_CIRCLE,xc,yc,r,r,yc-r,yc+r);
+}
+
+int DisplayListEllipse(DisplayListType *dl, INT xc, INT yc, INT rx, INT ry) {
+
+    return DisplayListAdd(dl,DISPLAY_ELLIPSE,xc,yc,rx,ry,yc-ry,yc+ry);
+}
+///@}
+
+
+/**
+ * @brief   Execute a command
+ */
+static void DisplayListDraw(DrawContextType *ctx, DisplayCommandType *cmd) {
+
+    ctx->drawmode = cmd->drawmode;
+    switch(cmd->kind) {
+    case DISPLAY_LINE:
+        if( cmd->algorithm == DISPLAY_MIDPOINT )
+            drawlinemctx(ctx,cmd->a,cmd->b,cmd->c,cmd->d);
+        else
+            drawlinebctx(ctx,cmd->a,cmd->b,cmd->c,cmd->d);
+        break;
+    case DISPLAY_CIRCLE:
+        if( cmd->algorithm == DISPLAY_MIDPOINT )
+            drawcirclemctx(ctx,cmd->a,cmd->b,cmd->c);
+        else
+            drawcirclebctx(ctx,cmd->a,cmd->b,cmd->c);
+        break;
+    case DISPLAY_ELLIPSE:
+        if( cmd->algorithm == DISPLAY_MIDPOINT )
+            drawellipsemctx(ctx,cmd->a,cmd->b,cmd->c,cmd->d);
+        else
+            drawellipsebctx(ctx,cmd->a,cmd->b,cmd->c,cmd->d);
+        break;
+    }
+}
+
+
+/**
+ * @brief   Render the commands of a band, clipped to its rows
+ *
+ * @note    A figure is not walked from its start in each band: lines start
+ *          at the first step inside the band (MarkClipLineSteps), circles
+ *          and ellipses jump to the steps that reach it (MarkCurveWindows).
+ *          So the work of a band follows its rows, plus a few searches for
+ *          each figure
+ */
+static void DisplayListRenderBand(DisplayJobType *job, int b) {
+DrawContextType ctx;
+INT y1,y2;
+
+    y1 = b*job->bandheight;
+    y2 = y1+job->bandheight-1;
+
+    MarkContextInit(&ctx,job->screen);
+    MarkContextSetClip(&ctx,0,y1,ScreenWidth(job->screen)-1,y2);
+    for(int i=job->start[b];i<job->start[b+1];i++) {
+        DisplayListDraw(&ctx,&(job->dl->cmd[job->bin[i]]));
+    }
+}
+
+
+/**
+ * @brief   Worker thread. Renders bands until there is none left
+ */
+static void *DisplayListWorker(void *arg) {
+DisplayJobType *job = (DisplayJobType *) arg;
+int b;
+
+    for(;;) {
+        pthread_mutex_lock(&job->lock);
+        b = job->next++;
+        pthread_mutex_unlock(&job->lock);
+        if( b >= job->nbands ) break;
+        DisplayListRenderBand(job,b);
+    }
+    return 0;
+}
+
+
+/**
+ * @brief   Bands overlapped by the rows of a command
+ *
+ * @return  0 if the command is outside the screen
+ */
+static int DisplayListBands(DisplayJobType *job, DisplayCommandType *cmd, int *b1, int *b2) {
+INT h = ScreenHeight(job->screen);
+INT ymin,ymax;
+
+    // A negative radius swaps the rows of the box
+    ymin = cmd->ymin < cmd->ymax ? cmd->ymin : cmd->ymax;
+    ymax = cmd->ymin < cmd->ymax ? cmd->ymax : cmd->ymin;
+    if( ymax < 0 || ymin >= h ) return 0;
+    *b1 = (ymin < 0 ? 0 : ymin)/job->bandheight;
+    *b2 = (ymax >= h ? h-1 : ymax)/job->bandheight;
+    return 1;
+}
+
+
+/**
+ * @brief   Draw all commands on the screen using nthreads threads
+ *
+ * @note    With nthreads <= 1, commands are drawn in the calling thread
+ *
+ * @note    If the bins or the threads cannot be allocated, the commands are
+ *          drawn serially
+ */
+void DisplayListRender(DisplayListType *dl, ScreenType *screen, int nthreads) {
+DisplayJobType job;
+pthread_t thread[DISPLAYLIST_MAXTHREADS];
+int b1,b2,total,started;
+INT h;
+
+    if( !dl || !screen || dl->n == 0 ) return;
+
+    h = ScreenHeight(screen);
+    if( nthreads > DISPLAYLIST_MAXTHREADS ) nthreads = DISPLAYLIST_MAXTHREADS;
+    if( nthreads <= 1 || h < 2 ) {
+        DrawContextType ctx;
+        MarkContextInit(&ctx,screen);
+        for(int i=0;i<dl->n;i++)
+            DisplayListDraw(&ctx,&(dl->cmd[i]));
+        return;
+    }
+
+    job.dl = dl;
+    job.screen = screen;
+    job.nbands = nthreads*DISPLAYLIST_BANDSPERTHREAD;
+    if( job.nbands > h ) job.nbands = h;
+    job.bandheight = (h+job.nbands-1)/job.nbands;
+    job.nbands = (h+job.bandheight-1)/job.bandheight;
+    job.next = 0;
+
+    // Bin the commands. First count, then fill, keeping their order
+    job.start = (int *) calloc(job.nbands+1,sizeof(int));
+    if( !job.start ) {
+        DisplayListRender(dl,screen,1);
+        return;
+    }
+    total = 0;
+    for(int i=0;i<dl->n;i++) {
+        if( !DisplayListBands(&job,&(dl->cmd[i]),&b1,&b2) ) continue;
+        for(int b=b1;b<=b2;b++) job.start[b+1]++;
+        total += b2-b1+1;
+    }
+    for(int b=0;b<job.nbands;b++)
+        job.start[b+1] += job.start[b];
+    job.bin = (int *) malloc((total?total:1)*sizeof(int));
+    if( !job.bin ) {
+        free(job.start);
+        DisplayListRender(dl,screen,1);
+        return;
+    }
+    {
+        int *pos = (int *) malloc(job.nbands*sizeof(int));
+        if( !pos ) {
+            free(job.bin);
+            free(job.start);
+            DisplayListRender(dl,screen,1);
+            return;
+        }
+        for(int b=0;b<job.nbands;b++) pos[b] = job.start[b];
+        for(int i=0;i<dl->n;i++) {
+            if( !DisplayListBands(&job,&(dl->cmd[i]),&b1,&b2) ) continue;
+            for(int b=b1;b<=b2;b++) job.bin[pos[b]++] = i;
+        }
+        free(pos);
+    }
+
+    // Render. The calling thread works too
+    pthread_mutex_init(&job.lock,0);
+    started = 0;
+    for(int t=1;t<nthreads;t++) {
+        if( pthread_create(&thread[started],0,DisplayListWorker,&job) != 0 ) break;
+        started++;
+    }
+    DisplayListWorker(&job);
+    for(int t=0;t<started;t++)
+        pthread_join(thread[t],0);
+    pthread_mutex_destroy(&job.lock);
+
+    free(job.bin);
+    free(job.start);
+}
@@ -0,0 +1,59 @@
+#ifndef DISPLAYLIST_H
+#define DISPLAYLIST_H
+/**
+ * @file    displaylist.h
+ * @brief   Display list: record drawing commands and render them in parallel
+ *
+ * @version 1.0
+ * Date:    17/10/2026
+ *
+ */
+
+#ifndef INT
+#define INT     int
+#endif
+
+#ifndef LONG
+#define LONG    long
+#endif
+
+#include "mark.h"
+
+/**
+ * @brief  Commands and algorithms
+ */
+///@{
+typedef enum { DISPLAY_LINE, DISPLAY_CIRCLE, DISPLAY_ELLIPSE } DisplayCommandKindType;
+
+typedef enum { DISPLAY_BRESENHAM, DISPLAY_MIDPOINT } DisplayAlgorithmType;
+
+typedef struct {
+    DisplayCommandKindType  kind;
+    DisplayAlgorithmType    algorithm;
+    MarkDrawModeType        drawmode;
+    INT                     a,b,c,d;        // Parameters as in the draw routines
+    INT                     ymin,ymax;      // Bounding box (rows only)
+} DisplayCommandType;
+
+typedef struct {
+    DisplayCommandType     *cmd;
+    int                     n;              // Commands recorded
+    int                     size;           // Commands allocated
+    DisplayAlgorithmType    algorithm;      // For the next commands
+    MarkDrawModeType        drawmode;       // For the next commands
+} DisplayListType;
+///@}
+
+DisplayListType *DisplayListCreate(void);
+void DisplayListDestroy(DisplayListType *dl);
+void DisplayListClear(DisplayListType *dl);
+void DisplayListSetAlgorithm(DisplayListType *dl, DisplayAlgorithmType algorithm);
+void DisplayListSetDrawMode(DisplayListType *dl, MarkDrawModeType drawmode);
+
+int  DisplayListLine(DisplayListType *dl, INT x1, INT y1, INT x2, INT y2);
+int  DisplayListCircle(DisplayListType *dl, INT xc, INT yc, INT r);
+int  DisplayListEllipse(DisplayListType *dl, INT xc, INT yc, INT rx, INT ry);
+
+void DisplayListRender(DisplayListType *dl, ScreenType *screen, int nthreads);
+
+#endif // DISPLAYLIST_H
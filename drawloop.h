@@ -0,0 +1,328 @@
+#ifndef DRAWLOOP_H
+#define DRAWLOOP_H
+/**
+ * @file    drawloop.h
+ * @brief   Header only Bresenham loops generated for a given sink
+ *
+ * @note    The routines of bresenham.c send each point thru the sinks of the
+ *          context (a test and an indirect call for each pixel, except for the
+ *          default sink). The macros below generate the same loops for a sink
+ *          given by two macros, so the compiler can inline the pixel write:
+ *
+ *              POINT(S,X,Y)        plot a point
+ *              HSPAN(S,X1,X2,Y)    draw a horizontal span (X1 <= X2)
+ *
+ *          S is the state of the sink (a screen, a counter, a span list...),
+ *          passed as the first parameter of the generated routine.
+ *
+ * @note    There is no clipping. The figures must be inside the target (use
+ *          MarkClipBox). The points are the same as those of drawlinebctx,
+ *          drawcirclebctx and drawellipsebctx. Each point is plotted once and
+ *          in fill mode each row is sent once.
+ *
+ * @note    Instances for three sinks are defined here: the bitmap of a PBM
+ *          screen, a pixel counter and a span collector
+ *
+ * @version 1.0
+ * Date:    17/10/2026
+ *
+ */
+
+#ifndef INT
+#define INT     int
+#endif
+
+#ifndef LONG
+#define LONG    long
+#endif
+
+#include "screen.h"
+#include "mark.h"
+
+
+/**
+ * @brief   Line
+ *
+ * @note    Points are ordered so dy >= 0. Ties (|dx| == dy) step in x
+ */
+#define DRAWLOOP_LINE(NAME,STYPE,POINT) \
+static inline void NAME(STYPE S, INT x1, INT y1, INT x2, INT y2) { \
+INT dx,dy,sx,t,x,y; \
+int eps = 0; \
+    if( y2 < y1 ) { \
+        t = x1; x1 = x2; x2 = t; \
+        t = y1; y1 = y2; y2 = t; \
+    } \
+    dx = x2-x1; \
+    dy = y2-y1; \
+    sx = 1; \
+    if( dx < 0 ) { dx = -dx; sx = -1; } \
+    x = x1; \
+    y = y1; \
+    if( dy > dx ) { \
+        for(;y<=y2;y++) { \
+            POINT(S,x,y); \
+            eps += dx; \
+            if( 2*eps >= dy ) { x += sx; eps -= dy; } \
+        } \
+    } else { \
+        for(INT n=0;n<=dx;n++) { \
+            POINT(S,x,y); \
+            eps += dy; \
+            if( 2*eps >= dx ) { y++; eps -= dx; } \
+            x += sx; \
+        } \
+    } \
+}
+
+
+/**
+ * @brief   Points of the four quadrants (or eight octants), each once
+ */
+///@{
+#define DRAWLOOP_QUAD(POINT,S,XC,YC,X,Y) do { \
+    POINT(S,(XC)+(X),(YC)+(Y)); \
+    if( (X) != 0 ) POINT(S,(XC)-(X),(YC)+(Y)); \
+    if( (Y) != 0 ) { \
+        POINT(S,(XC)+(X),(YC)-(Y)); \
+        if( (X) != 0 ) POINT(S,(XC)-(X),(YC)-(Y)); \
+    } \
+} while(0)
+
+#define DRAWLOOP_OCT(POINT,S,XC,YC,X,Y) do { \
+    DRAWLOOP_QUAD(POINT,S,XC,YC,X,Y); \
+    if( (X) != (Y) ) DRAWLOOP_QUAD(POINT,S,XC,YC,Y,X); \
+} while(0)
+
+/*
+ * Rows yc+y and yc-y (once if y == 0) from xc-x to xc+x
+ */
+#define DRAWLOOP_ROWS(HSPAN,S,XC,YC,X,Y) do { \
+    HSPAN(S,(XC)-(X),(XC)+(X),(YC)+(Y)); \
+    if( (Y) != 0 ) HSPAN(S,(XC)-(X),(XC)+(X),(YC)-(Y)); \
+} while(0)
+///@}
+
+
+/**
+ * @brief   Coalesce the rows of a fill (as MarkFillRow)
+ *
+ * @note    Needs the variables fx, fy and pending. x never decreases, so the
+ *          last point of a row is the widest
+ */
+///@{
+#define DRAWLOOP_FILLROW(HSPAN,S,XC,YC,X,Y) do { \
+    if( pending && (Y) != fy ) DRAWLOOP_ROWS(HSPAN,S,XC,YC,fx,fy); \
+    fx = (X); \
+    fy = (Y); \
+    pending = 1; \
+} while(0)
+
+#define DRAWLOOP_FILLEND(HSPAN,S,XC,YC) do { \
+    if( pending ) DRAWLOOP_ROWS(HSPAN,S,XC,YC,fx,fy); \
+} while(0)
+///@}
+
+
+/**
+ * @brief   Circle contour and fill
+ *
+ * @note    In fill mode, rows yc+-xr are final at once. Rows yc+-yr are
+ *          coalesced
+ */
+///@{
+#define DRAWLOOP_CIRCLE(NAME,STYPE,POINT) \
+static inline void NAME(STYPE S, INT xc, INT yc, INT r) { \
+INT xr = 0, yr = r; \
+int e = 3-(r+r); \
+    do { \
+        DRAWLOOP_OCT(POINT,S,xc,yc,xr,yr); \
+        if( e < 0 ) { \
+            e += 4*xr+6; \
+        } else { \
+            yr--; \
+            e += 4*(xr-yr)+10; \
+        } \
+        xr++; \
+    } while( xr <= yr ); \
+}
+
+#define DRAWLOOP_CIRCLEFILL(NAME,STYPE,HSPAN) \
+static inline void NAME(STYPE S, INT xc, INT yc, INT r) { \
+INT xr = 0, yr = r; \
+INT fx = 0, fy = 0; \
+int pending = 0; \
+int e = 3-(r+r); \
+    do { \
+        if( xr < yr ) DRAWLOOP_ROWS(HSPAN,S,xc,yc,yr,xr); \
+        DRAWLOOP_FILLROW(HSPAN,S,xc,yc,xr,yr); \
+        if( e < 0 ) { \
+            e += 4*xr+6; \
+        } else { \
+            yr--; \
+            e += 4*(xr-yr)+10; \
+        } \
+        xr++; \
+    } while( xr <= yr ); \
+    DRAWLOOP_FILLEND(HSPAN,S,xc,yc); \
+}
+///@}
+
+
+/**
+ * @brief   Ellipse contour and fill
+ *
+ * @note    The decision terms use LONG64, so the radii must be at most
+ *          MARK_ELLIPSE_MAXLONG64 (see MarkEllipseRange)
+ *
+ * @note    At each step, STEP(P,S,xc,yc,x,y) is called with the point of the
+ *          first quadrant
+ */
+///@{
+#define DRAWLOOP_ELLIPSEBODY(STEP,P) \
+LONG64 d,dx,dy; \
+LONG64 rx2 = (LONG64) rx*rx, ry2 = (LONG64) ry*ry; \
+LONG64 rx2_x2 = 2*rx2, ry2_x2 = 2*ry2; \
+INT x = 0, y = ry; \
+    STEP(P,S,xc,yc,x,y); \
+    d = 4*ry2 - 4*rx2*ry + rx2; \
+    dx = 4*ry2_x2*x; \
+    dy = 4*rx2_x2*y; \
+    while( dx < dy ) { \
+        x++; \
+        dx += 4*ry2_x2; \
+        if( d < 0 ) { \
+            d += dx + 4*ry2; \
+        } else { \
+            y--; \
+            dy -= 4*rx2_x2; \
+            d += dx - dy + 4*ry2; \
+        } \
+        STEP(P,S,xc,yc,x,y); \
+    } \
+    d = ry2*(2*x+1)*(2*x+1) + rx2*(2*y-2)*(2*y-2)-4*rx2*ry2; \
+    while( y > 0 ) { \
+        y--; \
+        dy -= 4*rx2_x2; \
+        if( d > 0 ) { \
+            d -= dy - 4*rx2; \
+        } else { \
+            x++; \
+            dx += 4*ry2_x2; \
+            d += dx - dy + 4*rx2; \
+        } \
+        STEP(P,S,xc,yc,x,y); \
+    } \
+    while( x < rx ) { \
+        x++; \
+        STEP(P,S,xc,yc,x,y); \
+    }
+
+#define DRAWLOOP_ELLIPSE(NAME,STYPE,POINT) \
+static inline void NAME(STYPE S, INT xc, INT yc, INT rx, INT ry) { \
+    DRAWLOOP_ELLIPSEBODY(DRAWLOOP_QUAD,POINT) \
+}
+
+#define DRAWLOOP_ELLIPSEFILL(NAME,STYPE,HSPAN) \
+static inline void NAME(STYPE S, INT xc, INT yc, INT rx, INT ry) { \
+INT fx = 0, fy = 0; \
+int pending = 0; \
+    DRAWLOOP_ELLIPSEBODY(DRAWLOOP_FILLROW,HSPAN) \
+    DRAWLOOP_FILLEND(HSPAN,S,xc,yc); \
+}
+///@}
+
+
+/**
+ * @brief   Span collector
+ *
+ * @note    Spans are stored in an array given by the user. Points next to the
+ *          last span of the same row extend it. When the array is full, the
+ *          spans are dropped and overflow is set
+ */
+///@{
+typedef struct {
+    INT     x1,x2,y;
+} DrawSpanType;
+
+typedef struct {
+    DrawSpanType   *span;
+    int             n;
+    int             size;
+    int             overflow;
+} DrawSpanListType;
+
+static inline void DrawSpanListInit(DrawSpanListType *l, DrawSpanType *span, int size) {
+
+    l->span = span;
+    l->n = 0;
+    l->size = size;
+    l->overflow = 0;
+}
+
+static inline void DrawSpanAdd(DrawSpanListType *l, INT x1, INT x2, INT y) {
+
+    if( l->n == l->size ) {
+        l->overflow = 1;
+        return;
+    }
+    l->span[l->n].x1 = x1;
+    l->span[l->n].x2 = x2;
+    l->span[l->n].y = y;
+    l->n++;
+}
+
+static inline void DrawSpanAddPoint(DrawSpanListType *l, INT x, INT y) {
+DrawSpanType *last;
+
+    if( l->n > 0 ) {
+        last = &(l->span[l->n-1]);
+        if( last->y == y ) {
+            if( x == last->x2+1 ) { last->x2 = x; return; }
+            if( x == last->x1-1 ) { last->x1 = x; return; }
+        }
+    }
+    DrawSpanAdd(l,x,x,y);
+}
+///@}
+
+
+/**
+ * @brief   Sinks
+ */
+///@{
+#define DRAWSINK_BITMAP_POINT(S,X,Y)        ScreenDrawPointUnsafe((S),(X),(Y))
+#define DRAWSINK_BITMAP_HSPAN(S,X1,X2,Y)    (S)->ops->hline((S),(X1),(X2),(Y))
+#define DRAWSINK_COUNT_POINT(S,X,Y)         ((void) (X), (void) (Y), (*(S))++)
+#define DRAWSINK_COUNT_HSPAN(S,X1,X2,Y)     ((void) (Y), *(S) += (X2)-(X1)+1)
+#define DRAWSINK_SPANS_POINT(S,X,Y)         DrawSpanAddPoint((S),(X),(Y))
+#define DRAWSINK_SPANS_HSPAN(S,X1,X2,Y)     DrawSpanAdd((S),(X1),(X2),(Y))
+///@}
+
+
+/**
+ * @brief   Instances
+ *
+ * @note    The bitmap ones only for PBM screens using data[] (not sparse)
+ */
+///@{
+DRAWLOOP_LINE(drawlinebitmap,ScreenType *,DRAWSINK_BITMAP_POINT)
+DRAWLOOP_CIRCLE(drawcirclebitmap,ScreenType *,DRAWSINK_BITMAP_POINT)
+DRAWLOOP_CIRCLEFILL(drawcirclefillbitmap,ScreenType *,DRAWSINK_BITMAP_HSPAN)
+DRAWLOOP_ELLIPSE(drawellipsebitmap,ScreenType *,DRAWSINK_BITMAP_POINT)
+DRAWLOOP_ELLIPSEFILL(drawellipsefillbitmap,ScreenType *,DRAWSINK_BITMAP_HSPAN)
+
+DRAWLOOP_LINE(drawlinecount,unsigned long *,DRAWSINK_COUNT_POINT)
+DRAWLOOP_CIRCLE(drawcirclecount,unsigned long *,DRAWSINK_COUNT_POINT)
+DRAWLOOP_CIRCLEFILL(drawcirclefillcount,unsigned long *,DRAWSINK_COUNT_HSPAN)
+DRAWLOOP_ELLIPSE(drawellipsecount,unsigned long *,DRAWSINK_COUNT_POINT)
+DRAWLOOP_ELLIPSEFILL(drawellipsefillcount,unsigned long *,DRAWSINK_COUNT_HSPAN)
+
+DRAWLOOP_LINE(drawlinespans,DrawSpanListType *,DRAWSINK_SPANS_POINT)
+DRAWLOOP_CIRCLE(drawcirclespans,DrawSpanListType *,DRAWSINK_SPANS_POINT)
+DRAWLOOP_CIRCLEFILL(drawcirclefillspans,DrawSpanListType *,DRAWSINK_SPANS_HSPAN)
+DRAWLOOP_ELLIPSE(drawellipsespans,DrawSpanListType *,DRAWSINK_SPANS_POINT)
+DRAWLOOP_ELLIPSEFILL(drawellipsefillspans,DrawSpanListType *,DRAWSINK_SPANS_HSPAN)
+///@}
+
+#endif // DRAWLOOP_H
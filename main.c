@@ -18,26 +18,22 @@
 #include "midpoint.h"
 #include "bresenham.h"
 #include "mark.h"
+#include "backend.h"
 
 #define WIDTH               300
 #define HEIGHT              600
 
 
-/* Which routines to test: 1 Bresenham, 2:Midpoint */
-#define TEST  1
-
+/*
+ * Which routines to test: the backend named in the command line (bresenham,
+ * midpoint, wu) or, without it, the best one for this host
+ */
+static const DrawBackendType *backend;
+static DrawContextType ctx;
 
-#if TEST == 1
-#define drawline            drawlineb
-#define drawcircle          drawcircleb
-#define drawellipse         drawellipseb
-#elif TEST == 2
-#define drawline            drawlinem
-#define drawcircle          drawcirclem
-#define drawellipse         drawellipsem
-#else
-#error "No test!!!"
-#endif
+#define drawline(X1,Y1,X2,Y2)       backend->line(&ctx,(X1),(Y1),(X2),(Y2))
+#define drawcircle(XC,YC,R)         backend->circle(&ctx,(XC),(YC),(R))
+#define drawellipse(XC,YC,RX,RY)    backend->ellipse(&ctx,(XC),(YC),(RX),(RY))
 
 
 const int ptcircle[18][2] = {
@@ -73,7 +69,17 @@ INT y1 = 5;
 INT y2 = 20;
 INT y3 = 35;
 
+    backend = DrawBackendSelect(argc>1?argv[1]:0);
+    if( !backend ) {
+        fprintf(stderr,"Unknown backend %s. Use one of:",argv[1]);
+        for(int i=0;i<DrawBackendCount();i++)
+            fprintf(stderr," %s",DrawBackendGet(i)->name);
+        fprintf(stderr,"\n");
+        return 1;
+    }
+
     markscreen=ScreenCreate(WIDTH,HEIGHT);
+    MarkGlobalContext(&ctx);
 
     // Teste1
     ScreenDrawPoint(markscreen,xc,yc);
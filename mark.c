@@ -3,9 +3,10 @@
  *
  * @brief   Routines used by bresenham and midpoint drawing routines
  *
- * @note   They depend on ScreenDrawPoint and MarkHorizLine to draw a point or a horizontal line.
+ * @note   They send points and runs to the sinks of a drawing context. The
+ *         default sinks use ScreenDrawPoint and ScreenDrawHorizLine.
  *
- * @note   The MarkHorizLine is used to fill a circle or a ellipse
+ * @note   ScreenDrawHorizLine is used to fill a circle or a ellipse
  *
  * @author  <Hans>
  *
@@ -16,28 +17,236 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <limits.h>
 #include "screen.h"
 #include "mark.h"
 
 
 ScreenType *markscreen = 0;
 MarkDrawModeType markdrawmode = MARK_CONTOUR;
+MarkLineModeType marklinemode = MARK_LINE_POINTS;
 
 void (*MarkDrawPoint)(INT,INT) = MarkPoint;
 void (*MarkDrawContourQuad)(INT,INT,INT,INT) = MarkBorderPointsQuad;
 void (*MarkDrawContourOct)(INT,INT,INT,INT) = MarkBorderPointsOct;
 void (*MarkDrawFill)(INT,INT,INT,INT) = MarkHorizFill;
+void (*MarkDrawHorizRun)(INT,INT,INT) = MarkHorizRun;
+void (*MarkDrawVertRun)(INT,INT,INT) = MarkVertRun;
 
 
 /**
- * @brief  Short description of function
+ * @brief   Initialize a context to draw on a screen with the default sinks
  *
- * @note   Long description of function
+ * @note    For screens other than PBM, and sparse PBM screens, the point sink
+ *          calls the routine of the format directly (the inline PBM fast path
+ *          and the direct bitmap loops cannot be used)
+ */
+void MarkContextInit(DrawContextType *ctx, ScreenType *screen) {
+
+    ctx->screen = screen;
+    ctx->drawmode = MARK_CONTOUR;
+    ctx->linemode = MARK_LINE_POINTS;
+    if( screen && (screen->fmt != PBM || screen->tiles) )
+        ctx->point = MarkScreenPointFormat;
+    else
+        ctx->point = MarkScreenPoint;
+    ctx->hrun = MarkScreenHorizRun;
+    ctx->vrun = MarkScreenVertRun;
+    ctx->blend = MarkScreenBlend;
+    ctx->user = 0;
+    ctx->clipped = 0;
+    ctx->fillpending = 0;
+    ctx->order = MARK_ORDER_MIRROR;
+    ctx->orderbuf = 0;
+    ctx->ordersize = ctx->ordern = 0;
+    ctx->ordering = 0;
+    ctx->pattern = 0;
+    ctx->patternlen = 0;
+    ctx->patternphase = 0;
+}
+
+
+/**
+ * @brief   Set a clipping window (inclusive) for a context
  *
- * @param  Description of parameter
+ * @note    It is intersected with the screen. Used to draw only a part (tile)
+ *          of the screen.
+ */
+void MarkContextSetClip(DrawContextType *ctx, INT xmin, INT ymin, INT xmax, INT ymax) {
+
+    ctx->clip.xmin = xmin;
+    ctx->clip.ymin = ymin;
+    ctx->clip.xmax = xmax;
+    ctx->clip.ymax = ymax;
+    ctx->clipped = 1;
+}
+
+void MarkContextResetClip(DrawContextType *ctx) {
+
+    ctx->clipped = 0;
+}
+
+
+/**
+ * @brief   Set the order of the points of circles and ellipses
  *
- * @return Description of return parameters
+ * @note    MARK_ORDER_PATH needs storage for an octant (a quadrant for
+ *          ellipses): about 0.71*r points for a circle and rx+ry+1 for an
+ *          ellipse. Larger figures are sent mirrored.
  */
+void MarkContextSetOrder(DrawContextType *ctx, MarkOrderType order,
+                         MarkPointType *buf, size_t size) {
+
+    if( !buf || size == 0 ) order = MARK_ORDER_MIRROR;
+    ctx->order = order;
+    ctx->orderbuf = buf;
+    ctx->ordersize = buf ? size : 0;
+    ctx->ordern = 0;
+    ctx->ordering = 0;
+}
+
+
+/**
+ * @brief   Set a dash pattern (len bits of pattern, the first point is bit
+ *          len-1) or solid lines (len 0)
+ *
+ * @note    The phase starts at the first bit and goes on from one figure to
+ *          the next, so the segments of a polyline are dashed as one line.
+ *          Set the pattern again to restart it.
+ *
+ * @note    Dashed: lines and polylines (also in runs mode), Bézier curves,
+ *          circles of drawcirclebctx and drawcirclemctx (each octant from
+ *          its axis, so the dash is symmetric) and all circles and ellipses
+ *          in MARK_ORDER_PATH (along the whole curve). A circle whose octant
+ *          does not fit the buffer of the path order is dashed by octants.
+ *          Other figures and fills are solid.
+ *
+ * @note    The masks of 8 points from each phase are built here, so runs on
+ *          a PBM screen are masked a byte at a time
+ */
+void MarkContextSetPattern(DrawContextType *ctx, uint64_t pattern, int len) {
+int p;
+
+    if( len < 0 || len > MARK_PATTERNMAX ) len = 0;
+    ctx->pattern = pattern;
+    ctx->patternlen = len;
+    ctx->patternphase = 0;
+    for(int i=0;i<len;i++) {
+        ctx->patternmask[0][i] = ctx->patternmask[1][i] = 0;
+        for(int b=0;b<8;b++) {
+            p = (i+b)%len;
+            ctx->patternmask[0][i] |= (unsigned char) (MARKPATTERNBIT(ctx,p) << (7-b));
+            p = ((i-b)%len+len)%len;
+            ctx->patternmask[1][i] |= (unsigned char) (MARKPATTERNBIT(ctx,p) << (7-b));
+        }
+    }
+}
+
+
+/**
+ * @brief   Send the points of a run that are on in the dash pattern
+ *
+ * @note    The run is walked from xs (ys) to xe (ye). The first point has the
+ *          given phase. With the default sink, the run is masked by
+ *          ScreenDrawHorizPattern. Otherwise, the parts on are sent as runs
+ */
+///@{
+void MarkPatternHorizRun(DrawContextType *ctx, INT xs, INT xe, INT y, int phase) {
+int step = xs <= xe ? 1 : -1;
+INT s = 0;
+int on = 0;
+
+    if( ctx->hrun == MarkScreenHorizRun && ctx->screen ) {
+        if( step > 0 )
+            ScreenDrawHorizPattern(ctx->screen,xs,xe,y,ctx->patternmask[0],ctx->patternlen,phase,1);
+        else
+            ScreenDrawHorizPattern(ctx->screen,xe,xs,y,ctx->patternmask[1],ctx->patternlen,
+                                   (int) ((phase+(LONG64) xs-xe)%ctx->patternlen),-1);
+        return;
+    }
+    for(INT x=xs;;x+=step) {
+        if( MARKPATTERNBIT(ctx,phase) ) {
+            if( !on ) s = x;
+            on = 1;
+        } else if( on ) {
+            MARKHRUN(ctx,s < x ? s : x-step,s < x ? x-step : s,y);
+            on = 0;
+        }
+        MARKPATTERNSTEP(ctx,phase);
+        if( x == xe ) break;
+    }
+    if( on ) MARKHRUN(ctx,s < xe ? s : xe,s < xe ? xe : s,y);
+}
+
+void MarkPatternVertRun(DrawContextType *ctx, INT x, INT ys, INT ye, int phase) {
+int step = ys <= ye ? 1 : -1;
+INT s = 0;
+int on = 0;
+
+    for(INT y=ys;;y+=step) {
+        if( MARKPATTERNBIT(ctx,phase) ) {
+            if( !on ) s = y;
+            on = 1;
+        } else if( on ) {
+            MARKVRUN(ctx,x,s < y ? s : y-step,s < y ? y-step : s);
+            on = 0;
+        }
+        MARKPATTERNSTEP(ctx,phase);
+        if( y == ye ) break;
+    }
+    if( on ) MARKVRUN(ctx,x,s < ye ? s : ye,s < ye ? ye : s);
+}
+///@}
+
+
+/**
+ * @brief   Sinks calling the callbacks of the old interface
+ */
+///@{
+static void MarkGlobalPoint(DrawContextType *ctx, INT x, INT y) {
+
+    (void) ctx;
+    if( MarkDrawPoint ) MarkDrawPoint(x,y);
+}
+
+static void MarkGlobalHorizRun(DrawContextType *ctx, INT x1, INT x2, INT y) {
+
+    (void) ctx;
+    if( MarkDrawHorizRun ) MarkDrawHorizRun(x1,x2,y);
+}
+
+static void MarkGlobalVertRun(DrawContextType *ctx, INT x, INT y1, INT y2) {
+
+    (void) ctx;
+    if( MarkDrawVertRun ) MarkDrawVertRun(x,y1,y2);
+}
+///@}
+
+
+/**
+ * @brief   Build a context from the global variables of the old interface
+ *
+ * @note    When the callbacks are the default ones, the default sinks are used.
+ *          Otherwise, the sinks call them.
+ */
+void MarkGlobalContext(DrawContextType *ctx) {
+
+    MarkContextInit(ctx,markscreen);
+    ctx->drawmode = markdrawmode;
+    ctx->linemode = marklinemode;
+    if( MarkDrawPoint != MarkPoint )
+        ctx->point = MarkGlobalPoint;
+    if( MarkDrawHorizRun != MarkHorizRun )
+        ctx->hrun = MarkGlobalHorizRun;
+    if( MarkDrawVertRun != MarkVertRun )
+        ctx->vrun = MarkGlobalVertRun;
+}
+
+
+/**
+ * @brief   Default callbacks of the old interface. They draw on markscreen
+ */
+///@{
 void MarkPoint(INT x, INT y) {
 
     if( !markscreen ) return;
@@ -45,36 +254,208 @@ void MarkPoint(INT x, INT y) {
     ScreenDrawPoint(markscreen,x,y);
 }
 
+void MarkHorizRun(INT x1, INT x2, INT y) {
+
+    if( !markscreen ) return;
+
+    ScreenDrawHorizLine(markscreen,x1,x2,y);
+}
+
+void MarkVertRun(INT x, INT y1, INT y2) {
+
+    if( !markscreen ) return;
+
+    ScreenDrawVertLine(markscreen,x,y1,y2);
+}
+///@}
+
 
 /**
- * @brief   Plot points on markscreen mirroing along the axes
+ * @brief   Mirrored points and fill rows of the old interface
  *
- * @note    <bla bla bla>
+ * @note    They draw with the context of the global variables (see
+ *          MarkGlobalContext). The routines with a context are
+ *          MarkBorderPointsQuadCtx, MarkBorderPointsOctCtx and MarkHorizFillCtx
  */
-
+///@{
 void MarkBorderPointsQuad(INT xc, INT yc, INT x, INT y) {
+DrawContextType ctx;
 
-    if( !markscreen ) return;
+    MarkGlobalContext(&ctx);
+    MarkBorderPointsQuadCtx(&ctx,xc,yc,x,y);
+}
 
-    ScreenDrawPoint(markscreen,xc+x,yc+y);          // Octant 0
-    ScreenDrawPoint(markscreen,xc-x,yc+y);          // Octant 3
-    ScreenDrawPoint(markscreen,xc+x,yc-y);          // Octant 7
-    ScreenDrawPoint(markscreen,xc-x,yc-y);          // Octant 4
+void MarkBorderPointsOct(INT xc, INT yc, INT x, INT y) {
+DrawContextType ctx;
 
+    MarkGlobalContext(&ctx);
+    MarkBorderPointsOctCtx(&ctx,xc,yc,x,y);
 }
 
+void MarkHorizFill(INT xc, INT yc, INT x, INT y) {
+DrawContextType ctx;
+
+    MarkGlobalContext(&ctx);
+    MarkHorizFillCtx(&ctx,xc,yc,x,y);
+}
+///@}
+
 
 /**
- * @brief   Plot points on markscreen mirroing along the axes
+ * @brief   Plot a point on the screen of the context
  *
- * @note    <bla bla bla>
+ * @note    Default point sink
  */
-void MarkBorderPointsOct(INT xc, INT yc, INT x, INT y) {
+void MarkScreenPoint(DrawContextType *ctx, INT x, INT y) {
 
-    if( !markscreen ) return;
+    if( !ctx->screen ) return;
+
+    ScreenDrawPoint(ctx->screen,x,y);
+}
+
+
+/**
+ * @brief   Plot a point on a screen that is not PBM
+ *
+ * @note    Default point sink for these screens. Points received by sinks
+ *          are already clipped, so the routine of the format is called
+ *          without further checks
+ */
+void MarkScreenPointFormat(DrawContextType *ctx, INT x, INT y) {
+
+    ctx->screen->ops->point(ctx->screen,x,y);
+}
+
+
+/**
+ * @brief   Draw a horizontal run of points (x1 and x2 included)
+ *
+ * @note    Default horizontal run sink, used in MARK_LINE_RUNS mode and for
+ *          fill. The whole run is written using byte masks, i.e., one store
+ *          for each byte instead of one for each pixel
+ */
+void MarkScreenHorizRun(DrawContextType *ctx, INT x1, INT x2, INT y) {
+
+    if( !ctx->screen ) return;
+
+    ScreenDrawHorizLine(ctx->screen,x1,x2,y);
+}
+
+
+/**
+ * @brief   Draw a vertical run of points (y1 and y2 included)
+ *
+ * @note    Default vertical run sink, used in MARK_LINE_RUNS mode
+ */
+void MarkScreenVertRun(DrawContextType *ctx, INT x, INT y1, INT y2) {
+
+    if( !ctx->screen ) return;
+
+    ScreenDrawVertLine(ctx->screen,x,y1,y2);
+}
+
+
+/**
+ * @brief   Blend the ink into a point with coverage alpha (0 to 255)
+ *
+ * @note    Default coverage sink, used by the antialiased routines. Points are
+ *          already clipped
+ */
+void MarkScreenBlend(DrawContextType *ctx, INT x, INT y, INT alpha) {
+
+    if( !ctx->screen ) return;
+
+    ctx->screen->ops->blend(ctx->screen,x,y,alpha);
+}
+
+
+/**
+ * @brief   Plot points mirroing along the axes
+ *
+ * @note    Rows and columns are tested once for the pair of points sharing them.
+ *          When all four points are outside the screen, nothing is done.
+ *
+ * @note    Points on the axes (x==0 or y==0) are plotted only once
+ */
+
+void MarkBorderPointsQuadCtx(DrawContextType *ctx, INT xc, INT yc, INT x, INT y) {
+MarkClipType clip;
+int l,r;
+
+    if( ctx->ordering ) {
+        MarkOrderAdd(ctx,x,y,0);
+        return;
+    }
+    if( !MarkGetClip(ctx,&clip) ) return;
+
+    l = (x != 0) && (xc-x >= clip.xmin) && (xc-x <= clip.xmax);
+    r = (xc+x >= clip.xmin) && (xc+x <= clip.xmax);
+    if( !l && !r ) return;
+
+    if( yc+y >= clip.ymin && yc+y <= clip.ymax ) {
+        if( r ) MARKPOINTIN(ctx,xc+x,yc+y);     // Octant 0
+        if( l ) MARKPOINTIN(ctx,xc-x,yc+y);     // Octant 3
+    }
+    if( y != 0 && yc-y >= clip.ymin && yc-y <= clip.ymax ) {
+        if( r ) MARKPOINTIN(ctx,xc+x,yc-y);     // Octant 7
+        if( l ) MARKPOINTIN(ctx,xc-x,yc-y);     // Octant 4
+    }
+
+}
+
+
+/**
+ * @brief   Plot points mirroing along the axes and the diagonals
+ *
+ * @note    Each distinct point is plotted once. Points on the diagonals
+ *          (x==y) are not transposed.
+ */
+void MarkBorderPointsOctCtx(DrawContextType *ctx, INT xc, INT yc, INT x, INT y) {
+
+    if( ctx->ordering ) {
+        MarkOrderAdd(ctx,x,y,1);
+        return;
+    }
+    MarkBorderPointsQuadCtx(ctx,xc,yc,x,y);
+    if( x != y )
+        MarkBorderPointsQuadCtx(ctx,xc,yc,y,x);
+
+}
+
+
+/**
+ * @brief   Plot points mirroring along the axes without bounds checking
+ *
+ * @note    Only for figures whose bounding box is inside the screen
+ *
+ * @note    As above, each distinct point is plotted once
+ */
+void MarkBorderPointsQuadIn(DrawContextType *ctx, INT xc, INT yc, INT x, INT y) {
+
+    if( ctx->ordering ) {
+        MarkOrderAdd(ctx,x,y,0);
+        return;
+    }
+    MARKPOINTIN(ctx,xc+x,yc+y);             // Octant 0
+    if( x != 0 )
+        MARKPOINTIN(ctx,xc-x,yc+y);         // Octant 3
+    if( y != 0 ) {
+        MARKPOINTIN(ctx,xc+x,yc-y);         // Octant 7
+        if( x != 0 )
+            MARKPOINTIN(ctx,xc-x,yc-y);     // Octant 4
+    }
+
+}
+
+void MarkBorderPointsOctIn(DrawContextType *ctx, INT xc, INT yc, INT x, INT y) {
 
-    MarkBorderPointsQuad(xc,yc,x,y);
-    MarkBorderPointsQuad(xc,yc,y,x);
+    if( ctx->ordering ) {
+        MarkOrderAdd(ctx,x,y,1);
+        return;
+    }
+    MarkBorderPointsQuadIn(ctx,xc,yc,x,y);
+    if( x != y )
+        MarkBorderPointsQuadIn(ctx,xc,yc,y,x);
 
 }
 
@@ -82,12 +463,551 @@ void MarkBorderPointsOct(INT xc, INT yc, INT x, INT y) {
 /**
  * @brief   Draw an horizontal line between points
  *
- * @note    <bla bla bla>
+ * @note    Rows yc+y and yc-y from xc-x to xc+x. The runs are clipped here,
+ *          since the run sinks receive only points inside the screen.
  */
-void MarkHorizFill(INT xc, INT yc, INT x, INT y) {
+void MarkHorizFillCtx(DrawContextType *ctx, INT xc, INT yc, INT x, INT y) {
+MarkClipType clip;
+INT x1,x2;
 
-    if( !markscreen ) return;
+    if( !MarkGetClip(ctx,&clip) ) return;
+
+    x1 = xc-x;
+    x2 = xc+x;
+    if( x1 > clip.xmax || x2 < clip.xmin ) return;
+    if( x1 < clip.xmin ) x1 = clip.xmin;
+    if( x2 > clip.xmax ) x2 = clip.xmax;
+
+    if( yc+y >= clip.ymin && yc+y <= clip.ymax )
+        MARKHRUN(ctx,x1,x2,yc+y);                   // Bottom semicircle
+    if( y != 0 && yc-y >= clip.ymin && yc-y <= clip.ymax )
+        MARKHRUN(ctx,x1,x2,yc-y);                   // Top semicircle
+}
+
+
+/**
+ * @brief   Scanline coalescing for filled figures
+ *
+ * @note    Points (x,y) of a quadrant arrive with y monotonic. A row is final
+ *          when y changes and only then rows yc+y and yc-y are filled, with
+ *          the largest x seen. So each row is written once, instead of once
+ *          for each point in it.
+ *
+ * @note    The state is kept in the context
+ */
+///@{
+void MarkFillBegin(DrawContextType *ctx, INT xc, INT yc) {
+
+    ctx->fillxc = xc;
+    ctx->fillyc = yc;
+    ctx->fillpending = 0;
+}
+
+void MarkFillRow(DrawContextType *ctx, INT x, INT y) {
+
+    if( ctx->fillpending ) {
+        if( y == ctx->filly ) {
+            if( x > ctx->fillx ) ctx->fillx = x;
+            return;
+        }
+        MARKFILL(ctx,ctx->fillxc,ctx->fillyc,ctx->fillx,ctx->filly);
+    }
+    ctx->fillx = x;
+    ctx->filly = y;
+    ctx->fillpending = 1;
+}
+
+void MarkFillEnd(DrawContextType *ctx) {
+
+    if( ctx->fillpending )
+        MARKFILL(ctx,ctx->fillxc,ctx->fillyc,ctx->fillx,ctx->filly);
+    ctx->fillpending = 0;
+}
+///@}
+
+
+/**
+ * @brief   Path order for circles and ellipses (MARK_ORDER_PATH)
+ *
+ * @note    The border routines buffer the points of the first octant (or
+ *          quadrant) instead of mirroring them. At the end of the figure, the
+ *          buffer is replayed four times, mirrored and walked forward or
+ *          backward, so the points go around the figure:
+ *              - quadrant (+x,+y) from (0,r) to (r,0)
+ *              - quadrant (+x,-y) from (r,0) to (0,-r)
+ *              - quadrant (-x,-y) from (0,-r) to (-r,0)
+ *              - quadrant (-x,+y) from (-r,0) to (0,r)
+ *          The points on the axes are sent once, as in the mirror order.
+ *          For octants, a quadrant is the octant followed by its transpose
+ *          walked back (the point on the diagonal is not repeated).
+ *
+ * @note    Consecutive points share a row or a column (or are diagonal
+ *          neighbors), which keeps the writes in the same cache lines and
+ *          suits plotters. The tips of very thin ellipses are spikes (a
+ *          row or column of points): the path jumps back from the tip.
+ *
+ * @note    When the buffer is full, the points buffered are mirrored and so
+ *          is the rest of the figure
+ */
+///@{
+void MarkContourBegin(DrawContextType *ctx, INT xc, INT yc) {
+
+    ctx->orderxc = xc;
+    ctx->orderyc = yc;
+    ctx->ordern = 0;
+    ctx->ordering = ctx->drawmode == MARK_CONTOUR && ctx->orderbuf != 0;
+}
+
+void MarkOrderAdd(DrawContextType *ctx, INT x, INT y, int oct) {
+MarkPointType *p;
+int ph = ctx->patternphase;
+int dashed = ctx->patternlen && oct;
+
+    if( ctx->ordern == ctx->ordersize ) {
+        // Mirrored from here. A circle is dashed as in the mirror order: the
+        // point of step i (one for each point buffered) has phase
+        // patternphase+i. The caller goes on with the next steps
+        ctx->ordering = 0;
+        for(size_t i=0;i<ctx->ordern;i++) {
+            p = &ctx->orderbuf[i];
+            if( dashed && !MARKPATTERNBIT(ctx,ph) ) {
+                // Off in the dash pattern
+            } else if( ctx->orderoct ) {
+                MarkBorderPointsOctCtx(ctx,ctx->orderxc,ctx->orderyc,p->x,p->y);
+            } else {
+                MarkBorderPointsQuadCtx(ctx,ctx->orderxc,ctx->orderyc,p->x,p->y);
+            }
+            if( dashed ) MARKPATTERNSTEP(ctx,ph);
+        }
+        ctx->ordern = 0;
+        if( dashed && !MARKPATTERNBIT(ctx,ph) ) return;
+        if( oct )
+            MarkBorderPointsOctCtx(ctx,ctx->orderxc,ctx->orderyc,x,y);
+        else
+            MarkBorderPointsQuadCtx(ctx,ctx->orderxc,ctx->orderyc,x,y);
+        return;
+    }
+    ctx->orderbuf[ctx->ordern].x = x;
+    ctx->orderbuf[ctx->ordern].y = y;
+    ctx->ordern++;
+    ctx->orderoct = oct;
+}
+
+/*
+ * A run of the buffer, from i1 to i2, transposed if t is set
+ */
+typedef struct {
+    long    i1,i2;
+    int     t;
+} MarkOrderRunType;
+
+/*
+ * Send a run mirrored by (sx,sy). The points on the x axis (skip&1) or on
+ * the y axis (skip&2) can be skipped, since they are sent by another quadrant
+ */
+static void markorderrun(DrawContextType *ctx, MarkClipType *clip, long i1, long i2, int t,
+                         int sx, int sy, int skip) {
+MarkPointType *p;
+INT a,b,x,y;
+long i,step;
+int on;
+
+    step = i2 >= i1 ? 1 : -1;
+    for( i = i1; ; i += step ) {
+        p = &ctx->orderbuf[i];
+        a = t ? p->y : p->x;
+        b = t ? p->x : p->y;
+        if( !((skip & 1) && b == 0) && !((skip & 2) && a == 0) ) {
+            x = ctx->orderxc + sx*a;
+            y = ctx->orderyc + sy*b;
+            // The dash goes along the path, clipped points included
+            on = 1;
+            if( ctx->patternlen ) {
+                on = (int) MARKPATTERNBIT(ctx,ctx->patternphase);
+                MARKPATTERNSTEP(ctx,ctx->patternphase);
+            }
+            if( on && x >= clip->xmin && x <= clip->xmax && y >= clip->ymin && y <= clip->ymax )
+                MARKPOINTIN(ctx,x,y);
+        }
+        if( i == i2 ) break;
+    }
+}
+
+/*
+ * Walk a quadrant (runs from (0,r) to (r,0)), forward or back
+ */
+static void markorderwalk(DrawContextType *ctx, MarkClipType *clip, MarkOrderRunType *run,
+                          int nruns, int back, int sx, int sy, int skip) {
+
+    if( back ) {
+        for(int j=nruns-1;j>=0;j--)
+            markorderrun(ctx,clip,run[j].i2,run[j].i1,run[j].t,sx,sy,skip);
+    } else {
+        for(int j=0;j<nruns;j++)
+            markorderrun(ctx,clip,run[j].i1,run[j].i2,run[j].t,sx,sy,skip);
+    }
+}
+
+void MarkContourEnd(DrawContextType *ctx) {
+MarkClipType clip;
+MarkPointType *buf = ctx->orderbuf;
+MarkOrderRunType run[2];
+long n = (long) ctx->ordern;
+long last;
+int nruns,flat;
+
+    ctx->ordering = 0;
+    ctx->ordern = 0;
+    if( n == 0 || !MarkGetClip(ctx,&clip) ) return;
+
+    // Runs of the quadrant from (0,r) to (r,0)
+    flat = 0;
+    if( ctx->orderoct ) {
+        // The octant and its transpose walked back, without the diagonal
+        last = n-1 - (buf[n-1].x == buf[n-1].y);
+        nruns = last >= 0 ? 2 : 1;
+        if( buf[0].x <= buf[0].y ) {
+            run[0] = (MarkOrderRunType) { 0, n-1, 0 };
+            run[1] = (MarkOrderRunType) { last, 0, 1 };
+        } else {
+            run[0] = (MarkOrderRunType) { 0, n-1, 1 };
+            run[1] = (MarkOrderRunType) { last, 0, 0 };
+        }
+    } else {
+        // Flat ellipses (ry == 0) go from (rx,0) to (-rx,0) thru the center
+        flat = n > 1 && buf[0].y == 0 && buf[n-1].y == 0;
+        nruns = 1;
+        if( flat || buf[0].y < buf[n-1].y )
+            run[0] = (MarkOrderRunType) { n-1, 0, 0 };
+        else
+            run[0] = (MarkOrderRunType) { 0, n-1, 0 };
+    }
+
+    markorderwalk(ctx,&clip,run,nruns,0,1,1,0);
+    markorderwalk(ctx,&clip,run,nruns,1,1,-1,1);
+    markorderwalk(ctx,&clip,run,nruns,flat,-1,-1,2);
+    markorderwalk(ctx,&clip,run,nruns,1,-1,1,3);
+}
+///@}
+
+
+/**
+ * @brief   Get the clipping window
+ *
+ * @note    It is the screen intersected with the clipping window of the
+ *          context, if any. Without a screen, only the latter is used, unless
+ *          the default sink is used (and then, there is nothing to draw)
+ *
+ * @return  0 if nothing can be drawn
+ */
+int MarkGetClip(DrawContextType *ctx, MarkClipType *clip) {
+
+    if( !ctx->screen ) {
+        if( ctx->point == MarkScreenPoint ) return 0;
+        clip->xmin = INT_MIN;
+        clip->ymin = INT_MIN;
+        clip->xmax = INT_MAX;
+        clip->ymax = INT_MAX;
+    } else {
+        clip->xmin = 0;
+        clip->ymin = 0;
+        clip->xmax = ScreenWidth(ctx->screen)-1;
+        clip->ymax = ScreenHeight(ctx->screen)-1;
+    }
+    if( ctx->clipped ) {
+        if( ctx->clip.xmin > clip->xmin ) clip->xmin = ctx->clip.xmin;
+        if( ctx->clip.ymin > clip->ymin ) clip->ymin = ctx->clip.ymin;
+        if( ctx->clip.xmax < clip->xmax ) clip->xmax = ctx->clip.xmax;
+        if( ctx->clip.ymax < clip->ymax ) clip->ymax = ctx->clip.ymax;
+    }
+    return (clip->xmin <= clip->xmax) && (clip->ymin <= clip->ymax);
+}
+
+
+/**
+ * @brief   Test a bounding box (inclusive) against the clipping window
+ *
+ * @note    Used to reject circles and ellipses or to use the unchecked routines
+ */
+MarkClipResultType MarkClipBox(DrawContextType *ctx, INT x1, INT y1, INT x2, INT y2) {
+MarkClipType clip;
+
+    if( !MarkGetClip(ctx,&clip) ) return MARK_OUTSIDE;
+
+    if( x2 < clip.xmin || x1 > clip.xmax || y2 < clip.ymin || y1 > clip.ymax )
+        return MARK_OUTSIDE;
+    if( x1 >= clip.xmin && x2 <= clip.xmax && y1 >= clip.ymin && y2 <= clip.ymax )
+        return MARK_INSIDE;
+    return MARK_PARTIAL;
+}
+
+
+/**
+ * @brief   Check the range of an ellipse
+ *
+ * @note    Negative radii and bounding boxes that do not fit in INT are
+ *          rejected. Radii too large for 64 bit terms need 128 bit ones,
+ *          if the compiler has them.
+ */
+MarkRangeType MarkEllipseRange(INT xc, INT yc, INT rx, INT ry) {
+INT r;
+
+    if( rx < 0 || ry < 0 ) return MARK_RANGE_NONE;
+    if( (LONG64) xc-rx < INT_MIN || (LONG64) xc+rx > INT_MAX ||
+        (LONG64) yc-ry < INT_MIN || (LONG64) yc+ry > INT_MAX )
+        return MARK_RANGE_NONE;
+
+    r = (rx > ry) ? rx : ry;
+    if( r <= MARK_ELLIPSE_MAXLONG64 ) return MARK_RANGE_LONG64;
+#ifdef LONG128
+    if( r <= MARK_ELLIPSE_MAXLONG128 ) return MARK_RANGE_LONG128;
+#endif
+    return MARK_RANGE_NONE;
+}
+
+
+/**
+ * @brief   Points of the ellipse loops at a given step
+ *
+ * @note    Used to jump to a step instead of walking to it. The Bresenham and
+ *          midpoint loops choose the same points. Up to the turn (where the
+ *          slope is -1), y at column x is the one whose midpoint (x,y-1/2) is
+ *          inside the ellipse and (x,y+1/2) is not. After it, x at row y is the
+ *          first one whose midpoint (x+1/2,y) is outside, but not less than
+ *          x at the turn, since the loops never go back.
+ *
+ * @note    The terms are as large as in the loops, so LONGWIDE is enough for
+ *          the ellipses in range (see MarkEllipseRange)
+ */
+///@{
+INT MarkEllipseY(INT rx, INT ry, INT x) {
+LONGWIDE rx2 = (LONGWIDE) rx*rx, ry2 = (LONGWIDE) ry*ry;
+INT lo = 0, hi = ry, m;
+
+    while( lo < hi ) {
+        m = lo+(hi-lo+1)/2;
+        if( 4*ry2*x*x+rx2*(2*(LONGWIDE) m-1)*(2*(LONGWIDE) m-1) < 4*rx2*ry2 ) lo = m;
+        else hi = m-1;
+    }
+    return lo;
+}
+
+INT MarkEllipseX(INT rx, INT ry, INT y) {
+LONGWIDE rx2 = (LONGWIDE) rx*rx, ry2 = (LONGWIDE) ry*ry;
+INT lo = 0, hi = rx, m;
+
+    while( lo < hi ) {
+        m = lo+(hi-lo)/2;
+        if( ry2*(2*(LONGWIDE) m+1)*(2*(LONGWIDE) m+1)+4*rx2*y*y > 4*rx2*ry2 ) hi = m;
+        else lo = m+1;
+    }
+    return lo;
+}
+
+/*
+ * The turn is the first step (x,y) with ry^2*x >= rx^2*y. y can be one row
+ * above MarkEllipseY there, since a step moves one row at most
+ */
+static INT markellipsestep(INT rx, INT ry, INT x) {
+INT y,t;
+
+    if( x == 0 ) return ry;
+    y = MarkEllipseY(rx,ry,x);
+    t = MarkEllipseY(rx,ry,x-1)-1;
+    return t > y ? t : y;
+}
+
+INT MarkEllipseTurn(INT rx, INT ry, INT *y) {
+LONGWIDE rx2 = (LONGWIDE) rx*rx, ry2 = (LONGWIDE) ry*ry;
+INT lo = 0, hi = rx, m;
+
+    while( lo < hi ) {
+        m = lo+(hi-lo)/2;
+        if( ry2*m >= rx2*markellipsestep(rx,ry,m) ) hi = m;
+        else lo = m+1;
+    }
+    *y = markellipsestep(rx,ry,lo);
+    return lo;
+}
+///@}
+
+
+/**
+ * @brief   Offset u of the curve (u/a)^2+(v/b)^2 = 1 at offset v, rounded down
+ *
+ * @return  -1 if v is beyond b
+ */
+static LONG64 markcurveu(INT a, INT b, LONG64 v) {
+INT lo = 0, hi = a, m;
+
+    if( v <= 0 ) return a;
+    if( v > b ) return -1;
+    while( lo < hi ) {
+        m = lo+(hi-lo+1)/2;
+        if( a == b ? (LONGWIDE) m*m <= (LONGWIDE) b*b-(LONGWIDE) v*v :
+            (LONGWIDE) m*m*b*b <= (LONGWIDE) a*a*((LONGWIDE) b*b-(LONGWIDE) v*v) ) lo = m;
+        else hi = m-1;
+    }
+    return lo;
+}
+
+
+/**
+ * @brief   Steps of a circle or ellipse loop whose points can be in the
+ *          clipping window
+ *
+ * @note    The loop walks the quadrant (u,v) of the curve with radii (rx,ry),
+ *          one step of u (axis 0) or of v (axis 1) at a time. The point of a
+ *          step goes to (xc+-u,yc+-v) and, if oct, to (xc+-v,yc+-u). For each
+ *          of them, the steps inside the window are those in the window in
+ *          the axis of the loop whose other coordinate is too. The latter is
+ *          found from the curve, with a margin of 2 for the distance of the
+ *          points to it. In fill mode, only rows count (spans are clipped).
+ *
+ * @note    The caller walks the windows only, jumping from one to the next.
+ *          Dash patterns and the path order need all the steps, so they are
+ *          not split
+ *
+ * @return  Number of windows in w (sorted and merged, at most
+ *          MARK_CURVEWINDOWS), -1 if all the steps must be walked
+ */
+int MarkCurveWindows(DrawContextType *ctx, INT xc, INT yc, INT rx, INT ry,
+                     int axis, int oct, MarkWindowType *w) {
+MarkClipType clip;
+MarkWindowType t;
+LONG64 xlo,xhi,ylo,yhi,u1,u2,v1,v2,lo,hi;
+int n = 0, m;
+
+    if( ctx->patternlen || rx <= 0 || ry <= 0 ) return -1;
+    if( ctx->order == MARK_ORDER_PATH && ctx->orderbuf && ctx->drawmode == MARK_CONTOUR ) return -1;
+    if( !MarkGetClip(ctx,&clip) ) return 0;
+
+    for(int i=0;i<(oct ? 8 : 4);i++) {
+        // Offsets from the center inside the window, for the signs of the point
+        xlo = (i & 1) ? (LONG64) xc-clip.xmax : (LONG64) clip.xmin-xc;
+        xhi = (i & 1) ? (LONG64) xc-clip.xmin : (LONG64) clip.xmax-xc;
+        ylo = (i & 2) ? (LONG64) yc-clip.ymax : (LONG64) clip.ymin-yc;
+        yhi = (i & 2) ? (LONG64) yc-clip.ymin : (LONG64) clip.ymax-yc;
+        if( ctx->drawmode == MARK_FILL ) {
+            xlo = 0;
+            xhi = (LONG64) rx+ry;
+        }
+        u1 = (i & 4) ? ylo : xlo;
+        u2 = (i & 4) ? yhi : xhi;
+        v1 = (i & 4) ? xlo : ylo;
+        v2 = (i & 4) ? xhi : yhi;
+        if( u1 < 0 ) u1 = 0;
+        if( u2 > rx ) u2 = rx;
+        if( v1 < 0 ) v1 = 0;
+        if( v2 > ry ) v2 = ry;
+        if( u1 > u2 || v1 > v2 ) continue;
+
+        if( axis == 0 ) {
+            lo = markcurveu(rx,ry,v2+2)-2;      if( lo < u1 ) lo = u1;
+            hi = markcurveu(rx,ry,v1-2)+3;      if( hi > u2 ) hi = u2;
+        } else {
+            lo = markcurveu(ry,rx,u2+2)-2;      if( lo < v1 ) lo = v1;
+            hi = markcurveu(ry,rx,u1-2)+3;      if( hi > v2 ) hi = v2;
+        }
+        if( lo > hi ) continue;
+
+        // Sorted by lo and merged
+        t.lo = lo;
+        t.hi = hi;
+        for(m=n;m>0 && w[m-1].lo > t.lo;m--) w[m] = w[m-1];
+        w[m] = t;
+        n++;
+    }
+    if( n > 1 ) {
+        m = 0;
+        for(int i=1;i<n;i++) {
+            if( w[i].lo > w[m].hi+1 ) w[++m] = w[i];
+            else if( w[i].hi > w[m].hi ) w[m].hi = w[i].hi;
+        }
+        n = m+1;
+    }
+    return n;
+}
+
+
+/*
+ * @brief   Integer division rounding toward -infinity and +infinity
+ *
+ * @note    Divisor must be positive
+ */
+///@{
+static LONG64 floordiv(LONG64 a, LONG64 b) {
+
+    return (a>=0) ? a/b : -((-a+b-1)/b);
+}
+
+static LONG64 ceildiv(LONG64 a, LONG64 b) {
+
+    return (a>=0) ? (a+b-1)/b : -((-a)/b);
+}
+///@}
+
+
+/**
+ * @brief   Number of steps taken in the minor axis after n steps
+ */
+LONG64 MarkLineStepsK(MarkLineStepType *ls, LONG64 n) {
+
+    return floordiv(n*ls->p+ls->q,ls->r);
+}
+
+
+/**
+ * @brief   Find the range of steps of a line that are inside a window
+ *
+ * @note    Since k(n) is monotonic, the range is found without stepping thru
+ *          the points outside the window. Only integer operations are used, so
+ *          the points inside are exactly the same as the unclipped ones.
+ *
+ * @return  0 if the line is completely outside the window
+ */
+int MarkClipLineSteps(MarkLineStepType *ls, INT majmin, INT majmax,
+                      INT minmin, INT minmax, LONG64 *n1, LONG64 *n2) {
+LONG64 lo,hi,klo,khi,t;
+
+    lo = 0;
+    hi = ls->len;
+
+    // Major axis. It advances one unit per step
+    if( ls->majorinc > 0 ) {
+        t = (LONG64) majmin - ls->major;  if( t > lo ) lo = t;
+        t = (LONG64) majmax - ls->major;  if( t < hi ) hi = t;
+    } else {
+        t = (LONG64) ls->major - majmax;  if( t > lo ) lo = t;
+        t = (LONG64) ls->major - majmin;  if( t < hi ) hi = t;
+    }
+    if( lo > hi ) return 0;
+
+    // Minor axis. Find the range of k(n) allowed
+    if( ls->minorinc > 0 ) {
+        klo = (LONG64) minmin - ls->minor;
+        khi = (LONG64) minmax - ls->minor;
+    } else {
+        klo = (LONG64) ls->minor - minmax;
+        khi = (LONG64) ls->minor - minmin;
+    }
+    // Limit them to avoid overflow
+    if( klo < 0 ) klo = 0;
+    if( khi > ls->len ) khi = ls->len;
+    if( klo > khi ) return 0;
+
+    if( ls->p == 0 ) {
+        t = MarkLineStepsK(ls,0);
+        if( t < klo || t > khi ) return 0;
+    } else {
+        // k(n) >= klo  <=> n*p+q >= klo*r
+        t = ceildiv(klo*ls->r-ls->q,ls->p);         if( t > lo ) lo = t;
+        // k(n) <= khi  <=> n*p+q < (khi+1)*r
+        t = floordiv((khi+1)*ls->r-ls->q-1,ls->p);  if( t < hi ) hi = t;
+    }
+    if( lo > hi ) return 0;
 
-    ScreenDrawHorizLine(markscreen,xc-x,xc+x,yc+y);       // Bottom semicircle
-    ScreenDrawHorizLine(markscreen,xc-x,xc+x,yc-y);       // Top semicircle
+    *n1 = lo;
+    *n2 = hi;
+    return 1;
 }
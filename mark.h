@@ -17,45 +17,312 @@
 #define LONG                long
 #endif
 
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief  Integer types for the decision terms of the ellipses
+ *
+ * @note   LONG64 is always 64 bits (LONG can be 32 bits on some platforms).
+ *         LONG128 is defined only when the compiler has a 128 bit integer
+ *         (e.g., GCC and clang on 64 bit targets)
+ */
+#ifndef LONG64
+#define LONG64              int64_t
+#endif
+
+#if !defined(LONG128) && defined(__SIZEOF_INT128__)
+#define LONG128             __int128
+#endif
+
+#ifdef LONG128
+#define LONGWIDE            LONG128                     // Widest of them
+#else
+#define LONGWIDE            LONG64
+#endif
+
 #include "screen.h"
+
+typedef enum { MARK_CONTOUR, MARK_FILL } MarkDrawModeType;
+
+/*
+ * @brief  Lines can be emitted point by point or as runs of points
+ *
+ * @note   In MARK_LINE_RUNS mode, pixels sharing a row (or a column) are
+ *         sent to the horizontal (or vertical) run sink in a single call
+ */
+typedef enum { MARK_LINE_POINTS, MARK_LINE_RUNS } MarkLineModeType;
+
+/*
+ * @brief  Order of the points of circles and ellipses in contour mode
+ *
+ * @note   MARK_ORDER_MIRROR sends the 4 or 8 mirrored points of each step,
+ *         so they jump around the figure. MARK_ORDER_PATH sends them octant
+ *         by octant along the figure, each one next to the previous one
+ *         (see MarkContextSetOrder)
+ */
+typedef enum { MARK_ORDER_MIRROR, MARK_ORDER_PATH } MarkOrderType;
+
+/**
+ * @brief  A point
+ */
+typedef struct {
+    INT x,y;
+} MarkPointType;
+
+/**
+ * @brief  Clipping window (inclusive limits)
+ */
+typedef struct {
+    INT xmin,ymin;
+    INT xmax,ymax;
+} MarkClipType;
+
 /**
- * @brief  Callback for set pixel (mark)
+ * @brief  Drawing context
+ *
+ * @note   It carries everything the drawing routines need: the target screen,
+ *         the modes and the sinks. There is no global state, so each thread can
+ *         draw using its own context without locking.
+ *
+ * @note   The sinks receive only points inside the screen and, if set, inside
+ *         the clipping window of the context. Without both, points are not
+ *         clipped.
+ *
+ * @note   Use MarkContextInit to set the default sinks (drawing on screen)
+ */
+typedef struct DrawContextStruct DrawContextType;
+
+#define MARK_PATTERNMAX     64                          // Bits of a dash pattern
+
+struct DrawContextStruct {
+    ScreenType         *screen;                         // Target (can be NULL)
+    MarkDrawModeType    drawmode;                       // Contour or fill
+    MarkLineModeType    linemode;                       // Points or runs
+    void (*point)(DrawContextType *,INT,INT);           // Point sink
+    void (*hrun)(DrawContextType *,INT,INT,INT);        // Horizontal run sink (x1,x2,y)
+    void (*vrun)(DrawContextType *,INT,INT,INT);        // Vertical run sink (x,y1,y2)
+    void (*blend)(DrawContextType *,INT,INT,INT);       // Coverage sink (x,y,alpha 0..255)
+    void               *user;                           // Opaque pointer for the sinks
+    MarkClipType        clip;                           // Clipping window
+    int                 clipped;                        // Use clip?
+    // Scanline coalescing state for fill mode
+    INT                 fillxc,fillyc;
+    INT                 fillx,filly;
+    int                 fillpending;
+    // Octant buffer for MARK_ORDER_PATH (storage of the caller)
+    MarkOrderType       order;
+    MarkPointType      *orderbuf;
+    size_t              ordersize,ordern;
+    INT                 orderxc,orderyc;
+    int                 ordering;                       // Buffering a figure
+    int                 orderoct;                       // Points are octants (not quadrants)
+    // Dash pattern (see MarkContextSetPattern)
+    uint64_t            pattern;
+    int                 patternlen;                     // Bits used (0: solid)
+    int                 patternphase;                   // Bit of the next point
+    unsigned char       patternmask[2][MARK_PATTERNMAX];// 8 bits from each phase, forward and back
+};
+
+/**
+ * @brief  Sinks for a context
  *
  * @note   Macros are used to avoid the call thru a NULL point
  */
 ///@{
-extern void (*MarkDrawPoint)(INT,INT);
-extern void (*MarkDrawContourQuad)(INT,INT,INT,INT);
-extern void (*MarkDrawContourOct)(INT,INT,INT,INT);
-extern void (*MarkDrawFill)(INT,INT,INT,INT);
+#define MARKPOINT(C,X,Y)        do { \
+                                    if ((C)->point) \
+                                        (C)->point((C),(X),(Y)); \
+                                } while(0)
 
+/*
+ * @brief  Point already clipped against the screen
+ *
+ * @note   When the default sink is used, the bounds check is skipped
+ */
+#define MARKPOINTIN(C,X,Y)      do { \
+                                    if ((C)->point==MarkScreenPoint) \
+                                        ScreenDrawPointUnsafe((C)->screen,(X),(Y)); \
+                                    else if ((C)->point) \
+                                        (C)->point((C),(X),(Y)); \
+                                } while(0)
 
-typedef enum { MARK_CONTOUR, MARK_FILL } MarkDrawModeType;
+#define MARKHRUN(C,X1,X2,Y)     do { \
+                                    if ((C)->hrun) \
+                                        (C)->hrun((C),(X1),(X2),(Y)); \
+                                } while(0)
 
-extern ScreenType *markscreen;
-extern MarkDrawModeType markdrawmode;
+#define MARKVRUN(C,X,Y1,Y2)     do { \
+                                    if ((C)->vrun) \
+                                        (C)->vrun((C),(X),(Y1),(Y2)); \
+                                } while(0)
 
-#define MARKPOINT(X,Y)          do { \
-                                    if (MarkDrawPoint) \
-                                        MarkDrawPoint((X),(Y)); \
+#define MARKBLEND(C,X,Y,A)      do { \
+                                    if ((C)->blend) \
+                                        (C)->blend((C),(X),(Y),(A)); \
                                 } while(0)
 
-#define MARKFILL(X1,Y1,X2,Y2)   do { \
-                                   MarkHorizFill(X1,Y1,X2,Y2); \
+#define MARKFILL(C,X1,Y1,X2,Y2) do { \
+                                   MarkHorizFillCtx(C,X1,Y1,X2,Y2); \
+                                 } while(0)
+
+#define MARKFILLBEGIN(C,XC,YC)  do { \
+                                   MarkFillBegin(C,XC,YC); \
+                                 } while(0)
+
+#define MARKFILLROW(C,X,Y)      do { \
+                                   MarkFillRow(C,X,Y); \
                                  } while(0)
 
-#define MARKCONTOURQUAD(X1,Y1,X2,Y2) do { \
-                                    MarkBorderPointsQuad(X1,Y1,X2,Y2); \
+#define MARKFILLEND(C)          do { \
+                                   MarkFillEnd(C); \
+                                 } while(0)
+
+/*
+ * @brief  Dash pattern. Bit of phase P (1: draw the point) and next phase
+ */
+#define MARKPATTERNBIT(C,P)     (((C)->pattern >> ((C)->patternlen-1-(P))) & 1)
+#define MARKPATTERNSTEP(C,P)    do { \
+                                    if (++(P) == (C)->patternlen) \
+                                        (P) = 0; \
+                                } while(0)
+
+#define MARKCONTOURBEGIN(C,XC,YC) do { \
+                                   if ((C)->order==MARK_ORDER_PATH) \
+                                       MarkContourBegin(C,XC,YC); \
+                                 } while(0)
+
+#define MARKCONTOUREND(C)       do { \
+                                   if ((C)->ordering) \
+                                       MarkContourEnd(C); \
+                                 } while(0)
+
+#define MARKCONTOURQUAD(C,X1,Y1,X2,Y2) do { \
+                                    MarkBorderPointsQuadCtx(C,X1,Y1,X2,Y2); \
+                                    } while (0);
+
+#define MARKCONTOUROCT(C,X1,Y1,X2,Y2) do { \
+                                    MarkBorderPointsOctCtx(C,X1,Y1,X2,Y2); \
                                     } while (0);
 
-#define MARKCONTOUROCT(X1,Y1,X2,Y2) do { \
-                                    MarkBorderPointsOct(X1,Y1,X2,Y2); \
+#define MARKCONTOURQUADIN(C,X1,Y1,X2,Y2) do { \
+                                    MarkBorderPointsQuadIn(C,X1,Y1,X2,Y2); \
                                     } while (0);
 
+#define MARKCONTOUROCTIN(C,X1,Y1,X2,Y2) do { \
+                                    MarkBorderPointsOctIn(C,X1,Y1,X2,Y2); \
+                                    } while (0);
 ///@}
 
+/**
+ * @brief  Old interface using global variables
+ *
+ * @note   The drawing routines without a context build one from these
+ *         variables at each call (see MarkGlobalContext). So do
+ *         MarkBorderPointsQuad, MarkBorderPointsOct and MarkHorizFill, kept
+ *         with their old signatures (the routines with a context end in Ctx)
+ */
+///@{
+extern void (*MarkDrawPoint)(INT,INT);
+extern void (*MarkDrawContourQuad)(INT,INT,INT,INT);
+extern void (*MarkDrawContourOct)(INT,INT,INT,INT);
+extern void (*MarkDrawFill)(INT,INT,INT,INT);
+extern void (*MarkDrawHorizRun)(INT,INT,INT);
+extern void (*MarkDrawVertRun)(INT,INT,INT);
+
+extern ScreenType *markscreen;
+extern MarkDrawModeType markdrawmode;
+extern MarkLineModeType marklinemode;
+
+extern void MarkPoint(INT x, INT y);
+extern void MarkHorizRun(INT x1, INT x2, INT y);
+extern void MarkVertRun(INT x, INT y1, INT y2);
 extern void MarkBorderPointsQuad(INT xc, INT yc, INT x, INT y);
 extern void MarkBorderPointsOct(INT xc, INT yc, INT x, INT y);
 extern void MarkHorizFill(INT xc, INT yc, INT x, INT y);
-extern void MarkPoint(INT x, INT y);
+///@}
+
+/**
+ * @brief  Line stepping description used for clipping
+ *
+ * @note   After n steps, the point is at major+n*majorinc in the major axis and
+ *         at minor+k(n)*minorinc in the minor axis, where k(n) = floor((n*p+q)/r)
+ */
+typedef struct {
+    LONG64  len;                    // Number of steps (points-1)
+    INT     major,majorinc;         // Start and increment in the major axis
+    INT     minor,minorinc;         // Start and increment in the minor axis
+    LONG64  p,q,r;                  // Coefficients of k(n)
+} MarkLineStepType;
+
+/**
+ * @brief  Result of the test of a bounding box against the clipping window
+ */
+typedef enum { MARK_OUTSIDE, MARK_PARTIAL, MARK_INSIDE } MarkClipResultType;
+
+/**
+ * @brief  Width of the decision terms needed to draw an ellipse
+ *
+ * @note   The largest term grows as 8*r^4, where r is the largest radius.
+ *         64 bits are enough up to MARK_ELLIPSE_MAXLONG64 and 128 bits up to
+ *         MARK_ELLIPSE_MAXLONG128. The bounding box must also fit in INT.
+ *
+ * @note   Ellipses out of range (MARK_RANGE_NONE) are not drawn
+ */
+typedef enum { MARK_RANGE_NONE, MARK_RANGE_LONG64, MARK_RANGE_LONG128 } MarkRangeType;
+
+#define MARK_ELLIPSE_MAXLONG64      30000
+#define MARK_ELLIPSE_MAXLONG128     (1<<30)
+
+/**
+ * @brief  Range of steps of a circle or ellipse loop (lo and hi included)
+ *
+ * @note   See MarkCurveWindows. There are at most 8 of them (one for each
+ *         mirrored point)
+ */
+typedef struct {
+    LONG64  lo,hi;
+} MarkWindowType;
+
+#define MARK_CURVEWINDOWS           8
+
+extern void MarkContextInit(DrawContextType *ctx, ScreenType *screen);
+extern void MarkGlobalContext(DrawContextType *ctx);
+extern void MarkContextSetClip(DrawContextType *ctx, INT xmin, INT ymin, INT xmax, INT ymax);
+extern void MarkContextResetClip(DrawContextType *ctx);
+extern void MarkContextSetOrder(DrawContextType *ctx, MarkOrderType order,
+                                MarkPointType *buf, size_t size);
+extern void MarkContextSetPattern(DrawContextType *ctx, uint64_t pattern, int len);
+
+extern int  MarkGetClip(DrawContextType *ctx, MarkClipType *clip);
+extern MarkClipResultType MarkClipBox(DrawContextType *ctx, INT x1, INT y1, INT x2, INT y2);
+extern int  MarkClipLineSteps(MarkLineStepType *ls, INT majmin, INT majmax,
+                              INT minmin, INT minmax, LONG64 *n1, LONG64 *n2);
+extern LONG64 MarkLineStepsK(MarkLineStepType *ls, LONG64 n);
+extern MarkRangeType MarkEllipseRange(INT xc, INT yc, INT rx, INT ry);
+extern INT  MarkEllipseY(INT rx, INT ry, INT x);
+extern INT  MarkEllipseX(INT rx, INT ry, INT y);
+extern INT  MarkEllipseTurn(INT rx, INT ry, INT *y);
+extern int  MarkCurveWindows(DrawContextType *ctx, INT xc, INT yc, INT rx, INT ry,
+                             int axis, int oct, MarkWindowType *w);
+
+extern void MarkScreenPoint(DrawContextType *ctx, INT x, INT y);
+extern void MarkScreenPointFormat(DrawContextType *ctx, INT x, INT y);
+extern void MarkScreenHorizRun(DrawContextType *ctx, INT x1, INT x2, INT y);
+extern void MarkScreenVertRun(DrawContextType *ctx, INT x, INT y1, INT y2);
+extern void MarkScreenBlend(DrawContextType *ctx, INT x, INT y, INT alpha);
+
+extern void MarkBorderPointsQuadCtx(DrawContextType *ctx, INT xc, INT yc, INT x, INT y);
+extern void MarkBorderPointsOctCtx(DrawContextType *ctx, INT xc, INT yc, INT x, INT y);
+extern void MarkBorderPointsQuadIn(DrawContextType *ctx, INT xc, INT yc, INT x, INT y);
+extern void MarkBorderPointsOctIn(DrawContextType *ctx, INT xc, INT yc, INT x, INT y);
+extern void MarkHorizFillCtx(DrawContextType *ctx, INT xc, INT yc, INT x, INT y);
+extern void MarkFillBegin(DrawContextType *ctx, INT xc, INT yc);
+extern void MarkFillRow(DrawContextType *ctx, INT x, INT y);
+extern void MarkFillEnd(DrawContextType *ctx);
+extern void MarkContourBegin(DrawContextType *ctx, INT xc, INT yc);
+extern void MarkContourEnd(DrawContextType *ctx);
+extern void MarkOrderAdd(DrawContextType *ctx, INT x, INT y, int oct);
+extern void MarkPatternHorizRun(DrawContextType *ctx, INT xs, INT xe, INT y, int phase);
+extern void MarkPatternVertRun(DrawContextType *ctx, INT x, INT ys, INT ye, int phase);
 #endif // MARK_H
@@ -6,7 +6,8 @@
  * @note   Integer types used are specified by preprocessor symbols INT and LONG
  *         to enhance portability
  *
- * @note   LONG is only used for ellipses
+ * @note   LONG is only used for ellipses. Their decision terms use LONG64
+ *         or LONG128 (see MarkEllipseRange)
  *
  *
  * @author  Hans
@@ -20,6 +21,7 @@
 #include <stdio.h>
 #include "midpoint.h"
 #include "mark.h"
+#include "curve.h"
 ///@}
 
 /**
@@ -74,16 +76,97 @@
 #define ABS(X)  ((X)>0?(X):-(X))
 
 
+/**
+ * @brief   Clip a line against the screen
+ *
+ * @note    The start point, the end point (only the major axis is used) and the
+ *          decision parameter are updated to the first and last points inside
+ *          the screen. The points drawn are the same as the unclipped line.
+ *
+ * @note    Points must be already ordered (dy>=0) and key computed
+ *
+ * @return  0 if the line is outside the screen
+ */
+static int cliplinem(DrawContextType *ctx, int key, INT *x1, INT *y1, INT *x2, INT *y2, INT *d) {
+MarkClipType clip;
+MarkLineStepType ls;
+LONG64 n1,n2,k;
+INT absdx,absdy;
+int r;
+
+    if( !MarkGetClip(ctx,&clip) ) return 0;
+
+    absdx = ABS(*x2 - *x1);
+    absdy = *y2 - *y1;
+    if( key == OCT0 || key == OCT3 ) {
+        // x is the major axis
+        ls.len = absdx;
+        ls.major = *x1;
+        ls.majorinc = (key==OCT0)?1:-1;
+        ls.minor = *y1;
+        ls.minorinc = 1;
+        ls.p = absdy;
+    } else {
+        // y is the major axis
+        ls.len = absdy;
+        ls.major = *y1;
+        ls.majorinc = 1;
+        ls.minor = *x1;
+        ls.minorinc = (key==OCT1)?1:-1;
+        ls.p = absdx;
+    }
+    // The decision parameter stays in [p-len,p) and so k(n) can be found
+    if( ls.len >= 2 ) {
+        ls.q = *d - ls.p + ls.len;
+        ls.r = ls.len;
+    } else {
+        ls.q = 0;
+        ls.r = 1;
+    }
+
+    if( key == OCT0 || key == OCT3 ) {
+        r = MarkClipLineSteps(&ls,clip.xmin,clip.xmax,clip.ymin,clip.ymax,&n1,&n2);
+        if( !r ) return 0;
+        k = MarkLineStepsK(&ls,n1);
+        *x1 = ls.major + n1*ls.majorinc;
+        *y1 = ls.minor + k;
+        *x2 = ls.major + n2*ls.majorinc;
+    } else {
+        r = MarkClipLineSteps(&ls,clip.ymin,clip.ymax,clip.xmin,clip.xmax,&n1,&n2);
+        if( !r ) return 0;
+        k = MarkLineStepsK(&ls,n1);
+        *y1 = ls.major + n1;
+        *x1 = ls.minor + k*ls.minorinc;
+        *y2 = ls.major + n2;
+    }
+    // Decision parameter after n1 steps
+    *d += n1*ls.p - k*ls.len;
+    return 1;
+}
+
+
  /**
   * @brief   draw a line  using midpoint algorithm
+  *
+  * @note    The line is clipped against the screen before the loop. Points are
+  *          then plotted without bounds checking.
+  *
+  * @note    Dashed lines (MarkContextSetPattern) are drawn by drawsegmentctx
   */
 
-void drawlinem(INT x1, INT y1, INT x2, INT y2 ) {
+void drawlinemctx(DrawContextType *ctx, INT x1, INT y1, INT x2, INT y2 ) {
 INT d;
 INT t;
+INT s;
 INT incy = 1;
 int key = 0;
 
+    // Dashed lines carry the phase thru drawsegmentctx
+    if( ctx->patternlen ) {
+        drawsegmentctx(ctx,x1,y1,x2,y2,1);
+        return;
+    }
+
     // Use only upper semicircle (dy will be always positive)
     if( y2 < y1 ) {
         t = x1;
@@ -104,17 +187,92 @@ int key = 0;
     if( absdy > absdx ) key |= 1;
     if( /*x2 < x1*/ dx < 0  ) key |= 2;
 
+    // initial value for decision parameter d
+    if( key&1 ) {
+        d = absdx - (absdy/2);
+    } else {
+        d = absdy - (absdx/2);
+    }
+
+    // Restrict to the points inside the screen
+    if( !cliplinem(ctx,key,&x1,&y1,&x2,&y2,&d) ) return;
+
     // Start point
     INT x = x1;
     INT y = y1;
 
+    // Runs of points sharing a row (column) are emitted in one call
+    if( ctx->linemode==MARK_LINE_RUNS ) {
+        switch(key) {
+        case OCT0:
+            s = x;
+            while (x < x2) {
+                x++;
+                if (d < 0) {
+                    d += absdy;
+                } else {
+                    d += (absdy - absdx);
+                    MARKHRUN(ctx,s,x-1,y);
+                    s = x;
+                    y++;
+                }
+            }
+            MARKHRUN(ctx,s,x,y);
+            break;
+        case OCT1:
+            s = y;
+            while (y < y2) {
+                y++;
+                if (d < 0) {
+                    d += absdx;
+                } else {
+                    d += (absdx - absdy);
+                    MARKVRUN(ctx,x,s,y-1);
+                    s = y;
+                    x++;
+                }
+            }
+            MARKVRUN(ctx,x,s,y);
+            break;
+        case OCT2:
+            s = y;
+            while (y < y2) {
+                y++;
+                if (d < 0) {
+                    d += absdx;
+                } else {
+                    d += (absdx - absdy);
+                    MARKVRUN(ctx,x,s,y-1);
+                    s = y;
+                    x--;
+                }
+            }
+            MARKVRUN(ctx,x,s,y);
+            break;
+        case OCT3:
+            s = x;
+            while (x > x2) {
+                x--;
+                if (d < 0) {
+                    d += absdy;
+                } else {
+                    d += (absdy - absdx);
+                    MARKHRUN(ctx,x+1,s,y);
+                    s = x;
+                    y++;
+                }
+            }
+            MARKHRUN(ctx,x,s,y);
+            break;
+        }
+        return;
+    }
+
     // Jump to the corresponding octant processing
     switch(key) {
     case OCT0:
-        // initial value for decision parameter d
-        d = absdy - (absdx/2);
         // Plot initial given point
-        MARKPOINT(x,y);
+        MARKPOINTIN(ctx,x,y);
         // iterate through value of X, since dx > dy, it is incremented at every step
         while (x < x2) {
             x++;
@@ -125,14 +283,12 @@ int key = 0;
                 y++;
             }
             // Plot intermediate points
-            MARKPOINT(x,y);
+            MARKPOINTIN(ctx,x,y);
         }
         break;
     case OCT1:
-        // initial value for decision parameter d
-        d = absdx - (absdy/2);
         // Plot initial given point
-        MARKPOINT(x,y);
+        MARKPOINTIN(ctx,x,y);
         // iterate through value of y since dy > dx, y is incremented at every step
         while (y < y2) {
             y++;
@@ -143,14 +299,12 @@ int key = 0;
                 x++;
             }
             // Plot intermediate points
-            MARKPOINT(x,y);
+            MARKPOINTIN(ctx,x,y);
         }
         break;
     case OCT2:
-        // initial value for decision parameter d
-        d = absdx - (absdy/2);
         // Plot initial given point
-        MARKPOINT(x,y);
+        MARKPOINTIN(ctx,x,y);
         // iterate through value of y since dy > dx, y is incremented at every step
         while (y < y2) {
             y++;
@@ -161,14 +315,12 @@ int key = 0;
                 x--;
             }
             // Plot intermediate points
-            MARKPOINT(x,y);
+            MARKPOINTIN(ctx,x,y);
         }
         break;
     case OCT3:
-        // initial value for decision parameter d
-        d = absdy - (absdx/2);
         // Plot initial given point
-        MARKPOINT(x,y);
+        MARKPOINTIN(ctx,x,y);
         // iterate through value of X, since dx > dy, it is incremented at every step
         while (x > x2) {
             x--;
@@ -179,30 +331,89 @@ int key = 0;
                 y++;
             }
             // Plot intermediate points
-            MARKPOINT(x,y);
+            MARKPOINTIN(ctx,x,y);
         }
         break;
     }
 }
 
 
+/**
+ * @brief  x of the circle loop at row y (while x >= y)
+ *
+ * @note   The loop keeps x while x*x-x+y*y-r*r <= 0, and x only moves one
+ *         step in the octant, so x is the largest one that passes the test
+ */
+static INT circlemx(INT r, INT y) {
+INT lo = 0, hi = r, m;
+
+    while( lo < hi ) {
+        m = lo+(hi-lo+1)/2;
+        if( (LONGWIDE) m*m-m+(LONGWIDE) y*y <= (LONGWIDE) r*r ) lo = m;
+        else hi = m-1;
+    }
+    return lo;
+}
+
+
 /**
  * @brief  Draw circle using midpoint algorithm
  *
+ * @note   Circles outside the screen are rejected. Circles completely inside
+ *         the screen are drawn without bounds checking. For the others, only
+ *         the steps that can reach the screen are walked (see
+ *         MarkCurveWindows): the loop jumps from one window to the next.
+ *
+ * @note   In fill mode, each row is filled once. Rows yc+-y are final at
+ *         once, since y changes at every step. Rows yc+-x are coalesced.
+ *
+ * @note   With a dash pattern, each step is on or off for the 8 octants, as
+ *         in drawcirclebctx
  */
-void drawcirclem(INT xc, INT yc, INT r) {
+void drawcirclemctx(DrawContextType *ctx, INT xc, INT yc, INT r) {
+MarkClipResultType c;
+MarkWindowType w[MARK_CURVEWINDOWS];
+int ph,nw,k;
+
+    // A dashed contour is walked anyway, for the phase of the next figure
+    c = MarkClipBox(ctx,xc-r,yc-r,xc+r,yc+r);
+    if( c == MARK_OUTSIDE && (!ctx->patternlen || ctx->drawmode == MARK_FILL) ) return;
+    nw = c == MARK_PARTIAL ? MarkCurveWindows(ctx,xc,yc,r,r,1,1,w) : -1;
+    if( nw == 0 ) return;
+    k = 0;
 
     INT x = r;
     INT y = 0;
+    ph = ctx->patternphase;
+
+    if( !ctx->drawmode ) MARKCONTOURBEGIN(ctx,xc,yc);
 
-            if( markdrawmode ) {
-                MARKFILL(xc,yc,x,y);
+            if( ctx->drawmode ) {
+                MARKFILLBEGIN(ctx,xc,yc);
+                if( y < x ) MARKFILL(ctx,xc,yc,x,y);
+                MARKFILLROW(ctx,y,x);
+            } else if( ctx->patternlen && !ctx->ordering && !MARKPATTERNBIT(ctx,ph) ) {
+                // Off in the dash pattern: the same step of the 8 octants
+            } else if( c == MARK_INSIDE ) {
+                MARKCONTOUROCTIN(ctx,xc,yc,x,y);
             } else {
-                MARKCONTOUROCT(xc,yc,x,y);
+                MARKCONTOUROCT(ctx,xc,yc,x,y);
 }
+    if( ctx->patternlen ) MARKPATTERNSTEP(ctx,ph);
 
     INT P = 1 - r;
     while (x > y) {
+        if( nw > 0 ) {
+            // Next row in a window, or jump to the row before the next window
+            while( k < nw && y+1 > w[k].hi ) k++;
+            if( k == nw ) break;
+            if( y+1 < w[k].lo ) {
+                y = (INT) w[k].lo-1;
+                x = circlemx(r,y);
+                if( x <= y ) break;
+                P = (INT) ((LONGWIDE) x*x-x+((LONGWIDE) y+1)*(y+1)-(LONGWIDE) r*r);
+            }
+        }
         y++;
         // Mid-point is inside or on the perimeter
         if (P <= 0) {
@@ -218,91 +429,241 @@ void drawcirclem(INT xc, INT yc, INT r) {
             break;
 
         // Printing the generated point and its reflection
-        // in the other octants after translation
-            if( markdrawmode ) {
-                MARKFILL(xc,yc,x,y);
+        // in the other octants after translation.
+        // If the generated point is on the line x = y, the
+        // transposed points are not printed again (see MarkBorderPointsOctCtx)
+            if( ctx->drawmode ) {
+                if( y < x ) MARKFILL(ctx,xc,yc,x,y);
+                MARKFILLROW(ctx,y,x);
+            } else if( ctx->patternlen && !ctx->ordering && !MARKPATTERNBIT(ctx,ph) ) {
+                // Off in the dash pattern
+            } else if( c == MARK_INSIDE ) {
+                MARKCONTOUROCTIN(ctx,xc,yc,x,y);
             } else {
-                MARKCONTOUROCT(xc,yc,x,y);
+                MARKCONTOUROCT(ctx,xc,yc,x,y);
             }
-        // If the generated point is on the line x = y then
-        // the perimeter points have already been printed
-        if (x != y) {
-            if( markdrawmode ) {
-                MARKFILL(xc,yc,x,y);
-            } else {
-                MARKCONTOUROCT(xc,yc,x,y);
-            }
-        }
+            if( ctx->patternlen ) MARKPATTERNSTEP(ctx,ph);
+    }
+    if( ctx->drawmode ) {
+        MARKFILLEND(ctx);
+    } else {
+        if( ctx->patternlen && !ctx->ordering ) ctx->patternphase = ph;
+        MARKCONTOUREND(ctx);
     }
 }
 
 
+/**
+ * @brief   Ellipse loop for a width T of the decision terms
+ *
+ * @note    It is generated for LONG64 and, if available, LONG128. Both draw
+ *          the same points. The narrower one is used when the radii allow it
+ *          (see MarkEllipseRange)
+ */
+#define ELLIPSEM(NAME,T) \
+static void NAME(DrawContextType *ctx, MarkClipResultType c, \
+                 INT xc, INT yc, INT rx, INT ry) { \
+MarkWindowType wx[MARK_CURVEWINDOWS],wy[MARK_CURVEWINDOWS]; \
+INT x,y,x1,y1; \
+T d1,d2; \
+T dx,dy; \
+T rx2,ry2; \
+int nx,ny,kx,ky; \
+ \
+    /* Partly visible: windows of the steps in x (octant 0) and in y */ \
+    nx = ny = -1; \
+    if( c == MARK_PARTIAL ) { \
+        nx = MarkCurveWindows(ctx,xc,yc,rx,ry,0,0,wx); \
+        ny = MarkCurveWindows(ctx,xc,yc,rx,ry,1,0,wy); \
+        if( nx == 0 && ny == 0 ) return; \
+    } \
+    kx = 0; \
+    ky = ny-1; \
+ \
+    x = 0; \
+    y = ry; \
+ \
+    /* Precalculate squares */ \
+    rx2 = (T) rx*rx; \
+    ry2 = (T) ry*ry; \
+    /* Decision factor */ \
+    /* d1 = ry^2 - rx^2*ry - rx^2/4); */ \
+    /* d1, dx and dy are multplied by 4 to avoid floating point */ \
+    d1 = 4*ry2 - 4*rx2*ry + rx2; \
+    dx = 8*ry2*x; \
+    dy = 8*rx2*y; \
+ \
+    if( ctx->drawmode ) MARKFILLBEGIN(ctx,xc,yc); \
+    else MARKCONTOURBEGIN(ctx,xc,yc); \
+    /* Octant 0 */ \
+    while( dx < dy ) { \
+        if( nx >= 0 ) { \
+            /* Jump to the next window, or to the turn if there is none */ \
+            while( kx < nx && x > wx[kx].hi ) kx++; \
+            if( kx == nx || x < wx[kx].lo ) { \
+                x1 = MarkEllipseTurn(rx,ry,&y1); \
+                if( kx < nx && wx[kx].lo < x1 ) { \
+                    x = (INT) wx[kx].lo; \
+                    y = MarkEllipseY(rx,ry,x); \
+                } else { \
+                    x = x1; \
+                    y = y1; \
+                } \
+                dx = 8*ry2*x; \
+                dy = 8*rx2*y; \
+                d1 = 4*ry2*((T) x+1)*((T) x+1) + rx2*(2*(T) y-1)*(2*(T) y-1) - 4*rx2*ry2; \
+                if( dx >= dy ) break; \
+            } \
+        } \
+            if( ctx->drawmode ) { \
+                MARKFILLROW(ctx,x,y); \
+            } else if( c == MARK_INSIDE ) { \
+                MARKCONTOURQUADIN(ctx,xc,yc,x,y); \
+            } else { \
+                MARKCONTOURQUAD(ctx,xc,yc,x,y); \
+            } \
+        if( d1 < 0 ) { \
+            x++; \
+            dx += 8*ry2; \
+            d1 += dx + 4*ry2; \
+        } else { \
+            x++; \
+            y--; \
+            dx += 8*ry2; \
+            dy -= 8*rx2; \
+            d1 += dx - dy + 4*ry2; \
+        } \
+    } \
+ \
+    d2 = ry2*(2*x+1)*(2*x+1) + rx2*(2*y-2)*(2*y-2) - 4*rx2*ry2; \
+    /* Octant 1 */ \
+    x1 = x; \
+    while( y >= 0 ) { \
+        if( ny >= 0 ) { \
+            /* Jump to the last row of the next window, or to row 0 */ \
+            while( ky >= 0 && y < wy[ky].lo ) ky--; \
+            y1 = ky < 0 ? 0 : (INT) wy[ky].hi; \
+            if( y1 < y ) { \
+                y = y1; \
+                x = MarkEllipseX(rx,ry,y); \
+                if( x < x1 ) x = x1; \
+                dx = 8*ry2*x; \
+                dy = 8*rx2*y; \
+                d2 = ry2*(2*(T) x+1)*(2*(T) x+1) + rx2*(2*(T) y-2)*(2*(T) y-2) - 4*rx2*ry2; \
+            } \
+        } \
+            if( ctx->drawmode ) { \
+                MARKFILLROW(ctx,x,y); \
+            } else if( c == MARK_INSIDE ) { \
+                MARKCONTOURQUADIN(ctx,xc,yc,x,y); \
+            } else { \
+                MARKCONTOURQUAD(ctx,xc,yc,x,y); \
+            } \
+        if( y == 0 ) break; \
+ \
+        if( d2 > 0 ) { \
+            y--; \
+            dy -= 8*rx2; \
+            d2 += 4*rx2 - dy; \
+        } else { \
+            y--; \
+            x++; \
+            dx += 8*ry2; \
+            dy -= 8*rx2; \
+            d2 += dx - dy + 4*rx2; \
+        } \
+    } \
+    /* Flat ellipses (ry small) reach y = 0 before the tip */ \
+    while( x < rx ) { \
+        if( nx >= 0 ) { \
+            while( kx < nx && x+1 > wx[kx].hi ) kx++; \
+            if( kx == nx ) break; \
+            if( x+1 < wx[kx].lo ) x = (INT) wx[kx].lo-1; \
+        } \
+        x++; \
+            if( ctx->drawmode ) { \
+                MARKFILLROW(ctx,x,y); \
+            } else if( c == MARK_INSIDE ) { \
+                MARKCONTOURQUADIN(ctx,xc,yc,x,y); \
+            } else { \
+                MARKCONTOURQUAD(ctx,xc,yc,x,y); \
+            } \
+    } \
+    if( ctx->drawmode ) MARKFILLEND(ctx); \
+    else MARKCONTOUREND(ctx); \
+}
+
+ELLIPSEM(ellipsem64,LONG64)
+#ifdef LONG128
+ELLIPSEM(ellipsem128,LONG128)
+#endif
+
+
 /**
  * @brief   Draw an ellipse using midpoint algorithm
  *
  * @note    Ellipse axes are horizontal and vertical
  *
  * @note    Draw in first quadrant and mirror the points to other quadrants
+ *
+ * @note    Ellipses outside the screen are rejected. Ellipses completely inside
+ *          the screen are drawn without bounds checking. For the others, each
+ *          region jumps over the steps that cannot reach the screen (see
+ *          MarkCurveWindows), from the point found with MarkEllipseY or
+ *          MarkEllipseX and its decision terms computed again.
+ *
+ * @note    In fill mode, points of the same row are coalesced and each row
+ *          is filled once
+ *
+ * @note    Large radii use 128 bit decision terms. Ellipses out of range
+ *          (see MarkEllipseRange) are not drawn
  */
-void drawellipsem(INT xc, INT yc, INT rx, INT ry) {
-INT x,y;
-LONG d1,d2;
-LONG dx,dy;
-LONG rx2,ry2;
-
-    //
-    x = 0;
-    y = ry;
-
-    // Precalculate squares
-    rx2 = rx*rx;
-    ry2 = ry*ry;
-    // Decision factor
-    // d1 = ry^2 - rx^2*ry - rx^2/4);
-    // d1, dx and dy are multplied by 4 to avoid floating point
-    d1 = 4*ry2 - 4*rx2*ry + rx2;
-    dx = 8*ry2*x;
-    dy = 8*rx2*y;
-
-    // Octant 0
-    while( dx < dy ) {
-            if( markdrawmode ) {
-                MARKFILL(xc,yc,x,y);
-            } else {
-                MARKCONTOURQUAD(xc,yc,x,y);
-            }
-        if( d1 < 0 ) {
-            x++;
-            dx += 8*ry2;
-            d1 += dx + 4*ry2;
-        } else {
-            x++;
-            y--;
-            dx += 8*ry2;
-            dy -= 8*rx2;
-            d1 += dx - dy + 4*ry2;
-        }
+void drawellipsemctx(DrawContextType *ctx, INT xc, INT yc, INT rx, INT ry) {
+MarkRangeType range;
+MarkClipResultType c;
+
+    range = MarkEllipseRange(xc,yc,rx,ry);
+    if( range == MARK_RANGE_NONE ) return;
+
+    // A dashed contour in path order is walked anyway, for the phase
+    c = MarkClipBox(ctx,xc-rx,yc-ry,xc+rx,yc+ry);
+    if( c == MARK_OUTSIDE && (!ctx->patternlen || ctx->order != MARK_ORDER_PATH ||
+                              ctx->drawmode == MARK_FILL) ) return;
+
+#ifdef LONG128
+    if( range == MARK_RANGE_LONG128 ) {
+        ellipsem128(ctx,c,xc,yc,rx,ry);
+        return;
     }
+#endif
+    ellipsem64(ctx,c,xc,yc,rx,ry);
+}
 
-    d2 = ry2*(2*x+1)*(2*x+1) + rx2*(2*y-2)*(2*y-2) - 4*rx2*ry2;
-    // Octant 1
-    while( y >= 0 ) {
-            if( markdrawmode ) {
-                MARKFILL(xc,yc,x,y);
-            } else {
-                MARKCONTOURQUAD(xc,yc,x,y);
+
+/**
+ * @brief   Old interface. Draw on markscreen using the global variables
+ *
+ * @note    A context is built from them at each call (see MarkGlobalContext)
+ */
+///@{
+void drawlinem(INT x1, INT y1, INT x2, INT y2) {
+DrawContextType ctx;
+
+    MarkGlobalContext(&ctx);
+    drawlinemctx(&ctx,x1,y1,x2,y2);
 }
 
-        if( d2 > 0 ) {
-            y--;
-            dy -= 8*rx2;
-            d2 += 4*rx2 - dy;
-        } else {
-            y--;
-            x++;
-            dx += 8*ry2;
-            dy -= 8*rx2;
-            d2 += dx - dy - 4*rx2;
-        }
-    }
+void drawcirclem(INT xc, INT yc, INT r) {
+DrawContextType ctx;
+
+    MarkGlobalContext(&ctx);
+    drawcirclemctx(&ctx,xc,yc,r);
+}
+
+void drawellipsem(INT xc, INT yc, INT rx, INT ry) {
+DrawContextType ctx;
+
+    MarkGlobalContext(&ctx);
+    drawellipsemctx(&ctx,xc,yc,rx,ry);
 }
+///@}
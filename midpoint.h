@@ -17,9 +17,15 @@
 #define LONG    long
 #endif
 
+#include "mark.h"
+
 
 void drawlinem(INT x1, INT y1, INT x2, INT y2);
 void drawcirclem(INT xc, INT yc, INT r);
 void drawellipsem(INT xc, INT yc, INT rx, INT ry);
 
+void drawlinemctx(DrawContextType *ctx, INT x1, INT y1, INT x2, INT y2);
+void drawcirclemctx(DrawContextType *ctx, INT xc, INT yc, INT r);
+void drawellipsemctx(DrawContextType *ctx, INT xc, INT yc, INT rx, INT ry);
+
 #endif
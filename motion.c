@@ -0,0 +1,294 @@
+/**
+ * @file    motion.c
+ *
+ * @brief   Turn the points of the drawing routines into a stream of steps
+ *          (step and direction) for CNC equipment and plotters
+ *
+ * @note    A point next to the pen (8-connected) is one step. Other points
+ *          lift the pen, travel with steps to the point and lower the pen
+ *          there. Repeated points are dropped.
+ *
+ * @note    Lines, curves and polylines send their points in order. Circles
+ *          and ellipses are sent in path order (MARK_ORDER_PATH) when storage
+ *          for an octant is given, so they are drawn with a single pen down.
+ *
+ * @note    The ring buffer is shared by a producer and a consumer. A mutex
+ *          guards the counters, conditions wake the side that waits.
+ *
+ * @author  Hans
+ *
+ * @version 1.0
+ *
+ * @date    17/10/2026
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include "motion.h"
+#include "mark.h"
+
+#define ABS(X)  ((X)>0?(X):-(X))
+#define SIGN(X) ((X)>0?1:((X)<0?-1:0))
+
+#define MOTION_PENUPCODE    0x00
+#define MOTION_PENDOWNCODE  0x01
+
+
+/**
+ * @brief   Initialize a motion stream
+ *
+ * @note    ring (size bytes) is the ring buffer. quad (quadsize points) is
+ *          the octant buffer of the path order of the contexts; it may be
+ *          NULL, then circles and ellipses are mirrored (not continuous). The
+ *          pen starts up at (0,0).
+ *
+ * @return  0 if the ring is empty
+ */
+int MotionInit(MotionType *m, unsigned char *ring, size_t size,
+               MarkPointType *quad, size_t quadsize) {
+
+    if( !ring || size == 0 ) return 0;
+
+    m->ring = ring;
+    m->size = size;
+    m->head = m->tail = 0;
+    m->code = m->count = 0;
+    m->closed = 0;
+    m->x = m->y = 0;
+    m->pen = 0;
+    m->quad = quad;
+    m->quadsize = quad ? quadsize : 0;
+    m->steps = m->travel = m->penups = 0;
+    pthread_mutex_init(&m->lock,0);
+    pthread_cond_init(&m->notfull,0);
+    pthread_cond_init(&m->notempty,0);
+    return 1;
+}
+
+
+/**
+ * @brief   Release the mutex and the conditions of a stream
+ */
+void MotionDestroy(MotionType *m) {
+
+    pthread_cond_destroy(&m->notempty);
+    pthread_cond_destroy(&m->notfull);
+    pthread_mutex_destroy(&m->lock);
+}
+
+
+/**
+ * @brief   Initialize a context whose sinks feed a motion stream
+ *
+ * @note    There is no screen. Clipping (MarkContextSetClip) still applies.
+ *          Circles and ellipses are sent in path order.
+ */
+void MotionContextInit(DrawContextType *ctx, MotionType *m) {
+
+    MarkContextInit(ctx,0);
+    MarkContextSetOrder(ctx,MARK_ORDER_PATH,m->quad,m->quadsize);
+    ctx->point = MotionPoint;
+    ctx->hrun = MotionHorizRun;
+    ctx->vrun = MotionVertRun;
+    ctx->blend = 0;
+    ctx->user = m;
+}
+
+
+/**
+ * @brief   Write a code in the ring, waiting while it is full
+ */
+static void motionput(MotionType *m, unsigned char code) {
+
+    pthread_mutex_lock(&m->lock);
+    while( m->head - m->tail == m->size )
+        pthread_cond_wait(&m->notfull,&m->lock);
+    m->ring[m->head % m->size] = code;
+    m->head++;
+    pthread_cond_signal(&m->notempty);
+    pthread_mutex_unlock(&m->lock);
+}
+
+
+/**
+ * @brief   Write the code being packed, if any
+ */
+static void motionpending(MotionType *m) {
+
+    if( m->count > 0 ) {
+        motionput(m,(unsigned char)((m->code<<4) | (m->count-1)));
+        m->count = 0;
+    }
+}
+
+
+/**
+ * @brief   Code of a move of an axis (-1, 0 or +1)
+ */
+static int motionaxis(INT d) {
+
+    if( d > 0 ) return MOTION_AXISPLUS;
+    if( d < 0 ) return MOTION_AXISMINUS;
+    return MOTION_AXISNONE;
+}
+
+
+/**
+ * @brief   One step of the pen, packed with the previous ones if equal
+ */
+static void motionstep(MotionType *m, INT dx, INT dy) {
+int code;
+
+    code = (motionaxis(dx)<<2) | motionaxis(dy);
+    if( m->count > 0 && m->code == code && m->count < MOTION_MAXRUN ) {
+        m->count++;
+    } else {
+        motionpending(m);
+        m->code = code;
+        m->count = 1;
+    }
+    m->x += dx;
+    m->y += dy;
+    if( m->pen )
+        m->steps++;
+    else
+        m->travel++;
+}
+
+
+/**
+ * @brief   Lift or lower the pen
+ */
+static void motionpen(MotionType *m, int down) {
+
+    if( m->pen == down ) return;
+    motionpending(m);
+    motionput(m,down ? MOTION_PENDOWNCODE : MOTION_PENUPCODE);
+    m->pen = down;
+    if( !down ) m->penups++;
+}
+
+
+/**
+ * @brief   Travel (pen up) to (x,y), diagonally first
+ */
+void MotionMoveTo(MotionType *m, INT x, INT y) {
+
+    motionpen(m,0);
+    while( m->x != x || m->y != y )
+        motionstep(m,SIGN(x-m->x),SIGN(y-m->y));
+}
+
+
+/**
+ * @brief   Point sink: step to the point, or travel to it
+ */
+void MotionPoint(DrawContextType *ctx, INT x, INT y) {
+MotionType *m = (MotionType *)ctx->user;
+INT dx,dy;
+
+    dx = x - m->x;
+    dy = y - m->y;
+    if( m->pen && dx == 0 && dy == 0 ) return;
+    if( m->pen && ABS(dx) <= 1 && ABS(dy) <= 1 ) {
+        motionstep(m,dx,dy);
+        return;
+    }
+    MotionMoveTo(m,x,y);
+    motionpen(m,1);
+}
+
+
+/**
+ * @brief   Run sinks: the points of the run, from the end nearest the pen
+ */
+///@{
+void MotionHorizRun(DrawContextType *ctx, INT x1, INT x2, INT y) {
+MotionType *m = (MotionType *)ctx->user;
+INT x,t;
+
+    if( x1 > x2 ) { t = x1; x1 = x2; x2 = t; }
+    if( ABS(x2-m->x) < ABS(x1-m->x) ) {
+        for( x = x2; x >= x1; x-- ) MotionPoint(ctx,x,y);
+    } else {
+        for( x = x1; x <= x2; x++ ) MotionPoint(ctx,x,y);
+    }
+}
+
+void MotionVertRun(DrawContextType *ctx, INT x, INT y1, INT y2) {
+MotionType *m = (MotionType *)ctx->user;
+INT y,t;
+
+    if( y1 > y2 ) { t = y1; y1 = y2; y2 = t; }
+    if( ABS(y2-m->y) < ABS(y1-m->y) ) {
+        for( y = y2; y >= y1; y-- ) MotionPoint(ctx,x,y);
+    } else {
+        for( y = y1; y <= y2; y++ ) MotionPoint(ctx,x,y);
+    }
+}
+///@}
+
+
+/**
+ * @brief   Write the code being packed
+ */
+void MotionFlush(MotionType *m) {
+
+    motionpending(m);
+}
+
+
+/**
+ * @brief   End the stream: lift the pen and wake the consumer
+ */
+void MotionClose(MotionType *m) {
+
+    motionpen(m,0);
+    motionpending(m);
+    pthread_mutex_lock(&m->lock);
+    m->closed = 1;
+    pthread_cond_broadcast(&m->notempty);
+    pthread_mutex_unlock(&m->lock);
+}
+
+
+/**
+ * @brief   Pull up to max codes from the ring
+ *
+ * @note    If wait is not zero, wait for one code at least, unless the stream
+ *          is closed.
+ *
+ * @return  Number of codes read (0 at the end of a closed stream)
+ */
+size_t MotionRead(MotionType *m, unsigned char *buf, size_t max, int wait) {
+size_t n = 0;
+
+    pthread_mutex_lock(&m->lock);
+    while( wait && m->head == m->tail && !m->closed )
+        pthread_cond_wait(&m->notempty,&m->lock);
+    while( n < max && m->tail != m->head ) {
+        buf[n++] = m->ring[m->tail % m->size];
+        m->tail++;
+    }
+    if( n > 0 )
+        pthread_cond_signal(&m->notfull);
+    pthread_mutex_unlock(&m->lock);
+    return n;
+}
+
+
+/**
+ * @brief   Decode a code: a command, or n steps of (dx,dy)
+ */
+MotionCodeType MotionDecode(unsigned char code, int *dx, int *dy, int *n) {
+static const int axis[4] = { 0, 1, 0, -1 };
+
+    *dx = axis[(code>>6) & 3];
+    *dy = axis[(code>>4) & 3];
+    *n = (code & 15) + 1;
+    if( (code>>4) == 0 ) {
+        *n = 0;
+        return (code & 1) ? MOTION_PENDOWN : MOTION_PENUP;
+    }
+    return MOTION_STEP;
+}
@@ -0,0 +1,84 @@
+#ifndef MOTION_H
+#define MOTION_H
+/**
+ * @file    motion.h
+ * @brief   Step and direction stream for CNC equipment and plotters
+ *
+ * @note    The points drawn thru a motion context are turned into steps of a
+ *          pen. Each step moves each axis by -1, 0 or +1 (2 bits per axis).
+ *          Equal steps are packed in a byte: the step in the high nibble and
+ *          the count minus 1 in the low nibble. A high nibble of 0 (no move)
+ *          is a command: pen up (0x00) or pen down (0x01).
+ *
+ * @note    The codes go to a ring buffer given by the caller. The producer
+ *          (the drawing routines) waits when it is full. A consumer (another
+ *          thread) pulls them with MotionRead. Nothing is allocated.
+ *
+ * @version 1.0
+ * Date:    17/10/2026
+ *
+ */
+
+#ifndef INT
+#define INT     int
+#endif
+
+#ifndef LONG
+#define LONG    long
+#endif
+
+#include <stddef.h>
+#include <pthread.h>
+#include "mark.h"
+
+/**
+ * @brief   Codes of an axis and decoded codes
+ */
+///@{
+#define MOTION_AXISNONE     0
+#define MOTION_AXISPLUS     1
+#define MOTION_AXISMINUS    3
+#define MOTION_MAXRUN       16          // Steps packed in a code
+
+typedef enum { MOTION_STEP, MOTION_PENUP, MOTION_PENDOWN } MotionCodeType;
+///@}
+
+/**
+ * @brief   Motion stream
+ *
+ * @note    head and tail count the codes written and read. The code being
+ *          packed is written when the step changes or the run is full.
+ */
+typedef struct {
+    unsigned char      *ring;           // Storage of the caller
+    size_t              size;
+    size_t              head,tail;
+    int                 code,count;     // Code being packed (count 0: none)
+    int                 closed;
+    INT                 x,y;            // Position of the pen
+    int                 pen;            // Pen down
+    MarkPointType      *quad;           // Storage of the caller for an octant
+    size_t              quadsize;       //  (see MarkContextSetOrder)
+    unsigned long       steps;          // Steps with the pen down
+    unsigned long       travel;         // Steps with the pen up
+    unsigned long       penups;
+    pthread_mutex_t     lock;
+    pthread_cond_t      notfull,notempty;
+} MotionType;
+
+int  MotionInit(MotionType *m, unsigned char *ring, size_t size,
+                MarkPointType *quad, size_t quadsize);
+void MotionDestroy(MotionType *m);
+void MotionContextInit(DrawContextType *ctx, MotionType *m);
+
+void MotionPoint(DrawContextType *ctx, INT x, INT y);
+void MotionHorizRun(DrawContextType *ctx, INT x1, INT x2, INT y);
+void MotionVertRun(DrawContextType *ctx, INT x, INT y1, INT y2);
+void MotionMoveTo(MotionType *m, INT x, INT y);
+
+void MotionFlush(MotionType *m);
+void MotionClose(MotionType *m);
+size_t MotionRead(MotionType *m, unsigned char *buf, size_t max, int wait);
+MotionCodeType MotionDecode(unsigned char code, int *dx, int *dy, int *n);
+
+#endif // MOTION_H
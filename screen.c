@@ -3,7 +3,14 @@
  *
  * @brief   Manages a virtual bitmap
 
- * @note    Only binary files (PBM)
+ * @note    Binary files (PBM), in ASCII (P1) or raw (P4) format, gray level
+ *          files (PGM, P5) and color files (PPM, P6)
+ *
+ * @note    The format is chosen at creation. Points and runs are drawn thru
+ *          the routines of the format (see ScreenOpsType)
+ *
+ * @note    PBM screens can also be sparse: tiles allocated when written
+ *          (ScreenCreateSparse), or mapped from a file (ScreenCreateMapped)
  *
  * @author  Hans
  *
@@ -14,217 +21,1520 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stddef.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "screen.h"
 #include "mark.h"
+#include "screenkernels.h"
+
+
+static const ScreenOpsType *ScreenFormatOps(ImageFormatType fmt);
+static const ScreenOpsType opstiles;
 
 
 /**
- * @brief Simple Graphics Image routines
+ * @brief   Tiles of a sparse screen
+ *
+ * @note    tile[] has a pointer for each tile, row by row, to the
+ *          SCREEN_TILEBYTES x SCREEN_TILESIZE bytes of the tile. Tiles never
+ *          written point to a shared tile (all zero, or all one after a
+ *          fill), which is never written: it is replaced by a copy from the
+ *          pool first
+ *
+ * @note    The pool hands out the tiles of its chunks in order. A fill gives
+ *          them all back, the chunks are kept
+ *
+ * @note    The bands of DisplayListRender are drawn by several threads, and
+ *          two bands can share a tile. The pool and the copy of a shared tile
+ *          are guarded by lock. A pointer of tile[] is read without it
+ *          (atomic load): once a tile is copied, it never changes
  */
-///@{
-typedef enum { PBM, PGM, PPM } ImageFormatType;
-
-typedef struct ScreenStruct {
-    ImageFormatType fmt;        // For now, only PBM
-    INT             w;          // width in pixels
-    INT             wbytes;     // width in bytes
-    INT             h;          // height in pixels
-    unsigned char   data[];
-} ScreenType;
-///@}
+#define SCREEN_TILEAREA     (SCREEN_TILEBYTES*SCREEN_TILESIZE)
+#define SCREEN_POOLTILES    256
+
+struct ScreenTilesStruct {
+    unsigned char **tile;
+    INT             tw,th;          // Tiles in a row and in a column
+    unsigned char **chunk;          // Chunks of the pool
+    int             nchunks,maxchunks;
+    int             current;        // Chunk in use (-1: none)
+    int             used;           // Tiles used in it
+    unsigned long   allocated;      // Tiles in use
+    pthread_mutex_t lock;           // Pool and copies of shared tiles
+};
+
+static unsigned char zerotile[SCREEN_TILEAREA];
+static unsigned char onetile[SCREEN_TILEAREA];
+static int onetileready = 0;
+
 
 /**
  * @brief   Create a Screen
  *
  * @note    It uses only one malloc call. The struct is a header
+ *
+ * @note    The drawing routines of the format are chosen here. The ink is
+ *          set to the maximum value (white, opaque) and the screen is
+ *          cleared
  */
-ScreenType *ScreenCreate(int width, int height) {
+ScreenType *ScreenCreateFormat(int width, int height, ImageFormatType fmt) {
 ScreenType *screen;
 INT widthbytes,sizebytes;
+INT bpp;
 
-    widthbytes = (width+7)/8;
+    switch(fmt) {
+    case PBM: bpp = 0; break;
+    case PGM: bpp = 1; break;
+    case PPM: bpp = 3; break;
+    case PAM: bpp = 4; break;
+    default:  return 0;
+    }
+    widthbytes = bpp ? width*bpp : (width+7)/8;
     sizebytes  = height*widthbytes+32;
 
     screen = (ScreenType *) malloc(sizeof(ScreenType)+sizebytes);
     if( !screen )
         return 0;
 
-    screen->fmt = PBM;
+    screen->fmt = fmt;
     screen->w = width;
     screen->h = height;
     screen->wbytes = widthbytes;
+    screen->bpp = bpp;
+    screen->ops = ScreenFormatOps(fmt);
+    screen->writes = 0;
+    screen->dirty = 0;
+    screen->map = 0;
+    screen->mapsize = 0;
+    screen->tiles = 0;
+    memset(screen->ink,0xFF,sizeof(screen->ink));
 
+    ScreenKernelsInit();
     ScreenFill(screen,0);
 
     return screen;
 }
 
+
 /**
- * @brief  ScreenDestroy
- *
- * @note   Long description of function
+ * @brief   Create a sparse PBM Screen
  *
- * @param  Description of parameter
+ * @note    There is no data[]: the screen is a directory of tiles (see
+ *          ScreenTilesType), so the memory used depends on the tiles drawn,
+ *          not on the size. Points and runs are drawn by the routines of the
+ *          format as usual, but the direct bitmap loops are not used
+ *          (MarkContextInit selects the routines of the format)
  *
- * @return Description of return parameters
+ * @return  NULL if there is no memory
  */
+ScreenType *ScreenCreateSparse(INT width, INT height) {
+ScreenType *screen;
+ScreenTilesType *t;
 
-void ScreenDestroy(ScreenType *screen) {
+    if( width <= 0 || height <= 0 ) return 0;
+    if( !onetileready ) {
+        memset(onetile,0xFF,sizeof(onetile));
+        onetileready = 1;
+    }
 
-    // Just in case
-    screen->fmt = 0;
-    screen->w   = 0;
-    screen->h   = 0;
-    screen->wbytes = 0;
+    screen = (ScreenType *) malloc(sizeof(ScreenType));
+    t = (ScreenTilesType *) malloc(sizeof(ScreenTilesType));
+    if( !screen || !t ) {
+        free(screen);
+        free(t);
+        return 0;
+    }
+    t->tw = (width+SCREEN_TILESIZE-1)/SCREEN_TILESIZE;
+    t->th = (height+SCREEN_TILESIZE-1)/SCREEN_TILESIZE;
+    t->tile = (unsigned char **) malloc((size_t) t->tw*t->th*sizeof(unsigned char *));
+    t->chunk = 0;
+    t->nchunks = t->maxchunks = 0;
+    if( !t->tile ) {
+        free(screen);
+        free(t);
+        return 0;
+    }
+    pthread_mutex_init(&t->lock,0);
 
-    free(screen);
+    screen->fmt = PBM;
+    screen->w = width;
+    screen->h = height;
+    screen->wbytes = (width+7)/8;
+    screen->bpp = 0;
+    screen->ops = &opstiles;
+    screen->writes = 0;
+    screen->dirty = 0;
+    screen->map = 0;
+    screen->mapsize = 0;
+    screen->tiles = t;
+    memset(screen->ink,0xFF,sizeof(screen->ink));
+
+    ScreenKernelsInit();
+    ScreenFill(screen,0);
 
+    return screen;
 }
+
+
 /**
- * @brief   ScreenFill
+ * @brief   Tiles allocated by a sparse screen (0 for the others)
+ */
+unsigned long ScreenSparseTiles(ScreenType *screen) {
+
+    return (screen && screen->tiles) ? screen->tiles->allocated : 0;
+}
+
+
+/**
+ * @brief   Take a tile from the pool
  *
- * @note    Fill a screen with value
+ * @return  NULL if there is no memory
  */
-void ScreenFill(ScreenType *screen, int value) {
-int i;
+static unsigned char *ScreenTileAlloc(ScreenTilesType *t) {
+unsigned char **chunk;
+
+    if( t->current < 0 || t->used == SCREEN_POOLTILES ) {
+        if( t->current+1 == t->nchunks ) {
+            if( t->nchunks == t->maxchunks ) {
+                chunk = (unsigned char **) realloc(t->chunk,(t->maxchunks*2+8)*sizeof(unsigned char *));
+                if( !chunk ) return 0;
+                t->chunk = chunk;
+                t->maxchunks = t->maxchunks*2+8;
+            }
+            t->chunk[t->nchunks] = (unsigned char *) malloc(SCREEN_POOLTILES*SCREEN_TILEAREA);
+            if( !t->chunk[t->nchunks] ) return 0;
+            t->nchunks++;
+        }
+        t->current++;
+        t->used = 0;
+    }
+    t->allocated++;
+    return t->chunk[t->current]+(size_t) SCREEN_TILEAREA*t->used++;
+}
+
+
+/**
+ * @brief   Tile (tx,ty) ready to be written (a shared tile is copied first)
+ *
+ * @note    The all one tile is returned as is: its bits are already set and
+ *          it must not be written
+ *
+ * @note    Thread safe: the tile is checked again under the lock, so two
+ *          threads never copy the same shared tile
+ *
+ * @return  NULL if there is no memory
+ */
+static unsigned char *ScreenTileWritable(ScreenTilesType *t, INT tx, INT ty) {
+unsigned char **p = &(t->tile[ty*t->tw+tx]);
+unsigned char *n;
 
-    for(int i=0;i<(screen->wbytes*screen->h);i++)
-        screen->data[i] = value;
+    n = __atomic_load_n(p,__ATOMIC_ACQUIRE);
+    if( n != zerotile ) return n;
+    pthread_mutex_lock(&t->lock);
+    n = __atomic_load_n(p,__ATOMIC_ACQUIRE);
+    if( n == zerotile ) {
+        n = ScreenTileAlloc(t);
+        if( n ) {
+            memset(n,0,SCREEN_TILEAREA);
+            __atomic_store_n(p,n,__ATOMIC_RELEASE);
+        }
+    }
+    pthread_mutex_unlock(&t->lock);
+    return n;
+}
+
+
+/**
+ * @brief   Row y of a sparse screen, copied into row (wbytes bytes)
+ *
+ * @note    Tiles never written are read as runs of zeros (or ones after a
+ *          fill)
+ *
+ * @return  row
+ */
+static unsigned char *ScreenTilesRow(ScreenType *screen, INT y, unsigned char *row) {
+ScreenTilesType *t = screen->tiles;
+unsigned char **tile = &(t->tile[(y/SCREEN_TILESIZE)*t->tw]);
+INT off = (y%SCREEN_TILESIZE)*SCREEN_TILEBYTES;
+INT n;
 
+    for(INT tx=0;tx<t->tw;tx++) {
+        n = screen->wbytes-tx*SCREEN_TILEBYTES;
+        if( n > SCREEN_TILEBYTES ) n = SCREEN_TILEBYTES;
+        if( tile[tx] == zerotile )
+            memset(row+tx*SCREEN_TILEBYTES,0,n);
+        else
+            memcpy(row+tx*SCREEN_TILEBYTES,tile[tx]+off,n);
+    }
+    return row;
 }
 
 
 /**
- * @brief   Write a binary image into a file
+ * @brief   Write the bytes b1 to b2 of row into row y of a sparse screen
  *
- * @note    It uses the uncompressed format
+ * @note    Tiles whose bytes do not change are not touched (not allocated)
  */
-void ScreenWritePBM(ScreenType *screen, FILE *fout) {
-INT wid;
-unsigned char *p;
-char ch;
+static void ScreenTilesWriteRow(ScreenType *screen, INT y, const unsigned char *row, INT b1, INT b2) {
+ScreenTilesType *t = screen->tiles;
+INT ty = y/SCREEN_TILESIZE;
+INT off = (y%SCREEN_TILESIZE)*SCREEN_TILEBYTES;
+INT a,b;
+unsigned char **p;
+unsigned char *tile;
 
-    wid = (screen->w+7)/8;
-    fprintf(fout,"P1\n%d\n%d\n",screen->w,screen->h);
-    for(int j=0;j<screen->h;j++) {
-        p = &(screen->data[j*wid]);
-        unsigned char m = '\x80';
-        for(int i=0;i<screen->w;i++) {
-            if( *p&m ) {
-                ch = '1';
-            } else {
-                ch = '0';
-            }
-            fputc(ch,fout);
-            m >>= 1;
-            if( m == 0 ) {
-                m = '\x80';
-                p++;
+    for(INT tx=b1/SCREEN_TILEBYTES;tx<=b2/SCREEN_TILEBYTES;tx++) {
+        a = tx*SCREEN_TILEBYTES;
+        b = a+SCREEN_TILEBYTES-1;
+        if( a < b1 ) a = b1;
+        if( b > b2 ) b = b2;
+        p = &(t->tile[ty*t->tw+tx]);
+        tile = __atomic_load_n(p,__ATOMIC_ACQUIRE);
+        if( memcmp(tile+off+a%SCREEN_TILEBYTES,row+a,b-a+1) == 0 ) continue;
+        if( tile == onetile ) {
+            // Some bits are cleared: the all one tile is copied, once
+            pthread_mutex_lock(&t->lock);
+            tile = __atomic_load_n(p,__ATOMIC_ACQUIRE);
+            if( tile == onetile ) {
+                tile = ScreenTileAlloc(t);
+                if( tile ) {
+                    memcpy(tile,onetile,SCREEN_TILEAREA);
+                    __atomic_store_n(p,tile,__ATOMIC_RELEASE);
+                }
             }
+            pthread_mutex_unlock(&t->lock);
+            if( !tile ) return;
+        } else {
+            tile = ScreenTileWritable(t,tx,ty);
+            if( !tile ) return;
         }
-        fputc('\n',fout);
+        memcpy(tile+off+a%SCREEN_TILEBYTES,row+a,b-a+1);
     }
 }
 
 
 /**
- * @brief Bit mask for each bit
+ * @brief   Fill all the tiles with value
  *
- * @note  I hope it is faster than  (1<<(7-x))
+ * @note    All zero and all one use the shared tiles, so the pool is given
+ *          back. Other values need all the tiles
  */
-static const unsigned char mask[] = { '\x80','\x40','\x20','\x10','\x08','\x04','\x02','\x01' };
+static void ScreenTilesFill(ScreenTilesType *t, int value) {
+size_t n = (size_t) t->tw*t->th;
+unsigned char *tile;
+
+    t->current = -1;
+    t->used = 0;
+    t->allocated = 0;
+    for(size_t i=0;i<n;i++) {
+        if( (value&0xFF) == 0 ) {
+            t->tile[i] = zerotile;
+        } else if( (value&0xFF) == 0xFF ) {
+            t->tile[i] = onetile;
+        } else {
+            tile = ScreenTileAlloc(t);
+            t->tile[i] = tile ? tile : zerotile;
+            if( tile ) memset(tile,value,SCREEN_TILEAREA);
+        }
+    }
+}
 
 
 /**
- * @brief Plot point
+ * @brief   Free the tiles of a sparse screen
+ */
+static void ScreenTilesFree(ScreenTilesType *t) {
+
+    pthread_mutex_destroy(&t->lock);
+    for(int i=0;i<t->nchunks;i++)
+        free(t->chunk[i]);
+    free(t->chunk);
+    free(t->tile);
+    free(t);
+}
+
+
+/**
+ * @brief   Bytes of the header of a mapped screen file (see ScreenCreateMapped)
  *
- * @note  it will be used as a callback
+ * @note    A multiple of the usual page sizes (4 KB to 64 KB)
  */
-void ScreenDrawPoint(ScreenType *screen, INT x, INT y) {
-INT wid;
-unsigned char *line;
-int col,bit;
+#define SCREEN_MAPHEADER    65536
 
-    if( !screen ) return;
-    if( x < 0 ) return;
-    if( x >= screen->w ) return;
-    if( y < 0 ) return;
-    if( y >= screen->h ) return;
+/**
+ * @brief   Create a PBM Screen stored in a binary (P4) file
+ *
+ * @note    The file is mapped, so drawing writes the file (thru the page
+ *          cache) and there is nothing to save. Only the pages touched use
+ *          memory, so the canvas can be larger than RAM. For more than 2 GB
+ *          of raster, define INT as long (offsets are y*wbytes): with a
+ *          narrower INT, such a raster is refused
+ *
+ * @note    The header of the file is padded (with a comment) to
+ *          SCREEN_MAPHEADER bytes, whatever the page size, so a file made on
+ *          one system opens on another. The raster starts on a page of the
+ *          file, and is mapped after private pages that hold the struct,
+ *          then data[] is the raster. Pages larger than SCREEN_MAPHEADER are
+ *          not supported
+ *
+ * @note    A missing or empty file is made a clear canvas (the file is
+ *          sparse until drawn). A file made by this routine with the same
+ *          size is opened as it is, so a job can continue a canvas. Any
+ *          other file is left alone and NULL is returned
+ *
+ * @note    The rows are advised for random access (a line touches a byte or
+ *          two of many rows). Routines that sweep rows advise them (see
+ *          ScreenAdviseRows)
+ *
+ * @return  NULL if the file cannot be created or mapped, if it holds
+ *          something else, or if the raster cannot be addressed with INT
+ *          offsets
+ */
+ScreenType *ScreenCreateMapped(const char *path, INT width, INT height) {
+ScreenType *screen;
+char header[64],*top;
+size_t page,rasterbytes,headerbytes,mapsize;
+INT widthbytes;
+struct stat st;
+int fd,n,same;
+void *map;
 
-//    wid = (screen->w+7)/8;
-    wid = screen->wbytes;
-    line = &(screen->data[y*wid]);
-    col = x/8;
-    bit = x&7;
-    line[col] |= mask[bit];
+    if( width <= 0 || height <= 0 ) return 0;
+    page = (size_t) sysconf(_SC_PAGESIZE);
+    headerbytes = SCREEN_MAPHEADER;
+    if( headerbytes % page != 0 || headerbytes < sizeof(ScreenType) ) return 0;
+    widthbytes  = (width+7)/8;
+    rasterbytes = (size_t) height*widthbytes;
+    mapsize     = headerbytes+rasterbytes+32;
+    if( sizeof(INT) < sizeof(size_t) && rasterbytes > (size_t) INT_MAX ) return 0;
+
+    top = (char *) malloc(headerbytes);
+    if( !top ) return 0;
+    n = snprintf(header,sizeof(header),"%ld %ld\n",(long) width,(long) height);
+    memcpy(top,"P4\n#",4);
+    memset(top+4,' ',headerbytes-4);
+    top[headerbytes-n-1] = '\n';
+    memcpy(top+headerbytes-n,header,n);
+
+    fd = open(path,O_RDWR | O_CREAT,0666);
+    if( fd < 0 ) {
+        free(top);
+        return 0;
+    }
+    if( fstat(fd,&st) != 0 ) {
+        free(top);
+        close(fd);
+        return 0;
+    }
+    same = 0;
+    if( st.st_size != 0 ) {
+        // Only our own canvas of the same size, anything else is kept
+        char *old = (char *) malloc(headerbytes);
+
+        same = (size_t) st.st_size == headerbytes+rasterbytes && old &&
+               pread(fd,old,headerbytes,0) == (ssize_t) headerbytes &&
+               memcmp(old,top,headerbytes) == 0;
+        free(old);
+        if( !same ) {
+            free(top);
+            close(fd);
+            return 0;
+        }
+    }
+    if( !same && (pwrite(fd,top,headerbytes,0) != (ssize_t) headerbytes ||
+                  ftruncate(fd,(off_t) (headerbytes+rasterbytes)) != 0) ) {
+        free(top);
+        close(fd);
+        return 0;
+    }
+    free(top);
+
+    // Private pages (and the slack after the raster), the file over them
+    map = mmap(0,mapsize,PROT_READ | PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS,-1,0);
+    if( map == MAP_FAILED ) {
+        close(fd);
+        return 0;
+    }
+    if( mmap((char *) map+headerbytes,rasterbytes,PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_FIXED,fd,(off_t) headerbytes) == MAP_FAILED ) {
+        munmap(map,mapsize);
+        close(fd);
+        return 0;
+    }
+    close(fd);
+
+    screen = (ScreenType *) ((char *) map+headerbytes-offsetof(ScreenType,data));
+    screen->fmt = PBM;
+    screen->w = width;
+    screen->h = height;
+    screen->wbytes = widthbytes;
+    screen->bpp = 0;
+    screen->ops = ScreenFormatOps(PBM);
+    screen->writes = 0;
+    screen->dirty = 0;
+    screen->map = map;
+    screen->mapsize = mapsize;
+    screen->tiles = 0;
+    memset(screen->ink,0xFF,sizeof(screen->ink));
+
+    ScreenKernelsInit();
+    ScreenAdviseRows(screen,0,height-1,SCREEN_ADVISE_RANDOM);
+
+    return screen;
 }
 
 
-/*
- * @brief Plot point
+/**
+ * @brief   Write the changed pages of a mapped screen to its file and wait
  *
- * @note  it will be used as a callback
+ * @note    Not needed to keep the drawing (the system writes the pages
+ *          anyway, also after ScreenDestroy), only to have it on disk now
+ *
+ * @return  0 on error. Allocated screens do nothing and return 1
  */
-void ScreenDrawVertLine(ScreenType *screen, INT x, INT y1, INT y2) {
-INT wid;
-unsigned char *line;
-int col,bit;
+int ScreenSync(ScreenType *screen) {
+
+    if( !screen || !screen->map ) return 1;
+    return msync(screen->data,(size_t) screen->h*screen->wbytes,MS_SYNC) == 0;
+}
+
+
+/**
+ * @brief   Tell the system how rows y1 to y2 of a mapped screen will be used
+ *
+ * @note    RANDOM stops the read ahead (lines), SEQUENTIAL reads ahead and
+ *          drops the pages behind (fills, writers), WILLNEED reads the rows
+ *          now and DONTNEED drops them from memory (they are kept in the
+ *          file). Allocated screens ignore it
+ */
+void ScreenAdviseRows(ScreenType *screen, INT y1, INT y2, ScreenAdviceType advice) {
+static const int advices[] = { MADV_RANDOM, MADV_SEQUENTIAL, MADV_WILLNEED, MADV_DONTNEED };
+size_t page,start,end;
+
+    if( !screen || !screen->map ) return;
+    if( y1 < 0 ) y1 = 0;
+    if( y2 >= screen->h ) y2 = screen->h-1;
+    if( y1 > y2 ) return;
+
+    // Whole pages covering the rows (the raster starts on a page)
+    page  = (size_t) sysconf(_SC_PAGESIZE);
+    start = (size_t) y1*screen->wbytes/page*page;
+    end   = (size_t) (y2+1)*screen->wbytes;
+    madvise(screen->data+start,end-start,advices[advice]);
+}
+
+
+/**
+ * @brief   Create a PBM Screen (1 bit per pixel)
+ */
+ScreenType *ScreenCreate(int width, int height) {
+
+    return ScreenCreateFormat(width,height,PBM);
+}
+
+
+/**
+ * @brief   Set the value used to draw
+ *
+ * @note    Components are 0..255. PGM screens use the luma of the color.
+ *          PBM screens always set the bit and ignore it
+ */
+void ScreenSetColor(ScreenType *screen, INT r, INT g, INT b, INT a) {
 
     if( !screen ) return;
-    if( x < 0 ) return;
-    if( x >= screen->w ) return;
-    if( y1 < 0 ) return;
-    if( y1 >= screen->h ) return;
-    if( y2 < 0 ) return;
-    if( y2 >= screen->h ) return;
+    if( screen->fmt == PGM ) {
+        screen->ink[0] = (unsigned char) ((77*r+150*g+29*b)>>8);
+    } else {
+        screen->ink[0] = (unsigned char) r;
+        screen->ink[1] = (unsigned char) g;
+        screen->ink[2] = (unsigned char) b;
+        screen->ink[3] = (unsigned char) a;
+    }
+}
 
-//    wid = (screen->w+7)/8;
-    wid = screen->wbytes;
+/**
+ * @brief  ScreenDestroy
+ *
+ * @note   Long description of function
+ *
+ * @param  Description of parameter
+ *
+ * @return Description of return parameters
+ */
 
-    col = x/8;
-    bit = x&7;
-    for(int y=y1;y<y2;y++) {
-        line = &(screen->data[y*wid]);
-        line[col] |= mask[bit];
+void ScreenDestroy(ScreenType *screen) {
+
+    ScreenTrackDirty(screen,0);
+    if( screen->tiles ) ScreenTilesFree(screen->tiles);
+
+    // The struct is in the mapping
+    if( screen->map ) {
+        munmap(screen->map,screen->mapsize);
+        return;
     }
+
+    // Just in case
+    screen->fmt = 0;
+    screen->w   = 0;
+    screen->h   = 0;
+    screen->wbytes = 0;
+
+    free(screen);
+
+}
+/**
+ * @brief   Screen dimensions in pixels
+ */
+///@{
+INT ScreenWidth(ScreenType *screen) {
+
+    return screen?screen->w:0;
 }
 
+INT ScreenHeight(ScreenType *screen) {
 
-/*
- * @brief Draw a horizontal line between points
+    return screen?screen->h:0;
+}
+
+ImageFormatType ScreenFormat(ScreenType *screen) {
+
+    return screen?screen->fmt:PBM;
+}
+///@}
+
+
+/**
+ * @brief   Number of pixels written since creation or last reset
  *
- * @note  it will be used as a callback
+ * @note    Always zero if compiled without SCREENSTATS
  */
+///@{
+unsigned long ScreenPixelWrites(ScreenType *screen) {
 
-void ScreenDrawHorizLine(ScreenType *screen, INT x1, INT x2, INT y) {
-INT wid;
-unsigned char *line;
-int p;
-int bm1,bm2;
-int p1,p2;
+    return screen?screen->writes:0;
+}
 
-    if( !screen ) return;
-    if( x1 < 0 ) return;
-    if( x1 >= screen->w ) return;
-    if( x2 < 0 ) return;
-    if( x2 >= screen->w ) return;
-    if( y < 0 ) return;
-    if( y >= screen->h ) return;
+void ScreenResetPixelWrites(ScreenType *screen) {
 
-//    wid = (screen->w+7)/8;
-    wid = screen->wbytes;
-    line = &(screen->data[y*wid]);
+    if( screen ) screen->writes = 0;
+}
+///@}
 
-    p1 = x1/8;
-    p2 = x2/8;
 
-    bm1 = ((mask[x1&7]-1)<<1)|1;
-    line[p1] |= bm1;
-    bm2 = 0xFF<<(7-x2&7);
-    line[p2] |= bm2;
-    if( (p2-p1) > 1 ) {
-        for(int p=p1+1;p<p2;p++) {
-            line[p] = 0xFF;
-        }
+/**
+ * @brief   ScreenFill
+ *
+ * @note    Fill a screen with value
+ *
+ * @note    Rows are contiguous, so the fill kernel is called once
+ *
+ * @note    Every byte is set to value (in all formats)
+ *
+ * @note    Sparse screens only set the directory of tiles (no tile is
+ *          written for 0 and 0xFF)
+ */
+void ScreenFill(ScreenType *screen, int value) {
+
+    if( screen->tiles ) {
+        ScreenTilesFill(screen->tiles,value);
+        ScreenMarkDirty(screen,0,0,screen->w-1,screen->h-1);
+        return;
+    }
+    ScreenAdviseRows(screen,0,screen->h-1,SCREEN_ADVISE_SEQUENTIAL);
+    screenkernels->fill(screen->data,value,(long) screen->wbytes*screen->h);
+    ScreenAdviseRows(screen,0,screen->h-1,SCREEN_ADVISE_RANDOM);
+    ScreenMarkDirty(screen,0,0,screen->w-1,screen->h-1);
+}
+
+
+/**
+ * @brief   Track the changed rows of a screen (on is not zero) or stop
+ *
+ * @note    The draw routines of the screen record the span of each row they
+ *          write (one test for each write when not tracked). Routines
+ *          writing data[] directly must call ScreenMarkDirty.
+ *
+ * @note    When tracking starts, the screen is clean
+ *
+ * @return  0 if there is no memory
+ */
+int ScreenTrackDirty(ScreenType *screen, int on) {
+ScreenDirtyType *d;
+
+    if( !screen ) return 0;
+    if( !on ) {
+        free(screen->dirty);
+        screen->dirty = 0;
+        return 1;
+    }
+    if( screen->dirty ) return 1;
+
+    // Rows and spans in a single block
+    d = (ScreenDirtyType *) malloc(sizeof(ScreenDirtyType)+2*(size_t) screen->h*sizeof(INT));
+    if( !d ) return 0;
+    d->x1 = (INT *) (d+1);
+    d->x2 = d->x1+screen->h;
+    screen->dirty = d;
+    ScreenClearDirty(screen);
+    return 1;
+}
+
+
+/**
+ * @brief   Record a changed rectangle (clipped to the screen)
+ */
+void ScreenMarkDirty(ScreenType *screen, INT x1, INT y1, INT x2, INT y2) {
+
+    if( !screen || !screen->dirty ) return;
+    if( x1 < 0 ) x1 = 0;
+    if( y1 < 0 ) y1 = 0;
+    if( x2 >= screen->w ) x2 = screen->w-1;
+    if( y2 >= screen->h ) y2 = screen->h-1;
+    for(INT y=y1;y<=y2 && x1<=x2;y++)
+        ScreenDirtySpan(screen->dirty,x1,x2,y);
+}
+
+
+/**
+ * @brief   Forget the changes (after the screen has been sent)
+ */
+void ScreenClearDirty(ScreenType *screen) {
+ScreenDirtyType *d;
+
+    if( !screen || !screen->dirty ) return;
+    d = screen->dirty;
+    for(INT y=0;y<screen->h;y++) {
+        d->x1[y] = screen->w;
+        d->x2[y] = -1;
+    }
+}
+
+
+/**
+ * @brief   Band of the changed rows, from the first one to the last one
+ *
+ * @return  0 if nothing changed
+ */
+static int ScreenDirtyBand(ScreenType *screen, INT *y1, INT *y2) {
+ScreenDirtyType *d = screen->dirty;
+
+    for(*y1=0;*y1<screen->h && d->x1[*y1] > d->x2[*y1];(*y1)++);
+    if( *y1 == screen->h ) return 0;
+    for(*y2=screen->h-1;d->x1[*y2] > d->x2[*y2];(*y2)--);
+    return 1;
+}
+
+
+/**
+ * @brief   Changed rectangles
+ *
+ * @note    Consecutive changed rows are merged in a rectangle, with the
+ *          smallest span covering theirs. If there are more than max
+ *          rectangles, the last one covers the rest, so the rectangles always
+ *          cover all the changes.
+ *
+ * @return  Number of rectangles (0 if nothing changed or not tracked)
+ */
+int ScreenDirtyRects(ScreenType *screen, ScreenRectType *rects, int max) {
+ScreenDirtyType *d;
+ScreenRectType *r = 0;
+INT y1,y2;
+int n = 0;
+
+    if( !screen || !screen->dirty || max <= 0 ) return 0;
+    if( !ScreenDirtyBand(screen,&y1,&y2) ) return 0;
+    d = screen->dirty;
+    for(INT y=y1;y<=y2;y++) {
+        if( d->x1[y] > d->x2[y] ) {
+            if( n < max ) r = 0;
+            continue;
+        }
+        if( !r ) {
+            r = &rects[n++];
+            r->x1 = d->x1[y];
+            r->x2 = d->x2[y];
+            r->y1 = y;
+        }
+        if( d->x1[y] < r->x1 ) r->x1 = d->x1[y];
+        if( d->x2[y] > r->x2 ) r->x2 = d->x2[y];
+        r->y2 = y;
+    }
+    return n;
+}
+
+
+/**
+ * @brief   Characters for each bit of a byte (MSB first)
+ *
+ * @note    Filled at the first call of ScreenWritePBM
+ */
+static char asciibits[256][8];
+static int  asciibitsready = 0;
+
+static void BuildAsciiBits(void) {
+
+    for(int b=0;b<256;b++) {
+        for(int i=0;i<8;i++) {
+            asciibits[b][i] = (b&(0x80>>i)) ? '1' : '0';
+        }
+    }
+    asciibitsready = 1;
+}
+
+
+/**
+ * @brief   Write a binary image into a file
+ *
+ * @note    It uses the uncompressed (ASCII, P1) format
+ *
+ * @note    Each byte is expanded using a lookup table into a row buffer,
+ *          which is written with a single fwrite. Rows of sparse screens are
+ *          gathered from the tiles first
+ */
+void ScreenWritePBM(ScreenType *screen, FILE *fout) {
+INT wid;
+unsigned char *p,*bytes;
+char *row;
+INT full,rest;
+
+    if( screen->fmt != PBM ) return;
+    if( !asciibitsready ) BuildAsciiBits();
+
+    wid = screen->wbytes;
+    full = screen->w/8;
+    rest = screen->w&7;
+
+    row = (char *) malloc(wid*8+1);
+    bytes = screen->tiles ? (unsigned char *) malloc(wid) : 0;
+    if( !row || (screen->tiles && !bytes) ) {
+        free(row);
+        free(bytes);
+        return;
+    }
+
+    fprintf(fout,"P1\n%ld\n%ld\n",(long) screen->w,(long) screen->h);
+    for(int j=0;j<screen->h;j++) {
+        p = screen->tiles ? ScreenTilesRow(screen,j,bytes) : &(screen->data[j*wid]);
+        char *q = row;
+        for(int i=0;i<full;i++) {
+            memcpy(q,asciibits[p[i]],8);
+            q += 8;
+        }
+        if( rest ) {
+            memcpy(q,asciibits[p[full]],rest);
+            q += rest;
+        }
+        *q++ = '\n';
+        fwrite(row,1,q-row,fout);
+    }
+    free(row);
+    free(bytes);
+}
+
+
+/**
+ * @brief   Write n rows from row y in the raw format of the screen
+ *
+ * @note    P4 for PBM, P5 for PGM and P6 for PPM and PAM (the alpha channel
+ *          is dropped). Rows are stored as in the file, except for PAM, so
+ *          they are written with a single fwrite. Sparse screens are written
+ *          row by row, tiles never written as runs of zeros
+ */
+static void ScreenWriteRaw(ScreenType *screen, FILE *fout, INT y, INT n) {
+unsigned char *row;
+
+    switch(screen->fmt) {
+    case PBM: fprintf(fout,"P4\n%ld %ld\n",(long) screen->w,(long) n);      break;
+    case PGM: fprintf(fout,"P5\n%ld %ld\n255\n",(long) screen->w,(long) n); break;
+    default:  fprintf(fout,"P6\n%ld %ld\n255\n",(long) screen->w,(long) n); break;
+    }
+    if( screen->tiles ) {
+        row = (unsigned char *) malloc(screen->wbytes);
+        if( !row ) return;
+        for(INT j=y;j<y+n;j++)
+            fwrite(ScreenTilesRow(screen,j,row),1,screen->wbytes,fout);
+        free(row);
+        return;
+    }
+    if( screen->fmt != PAM ) {
+        ScreenAdviseRows(screen,y,y+n-1,SCREEN_ADVISE_SEQUENTIAL);
+        fwrite(&(screen->data[(size_t) y*screen->wbytes]),screen->wbytes,n,fout);
+        ScreenAdviseRows(screen,y,y+n-1,SCREEN_ADVISE_RANDOM);
+        return;
+    }
+
+    row = (unsigned char *) malloc(3*screen->w+1);
+    if( !row ) return;
+    for(int j=y;j<y+n;j++) {
+        unsigned char *p = &(screen->data[j*screen->wbytes]);
+        for(int i=0;i<screen->w;i++) {
+            row[3*i]   = p[4*i];
+            row[3*i+1] = p[4*i+1];
+            row[3*i+2] = p[4*i+2];
+        }
+        fwrite(row,3,screen->w,fout);
+    }
+    free(row);
+}
+
+
+/**
+ * @brief   Write a binary image into a file
+ *
+ * @note    It uses the raw (binary, P4) format. Rows are packed MSB first as
+ *          in data[], so the raster is written with a single fwrite
+ */
+void ScreenWritePBMBinary(ScreenType *screen, FILE *fout) {
+
+    if( screen->fmt != PBM ) return;
+    ScreenWriteRaw(screen,fout,0,screen->h);
+}
+
+
+/**
+ * @brief   Write a gray level image into a file
+ *
+ * @note    It uses the raw (binary, P5) format. Only for PGM screens
+ */
+void ScreenWritePGM(ScreenType *screen, FILE *fout) {
+
+    if( screen->fmt != PGM ) return;
+    ScreenWriteRaw(screen,fout,0,screen->h);
+}
+
+
+/**
+ * @brief   Write a color image into a file
+ *
+ * @note    It uses the raw (binary, P6) format. Only for PPM and PAM screens.
+ *          For PAM screens, the alpha channel is dropped
+ */
+void ScreenWritePPM(ScreenType *screen, FILE *fout) {
+
+    if( screen->fmt != PPM && screen->fmt != PAM ) return;
+    ScreenWriteRaw(screen,fout,0,screen->h);
+}
+
+
+/**
+ * @brief   Write the band of changed rows into a file
+ *
+ * @note    It is a whole image (raw format of the screen, as above) with the
+ *          width of the screen and the height of the band. The first row of
+ *          the band is returned in y. The changes are not cleared
+ *
+ * @return  Number of rows written (0 if nothing changed or not tracked)
+ */
+INT ScreenWriteDirty(ScreenType *screen, FILE *fout, INT *y) {
+INT y1,y2;
+
+    if( !screen || !screen->dirty ) return 0;
+    if( !ScreenDirtyBand(screen,&y1,&y2) ) return 0;
+    *y = y1;
+    ScreenWriteRaw(screen,fout,y1,y2-y1+1);
+    return y2-y1+1;
+}
+
+
+/**
+ * @brief Bit mask for each bit
+ *
+ * @note  I hope it is faster than  (1<<(7-x))
+ */
+static const unsigned char mask[] = { '\x80','\x40','\x20','\x10','\x08','\x04','\x02','\x01' };
+
+
+/**
+ * @brief Drawing routines for PBM screens (1 bit per pixel)
+ */
+///@{
+static void PointPBM(ScreenType *screen, INT x, INT y) {
+INT wid;
+unsigned char *line;
+int col,bit;
+
+//    wid = (screen->w+7)/8;
+    wid = screen->wbytes;
+    line = &(screen->data[y*wid]);
+    col = x/8;
+    bit = x&7;
+    line[col] |= mask[bit];
+    SCREENCOUNT(screen,1);
+    SCREENDIRTY(screen,x,x,y);
+}
+
+static void VLinePBM(ScreenType *screen, INT x, INT y1, INT y2) {
+INT wid;
+unsigned char *line;
+int col,bit;
+
+//    wid = (screen->w+7)/8;
+    wid = screen->wbytes;
+
+    col = x/8;
+    bit = x&7;
+    line = &(screen->data[y1*wid+col]);
+    for(int y=y1;y<=y2;y++) {
+        *line |= mask[bit];
+        line += wid;
+    }
+    SCREENCOUNT(screen,y2-y1+1);
+    ScreenMarkDirty(screen,x,y1,x,y2);
+}
+
+/**
+ * @brief Set the bits x1 to x2 of a row of bytes
+ */
+static void ScreenSetBits(unsigned char *line, INT x1, INT x2) {
+int bm1,bm2;
+int p1,p2;
+
+    p1 = x1/8;
+    p2 = x2/8;
+
+    bm1 = ((mask[x1&7]-1)<<1)|1;
+    bm2 = (0xFF<<(7-(x2&7)))&0xFF;
+    if( p1 == p2 ) {
+        // Both ends in the same byte
+        line[p1] |= bm1&bm2;
+        return;
+    }
+    line[p1] |= bm1;
+    line[p2] |= bm2;
+    if( p2-p1 > 1 )
+        screenkernels->fill(&line[p1+1],0xFF,p2-p1-1);
+}
+
+static void HLinePBM(ScreenType *screen, INT x1, INT x2, INT y) {
+INT wid;
+unsigned char *line;
+
+//    wid = (screen->w+7)/8;
+    wid = screen->wbytes;
+    line = &(screen->data[y*wid]);
+
+    SCREENCOUNT(screen,x2-x1+1);
+    SCREENDIRTY(screen,x1,x2,y);
+    ScreenSetBits(line,x1,x2);
+}
+
+static void BlendPBM(ScreenType *screen, INT x, INT y, INT alpha) {
+
+    // No gray levels. Set the pixel if it is covered at least by half
+    if( alpha >= 128 ) PointPBM(screen,x,y);
+}
+///@}
+
+
+/**
+ * @brief Drawing routines for sparse PBM screens
+ *
+ * @note  Bits set in the all one tile are already set, so it is not copied
+ */
+///@{
+static void PointTiles(ScreenType *screen, INT x, INT y) {
+ScreenTilesType *t = screen->tiles;
+unsigned char *tile;
+INT tx = x/SCREEN_TILESIZE, ty = y/SCREEN_TILESIZE;
+
+    SCREENCOUNT(screen,1);
+    SCREENDIRTY(screen,x,x,y);
+    tile = ScreenTileWritable(t,tx,ty);
+    if( !tile || tile == onetile ) return;
+    x %= SCREEN_TILESIZE;
+    tile[(y%SCREEN_TILESIZE)*SCREEN_TILEBYTES+x/8] |= mask[x&7];
+}
+
+static void VLineTiles(ScreenType *screen, INT x, INT y1, INT y2) {
+ScreenTilesType *t = screen->tiles;
+unsigned char *tile,*p;
+INT tx = x/SCREEN_TILESIZE;
+INT a,b;
+unsigned char m = mask[x&7];
+
+    SCREENCOUNT(screen,y2-y1+1);
+    ScreenMarkDirty(screen,x,y1,x,y2);
+    for(INT ty=y1/SCREEN_TILESIZE;ty<=y2/SCREEN_TILESIZE;ty++) {
+        tile = ScreenTileWritable(t,tx,ty);
+        if( !tile ) return;
+        if( tile == onetile ) continue;
+        a = ty*SCREEN_TILESIZE;
+        b = a+SCREEN_TILESIZE-1;
+        if( a < y1 ) a = y1;
+        if( b > y2 ) b = y2;
+        p = tile+(a%SCREEN_TILESIZE)*SCREEN_TILEBYTES+(x%SCREEN_TILESIZE)/8;
+        for(INT y=a;y<=b;y++) {
+            *p |= m;
+            p += SCREEN_TILEBYTES;
+        }
+    }
+}
+
+static void HLineTiles(ScreenType *screen, INT x1, INT x2, INT y) {
+ScreenTilesType *t = screen->tiles;
+unsigned char *tile;
+INT ty = y/SCREEN_TILESIZE;
+INT off = (y%SCREEN_TILESIZE)*SCREEN_TILEBYTES;
+INT a,b;
+
+    SCREENCOUNT(screen,x2-x1+1);
+    SCREENDIRTY(screen,x1,x2,y);
+    for(INT tx=x1/SCREEN_TILESIZE;tx<=x2/SCREEN_TILESIZE;tx++) {
+        tile = ScreenTileWritable(t,tx,ty);
+        if( !tile ) return;
+        if( tile == onetile ) continue;
+        a = tx*SCREEN_TILESIZE;
+        b = a+SCREEN_TILESIZE-1;
+        if( a < x1 ) a = x1;
+        if( b > x2 ) b = x2;
+        ScreenSetBits(tile+off,a%SCREEN_TILESIZE,b%SCREEN_TILESIZE);
+    }
+}
+
+static void BlendTiles(ScreenType *screen, INT x, INT y, INT alpha) {
+
+    if( alpha >= 128 ) PointTiles(screen,x,y);
+}
+///@}
+
+
+/**
+ * @brief Drawing routines for PGM screens (gray level in a byte)
+ */
+///@{
+static void PointPGM(ScreenType *screen, INT x, INT y) {
+
+    screen->data[y*screen->wbytes+x] = screen->ink[0];
+    SCREENCOUNT(screen,1);
+    SCREENDIRTY(screen,x,x,y);
+}
+
+static void VLinePGM(ScreenType *screen, INT x, INT y1, INT y2) {
+unsigned char *p = &(screen->data[y1*screen->wbytes+x]);
+
+    for(int y=y1;y<=y2;y++) {
+        *p = screen->ink[0];
+        p += screen->wbytes;
+    }
+    SCREENCOUNT(screen,y2-y1+1);
+    ScreenMarkDirty(screen,x,y1,x,y2);
+}
+
+static void HLinePGM(ScreenType *screen, INT x1, INT x2, INT y) {
+
+    screenkernels->fill(&(screen->data[y*screen->wbytes+x1]),screen->ink[0],x2-x1+1);
+    SCREENCOUNT(screen,x2-x1+1);
+    SCREENDIRTY(screen,x1,x2,y);
+}
+
+static void BlendPGM(ScreenType *screen, INT x, INT y, INT alpha) {
+unsigned char *p = &(screen->data[y*screen->wbytes+x]);
+
+    *p = (unsigned char) (*p+((screen->ink[0]-*p)*alpha)/255);
+    SCREENCOUNT(screen,1);
+    SCREENDIRTY(screen,x,x,y);
+}
+///@}
+
+
+/**
+ * @brief Drawing routines for PPM (RGB) and PAM (RGBA) screens
+ *
+ * @note  The number of bytes copied from ink is bpp
+ */
+///@{
+static void PointRGB(ScreenType *screen, INT x, INT y) {
+
+    memcpy(&(screen->data[y*screen->wbytes+x*screen->bpp]),screen->ink,screen->bpp);
+    SCREENCOUNT(screen,1);
+    SCREENDIRTY(screen,x,x,y);
+}
+
+static void VLineRGB(ScreenType *screen, INT x, INT y1, INT y2) {
+unsigned char *p = &(screen->data[y1*screen->wbytes+x*screen->bpp]);
+
+    for(int y=y1;y<=y2;y++) {
+        memcpy(p,screen->ink,screen->bpp);
+        p += screen->wbytes;
+    }
+    SCREENCOUNT(screen,y2-y1+1);
+    ScreenMarkDirty(screen,x,y1,x,y2);
+}
+
+static void HLineRGB(ScreenType *screen, INT x1, INT x2, INT y) {
+unsigned char *p = &(screen->data[y*screen->wbytes+x1*screen->bpp]);
+
+    for(int x=x1;x<=x2;x++) {
+        memcpy(p,screen->ink,screen->bpp);
+        p += screen->bpp;
+    }
+    SCREENCOUNT(screen,x2-x1+1);
+    SCREENDIRTY(screen,x1,x2,y);
+}
+
+static void BlendRGB(ScreenType *screen, INT x, INT y, INT alpha) {
+unsigned char *p = &(screen->data[y*screen->wbytes+x*screen->bpp]);
+
+    for(int i=0;i<screen->bpp;i++)
+        p[i] = (unsigned char) (p[i]+((screen->ink[i]-p[i])*alpha)/255);
+    SCREENCOUNT(screen,1);
+    SCREENDIRTY(screen,x,x,y);
+}
+///@}
+
+
+static const ScreenOpsType opspbm = { PointPBM, HLinePBM, VLinePBM, BlendPBM };
+static const ScreenOpsType opspgm = { PointPGM, HLinePGM, VLinePGM, BlendPGM };
+static const ScreenOpsType opsrgb = { PointRGB, HLineRGB, VLineRGB, BlendRGB };
+static const ScreenOpsType opstiles = { PointTiles, HLineTiles, VLineTiles, BlendTiles };
+
+
+/**
+ * @brief Plot point
+ *
+ * @note  it will be used as a callback
+ */
+void ScreenDrawPoint(ScreenType *screen, INT x, INT y) {
+
+    if( !screen ) return;
+    if( x < 0 ) return;
+    if( x >= screen->w ) return;
+    if( y < 0 ) return;
+    if( y >= screen->h ) return;
+
+    screen->ops->point(screen,x,y);
+}
+
+
+/**
+ * @brief Blend the ink into a point
+ *
+ * @note  alpha is the coverage of the pixel (0 to 255). The new value is
+ *        value+(ink-value)*alpha/255, for each component. PBM screens set the
+ *        pixel when alpha >= 128
+ */
+void ScreenBlendPoint(ScreenType *screen, INT x, INT y, INT alpha) {
+
+    if( !screen ) return;
+    if( x < 0 ) return;
+    if( x >= screen->w ) return;
+    if( y < 0 ) return;
+    if( y >= screen->h ) return;
+
+    screen->ops->blend(screen,x,y,alpha);
+}
+
+
+/*
+ * @brief Draw a vertical line between points (both included)
+ *
+ * @note  it will be used as a callback
+ *
+ * @note  The line is clipped to the screen
+ */
+void ScreenDrawVertLine(ScreenType *screen, INT x, INT y1, INT y2) {
+INT t;
+
+    if( !screen ) return;
+    if( y1 > y2 ) {
+        t = y1;
+        y1 = y2;
+        y2 = t;
+    }
+    if( x < 0 ) return;
+    if( x >= screen->w ) return;
+    if( y2 < 0 ) return;
+    if( y1 >= screen->h ) return;
+    if( y1 < 0 ) y1 = 0;
+    if( y2 >= screen->h ) y2 = screen->h-1;
+
+    screen->ops->vline(screen,x,y1,y2);
+}
+
+
+/*
+ * @brief Draw a horizontal line between points (both included)
+ *
+ * @note  it will be used as a callback
+ *
+ * @note  The line is clipped to the screen
+ */
+
+void ScreenDrawHorizLine(ScreenType *screen, INT x1, INT x2, INT y) {
+INT t;
+
+    if( !screen ) return;
+    if( x1 > x2 ) {
+        t = x1;
+        x1 = x2;
+        x2 = t;
+    }
+    if( x2 < 0 ) return;
+    if( x1 >= screen->w ) return;
+    if( y < 0 ) return;
+    if( y >= screen->h ) return;
+    if( x1 < 0 ) x1 = 0;
+    if( x2 >= screen->w ) x2 = screen->w-1;
+
+    screen->ops->hline(screen,x1,x2,y);
+}
+
+
+/*
+ * @brief Draw the points of a horizontal line that are on in a pattern
+ *
+ * @note  Point x1 has the given phase and the phase changes by step (+1 or
+ *        -1) from one point to the next. mask[p] has the bits of the 8
+ *        points from phase p (MSB first). There are len phases.
+ *
+ * @note  On PBM screens (not sparse), each byte of the line is masked at
+ *        once. Other screens get the parts on as lines
+ *
+ * @note  The line is clipped to the screen
+ */
+void ScreenDrawHorizPattern(ScreenType *screen, INT x1, INT x2, INT y,
+                            const unsigned char *mask, int len, int phase, int step) {
+unsigned char *line,m;
+INT s = 0,p1,p2;
+int d,on = 0;
+
+    if( !screen || len <= 0 || x1 > x2 ) return;
+    if( x2 < 0 || x1 >= screen->w || y < 0 || y >= screen->h ) return;
+    if( x1 < 0 ) {
+        phase = (int) ((phase+(LONG64) step*-x1%len+len)%len);
+        x1 = 0;
+    }
+    if( x2 >= screen->w ) x2 = screen->w-1;
+
+    if( screen->fmt != PBM || screen->tiles ) {
+        for(INT x=x1;x<=x2;x++) {
+            if( mask[phase] & 0x80 ) {
+                if( !on ) s = x;
+                on = 1;
+            } else if( on ) {
+                screen->ops->hline(screen,s,x-1,y);
+                on = 0;
+            }
+            phase = (phase+step+len)%len;
+        }
+        if( on ) screen->ops->hline(screen,s,x2,y);
+        return;
+    }
+
+    // Phase of the first point of the byte of x1, and step of a byte
+    phase = (int) ((phase-(LONG64) step*(x1&7)%len+len)%len);
+    d = (int) (((LONG64) step*8%len+len)%len);
+    line = &(screen->data[y*screen->wbytes]);
+    p1 = x1>>3;
+    p2 = x2>>3;
+    SCREENDIRTY(screen,x1,x2,y);
+    for(INT k=p1;k<=p2;k++) {
+        m = mask[phase];
+        if( k == p1 ) m &= (unsigned char) (0xFF>>(x1&7));
+        if( k == p2 ) m &= (unsigned char) (0xFF<<(7-(x2&7)));
+        line[k] |= m;
+#if SCREENSTATS
+        for(int b=0;b<8;b++) SCREENCOUNT(screen,(m>>b)&1);
+#endif
+        phase += d;
+        if( phase >= len ) phase -= len;
+    }
+}
+
+
+/**
+ * @brief   Apply an operation to n bytes
+ */
+static void ScreenOpBytes(ScreenOpType op, unsigned char *dst, const unsigned char *src, long n) {
+
+    switch(op) {
+    case SCREEN_COPY: screenkernels->copy(dst,src,n);    break;
+    case SCREEN_OR:   screenkernels->orbits(dst,src,n);  break;
+    case SCREEN_AND:  screenkernels->andbits(dst,src,n); break;
+    case SCREEN_XOR:  screenkernels->xorbits(dst,src,n); break;
+    }
+}
+
+
+/**
+ * @brief   Apply an operation to the bits of a byte selected by m
+ */
+static unsigned char ScreenOpMasked(ScreenOpType op, unsigned char d, unsigned char s, unsigned char m) {
+unsigned char r = d;
+
+    switch(op) {
+    case SCREEN_COPY: r = s;     break;
+    case SCREEN_OR:   r = d | s; break;
+    case SCREEN_AND:  r = d & s; break;
+    case SCREEN_XOR:  r = d ^ s; break;
+    }
+    return (unsigned char) ((d&~m)|(r&m));
+}
+
+
+/**
+ * @brief   Combine two screens with the same dimensions
+ *
+ * @note    dst = dst op src. If the dimensions are not the same, the common
+ *          rectangle at the top left corner is used. Sparse screens are
+ *          combined row by row (see ScreenBlit)
+ *
+ * @note    Both screens must have the same format
+ */
+void ScreenCombine(ScreenType *dst, ScreenType *src, ScreenOpType op) {
+
+    if( !dst || !src || dst->fmt != src->fmt ) return;
+    if( dst == src || dst->w != src->w || dst->h != src->h || dst->tiles || src->tiles ) {
+        ScreenBlit(dst,0,0,src,0,0,src->w,src->h,op);
+        return;
+    }
+    ScreenOpBytes(op,dst->data,src->data,(long) dst->wbytes*dst->h);
+    ScreenMarkDirty(dst,0,0,dst->w-1,dst->h-1);
+}
+
+
+/**
+ * @brief   Source byte whose first bit is bit s of the row (bits outside the
+ *          row are zero)
+ */
+static unsigned char ScreenRowByte(const unsigned char *row, INT wbytes, INT s) {
+INT k = s>>3;
+int r = s&7;
+unsigned int v;
+
+    v  = (k >= 0 && k < wbytes) ? row[k]<<8 : 0;
+    v |= (k+1 >= 0 && k+1 < wbytes) ? row[k+1] : 0;
+    return (unsigned char) ((v<<r)>>8);
+}
+
+
+/**
+ * @brief   Combine a rectangle of src with the same size rectangle of dst
+ *
+ * @note    The w x h rectangle at (sx,sy) of src is combined with the one at
+ *          (dx,dy) of dst. The rectangles are clipped to both screens.
+ *
+ * @note    For PBM screens, when the bit offsets of both rectangles are the
+ *          same, the source row is used as is. If not, it is shifted into a
+ *          row buffer aligned to the destination. The buffer is always used
+ *          when the screens are the same, so overlapping rectangles work.
+ *          The inner bytes of the row are processed by the kernels, the
+ *          bytes at both ends are masked. In the other formats, pixels are
+ *          whole bytes and there is no masking.
+ *
+ * @note    Rows of sparse screens are gathered from the tiles into a row
+ *          buffer, and the destination row is written back (only the tiles
+ *          that change)
+ *
+ * @note    Both screens must have the same format
+ */
+void ScreenBlit(ScreenType *dst, INT dx, INT dy, ScreenType *src, INT sx, INT sy, INT w, INT h, ScreenOpType op) {
+INT p1,p2,n;
+unsigned char m1,m2;
+unsigned char *buffer = 0,*srcrow = 0,*dstrow = 0;
+int shift,direct;
+
+    if( !dst || !src || dst->fmt != src->fmt ) return;
+
+    // Clip against the source and the destination
+    if( sx < 0 ) { w += sx; dx -= sx; sx = 0; }
+    if( sy < 0 ) { h += sy; dy -= sy; sy = 0; }
+    if( dx < 0 ) { w += dx; sx -= dx; dx = 0; }
+    if( dy < 0 ) { h += dy; sy -= dy; dy = 0; }
+    if( sx+w > src->w ) w = src->w-sx;
+    if( sy+h > src->h ) h = src->h-sy;
+    if( dx+w > dst->w ) w = dst->w-dx;
+    if( dy+h > dst->h ) h = dst->h-dy;
+    if( w <= 0 || h <= 0 ) return;
+    ScreenMarkDirty(dst,dx,dy,dx+w-1,dy+h-1);
+
+    if( dst->fmt == PBM ) {
+        p1 = dx>>3;
+        p2 = (dx+w-1)>>3;
+        n  = p2-p1+1;
+        m1 = (unsigned char) (0xFF>>(dx&7));
+        m2 = (unsigned char) (0xFF<<(7-((dx+w-1)&7)));
+        if( n == 1 ) m1 = m2 = m1&m2;
+        shift = (sx&7) != (dx&7);
+    } else {
+        p1 = dx*dst->bpp;
+        n  = w*dst->bpp;
+        m1 = m2 = 0xFF;
+        shift = 0;
+    }
+
+    direct = !shift && src != dst;
+    if( !direct ) {
+        buffer = (unsigned char *) malloc(n);
+        if( !buffer ) return;
+    }
+    if( src->tiles ) srcrow = (unsigned char *) malloc(src->wbytes);
+    if( dst->tiles ) dstrow = (unsigned char *) malloc(dst->wbytes);
+    if( (src->tiles && !srcrow) || (dst->tiles && !dstrow) ) {
+        free(buffer);
+        free(srcrow);
+        free(dstrow);
+        return;
+    }
+
+    // Rows of the same screen are processed in the order that does not
+    // overwrite the source rows not yet used
+    for(INT i=0;i<h;i++) {
+        INT j = (src == dst && dy > sy) ? h-1-i : i;
+        unsigned char *d;
+        const unsigned char *s,*row;
+
+        if( dst->tiles )
+            d = ScreenTilesRow(dst,dy+j,dstrow)+p1;
+        else
+            d = &(dst->data[(dy+j)*dst->wbytes+p1]);
+        if( src->tiles )
+            row = ScreenTilesRow(src,sy+j,srcrow);
+        else
+            row = &(src->data[(sy+j)*src->wbytes]);
+
+        if( shift ) {
+            INT s0 = sx-(dx&7);
+            for(INT k=0;k<n;k++)
+                buffer[k] = ScreenRowByte(row,src->wbytes,s0+8*k);
+            s = buffer;
+        } else {
+            s = row+(src->fmt == PBM ? sx>>3 : sx*src->bpp);
+            if( !direct ) {
+                memcpy(buffer,s,n);
+                s = buffer;
+            }
+        }
+        d[0] = ScreenOpMasked(op,d[0],s[0],m1);
+        if( n > 1 ) {
+            if( n > 2 )
+                ScreenOpBytes(op,d+1,s+1,n-2);
+            d[n-1] = ScreenOpMasked(op,d[n-1],s[n-1],m2);
+        }
+        if( dst->tiles )
+            ScreenTilesWriteRow(dst,dy+j,dstrow,p1,p1+n-1);
+    }
+    free(buffer);
+    free(srcrow);
+    free(dstrow);
+}
+
+
+/**
+ * @brief   Drawing routines of a format
+ */
+static const ScreenOpsType *ScreenFormatOps(ImageFormatType fmt) {
+
+    switch(fmt) {
+    case PGM: return &opspgm;
+    case PPM:
+    case PAM: return &opsrgb;
+    default:  return &opspbm;
     }
 }
@@ -11,6 +11,8 @@
  */
 
 
+#include <stdio.h>
+
 #ifndef INT
 #define INT                 int
 #endif
@@ -19,14 +21,170 @@
 #define LONG                long
 #endif
 
+/**
+ * @brief Pixel write counter
+ *
+ * @note  When SCREENSTATS is not zero, every pixel written is counted. It is
+ *        used to verify that the drawing routines do not write a pixel twice
+ */
+#ifndef SCREENSTATS
+#define SCREENSTATS         0
+#endif
+
+#if SCREENSTATS
+#define SCREENCOUNT(S,N)    ((S)->writes += (N))
+#else
+#define SCREENCOUNT(S,N)    ((void) 0)
+#endif
+
+/**
+ * @brief Simple Graphics Image routines
+ *
+ * @note  The struct is public only to allow the unchecked (inline) routines
+ *
+ * @note  PBM screens use 1 bit per pixel (packed, MSB first), PGM 1 byte
+ *        (gray level), PPM 3 bytes (RGB) and PAM 4 bytes (RGBA). In all
+ *        formats, wbytes is the size of a row in bytes
+ */
+///@{
+typedef enum { PBM, PGM, PPM, PAM } ImageFormatType;
+
+typedef enum { SCREEN_COPY, SCREEN_OR, SCREEN_AND, SCREEN_XOR } ScreenOpType;
+
+/**
+ * @brief Expected access to the rows of a mapped screen (see ScreenAdviseRows)
+ */
+typedef enum { SCREEN_ADVISE_RANDOM, SCREEN_ADVISE_SEQUENTIAL,
+               SCREEN_ADVISE_WILLNEED, SCREEN_ADVISE_DONTNEED } ScreenAdviceType;
+
 typedef struct ScreenStruct ScreenType;
 
+/**
+ * @brief Drawing routines of a format
+ *
+ * @note  They receive points already clipped. Chosen once by ScreenCreate, so
+ *        there is no test of the format for each pixel
+ */
+typedef struct {
+    void (*point)(ScreenType *screen, INT x, INT y);
+    void (*hline)(ScreenType *screen, INT x1, INT x2, INT y);       // x1 <= x2
+    void (*vline)(ScreenType *screen, INT x, INT y1, INT y2);       // y1 <= y2
+    void (*blend)(ScreenType *screen, INT x, INT y, INT alpha);     // alpha 0..255
+} ScreenOpsType;
+
+/**
+ * @brief Changed rows of a screen (see ScreenTrackDirty)
+ *
+ * @note  Row y changed between the columns x1[y] and x2[y] (x1[y] > x2[y] if
+ *        it did not change). The columns of a row are the smallest span
+ *        covering all the changes in it
+ *
+ * @note  There is no field shared by the rows: the band that changed is
+ *        found from them. So the bands of DisplayListRender, each drawn by
+ *        its own thread, are tracked without locking
+ */
+typedef struct {
+    INT            *x1,*x2;
+} ScreenDirtyType;
+
+/**
+ * @brief Sparse storage of a PBM screen (see ScreenCreateSparse)
+ *
+ * @note  The screen is cut in tiles of SCREEN_TILESIZE x SCREEN_TILESIZE
+ *        pixels, allocated when they are first written
+ */
+#define SCREEN_TILESIZE     64
+#define SCREEN_TILEBYTES    (SCREEN_TILESIZE/8)         // Bytes of a row of a tile
+
+typedef struct ScreenTilesStruct ScreenTilesType;
+
+/**
+ * @brief Rectangle (inclusive limits)
+ */
+typedef struct {
+    INT             x1,y1;
+    INT             x2,y2;
+} ScreenRectType;
+
+struct ScreenStruct {
+    ImageFormatType fmt;        // Storage format
+    INT             w;          // width in pixels
+    INT             wbytes;     // width in bytes
+    INT             h;          // height in pixels
+    INT             bpp;        // bytes per pixel (0 for PBM)
+    const ScreenOpsType *ops;   // Drawing routines of the format
+    unsigned char   ink[4];     // Drawing value: gray in ink[0] or RGBA
+    unsigned long   writes;     // pixels written (only if SCREENSTATS)
+    ScreenDirtyType *dirty;     // Changed rows (NULL if not tracked)
+    void           *map;        // Mapping of a file (NULL if allocated)
+    size_t          mapsize;
+    ScreenTilesType *tiles;     // Sparse storage (NULL if data[] is used)
+    unsigned char   data[];
+};
+///@}
+
 ScreenType *ScreenCreate(int width, int height);
+ScreenType *ScreenCreateFormat(int width, int height, ImageFormatType fmt);
+ScreenType *ScreenCreateMapped(const char *path, INT width, INT height);
+ScreenType *ScreenCreateSparse(INT width, INT height);
+unsigned long ScreenSparseTiles(ScreenType *screen);
+int  ScreenSync(ScreenType *screen);
+void ScreenAdviseRows(ScreenType *screen, INT y1, INT y2, ScreenAdviceType advice);
 void ScreenDestroy(ScreenType *screen);
 void ScreenFill(ScreenType *screen, int value);
 void ScreenWritePBM(ScreenType *screen, FILE *fout);
-void ScreenDrawPoint(ScreenType *screen, int x, int y);
-void ScreenDrawVertLine(ScreenType *screen, int x, int y1, int y2);
-void ScreenDrawHorizLine(ScreenType *screen,int x1, int x2, int y);
+void ScreenWritePBMBinary(ScreenType *screen, FILE *fout);
+void ScreenWritePGM(ScreenType *screen, FILE *fout);
+void ScreenWritePPM(ScreenType *screen, FILE *fout);
+void ScreenSetColor(ScreenType *screen, INT r, INT g, INT b, INT a);
+void ScreenDrawPoint(ScreenType *screen, INT x, INT y);
+void ScreenBlendPoint(ScreenType *screen, INT x, INT y, INT alpha);
+void ScreenDrawVertLine(ScreenType *screen, INT x, INT y1, INT y2);
+void ScreenDrawHorizLine(ScreenType *screen, INT x1, INT x2, INT y);
+void ScreenDrawHorizPattern(ScreenType *screen, INT x1, INT x2, INT y,
+                            const unsigned char *mask, int len, int phase, int step);
+void ScreenCombine(ScreenType *dst, ScreenType *src, ScreenOpType op);
+void ScreenBlit(ScreenType *dst, INT dx, INT dy, ScreenType *src, INT sx, INT sy, INT w, INT h, ScreenOpType op);
+INT  ScreenWidth(ScreenType *screen);
+INT  ScreenHeight(ScreenType *screen);
+ImageFormatType ScreenFormat(ScreenType *screen);
+unsigned long ScreenPixelWrites(ScreenType *screen);
+void ScreenResetPixelWrites(ScreenType *screen);
+int  ScreenTrackDirty(ScreenType *screen, int on);
+void ScreenMarkDirty(ScreenType *screen, INT x1, INT y1, INT x2, INT y2);
+void ScreenClearDirty(ScreenType *screen);
+int  ScreenDirtyRects(ScreenType *screen, ScreenRectType *rects, int max);
+INT  ScreenWriteDirty(ScreenType *screen, FILE *fout, INT *y);
+
+/**
+ * @brief Record a changed span of a row
+ *
+ * @note  Only when the changes are tracked (a test for each write if not).
+ *        The span must be inside the screen
+ */
+#define SCREENDIRTY(S,X1,X2,Y)  do { \
+                                    if ((S)->dirty) \
+                                        ScreenDirtySpan((S)->dirty,(X1),(X2),(Y)); \
+                                } while(0)
+
+static inline void ScreenDirtySpan(ScreenDirtyType *d, INT x1, INT x2, INT y) {
+
+    if( x1 < d->x1[y] ) d->x1[y] = x1;
+    if( x2 > d->x2[y] ) d->x2[y] = x2;
+}
+
+/**
+ * @brief Plot point without any verification
+ *
+ * @note  Only for points already known to be inside the screen (clipped)
+ *
+ * @note  Only for PBM screens using data[] (not sparse)
+ */
+static inline void ScreenDrawPointUnsafe(ScreenType *screen, INT x, INT y) {
+
+    screen->data[y*screen->wbytes+(x>>3)] |= (unsigned char) (0x80>>(x&7));
+    SCREENCOUNT(screen,1);
+    SCREENDIRTY(screen,x,x,y);
+}
 
 #endif // SCREEN_H
@@ -0,0 +1,160 @@
+/**
+ * @file    screenkernels.c
+ *
+ * @brief   Byte kernels (fill, copy, or, and, xor) for the bulk screen
+ *          operations
+ *
+ * @note    There are scalar kernels, which work on machine words, and, on x86,
+ *          SSE2 and AVX2 kernels. The best set supported by the CPU is chosen
+ *          at run time by ScreenKernelsInit. Every set uses memset and memcpy
+ *          for fill and copy: the C library already vectorizes them, better
+ *          than a plain loop of stores. Only the logical operations have
+ *          vector kernels. The vector kernels are compiled
+ *          with the target attribute, so no special compiler flags are needed.
+ *
+ * @note    Compile with SCREENSIMD=0 to use only the scalar kernels
+ *
+ * @author  Hans
+ *
+ * @version 1.0
+ *
+ * @date    17/10/2026
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "screenkernels.h"
+
+#if SCREENSIMD && (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define SCREENKERNELS_X86   1
+#include <immintrin.h>
+#else
+#define SCREENKERNELS_X86   0
+#endif
+
+
+/**
+ * @brief   Scalar kernels
+ *
+ * @note    memset and memcpy are used for fill and copy. The logical
+ *          operations work on unsigned longs (memcpy avoids unaligned access)
+ */
+///@{
+static void FillScalar(unsigned char *dst, int value, long n) {
+
+    memset(dst,value,n);
+}
+
+static void CopyScalar(unsigned char *dst, const unsigned char *src, long n) {
+
+    memcpy(dst,src,n);
+}
+
+#define SCREENKERNEL_SCALAR(NAME,OP) \
+static void NAME(unsigned char *dst, const unsigned char *src, long n) { \
+unsigned long a,b; \
+long i = 0; \
+    for(;i+(long)sizeof(a)<=n;i+=sizeof(a)) { \
+        memcpy(&a,dst+i,sizeof(a)); \
+        memcpy(&b,src+i,sizeof(b)); \
+        a = a OP b; \
+        memcpy(dst+i,&a,sizeof(a)); \
+    } \
+    for(;i<n;i++) \
+        dst[i] = dst[i] OP src[i]; \
+}
+
+SCREENKERNEL_SCALAR(OrScalar,|)
+SCREENKERNEL_SCALAR(AndScalar,&)
+SCREENKERNEL_SCALAR(XorScalar,^)
+///@}
+
+static const ScreenKernelsType kernelsscalar = {
+    "scalar", FillScalar, CopyScalar, OrScalar, AndScalar, XorScalar
+};
+
+
+#if SCREENKERNELS_X86
+/**
+ * @brief   SSE2 logical kernels (16 bytes at a time)
+ */
+///@{
+#define SCREENKERNEL_SSE2(NAME,INTRIN,OP) \
+__attribute__((target("sse2"))) \
+static void NAME(unsigned char *dst, const unsigned char *src, long n) { \
+long i = 0; \
+    for(;i+16<=n;i+=16) { \
+        __m128i a = _mm_loadu_si128((const __m128i *) (dst+i)); \
+        __m128i b = _mm_loadu_si128((const __m128i *) (src+i)); \
+        _mm_storeu_si128((__m128i *) (dst+i),INTRIN(a,b)); \
+    } \
+    for(;i<n;i++) \
+        dst[i] = dst[i] OP src[i]; \
+}
+
+SCREENKERNEL_SSE2(OrSSE2,_mm_or_si128,|)
+SCREENKERNEL_SSE2(AndSSE2,_mm_and_si128,&)
+SCREENKERNEL_SSE2(XorSSE2,_mm_xor_si128,^)
+///@}
+
+static const ScreenKernelsType kernelssse2 = {
+    "sse2", FillScalar, CopyScalar, OrSSE2, AndSSE2, XorSSE2
+};
+
+
+/**
+ * @brief   AVX2 logical kernels (32 bytes at a time)
+ */
+///@{
+#define SCREENKERNEL_AVX2(NAME,INTRIN,OP) \
+__attribute__((target("avx2"))) \
+static void NAME(unsigned char *dst, const unsigned char *src, long n) { \
+long i = 0; \
+    for(;i+32<=n;i+=32) { \
+        __m256i a = _mm256_loadu_si256((const __m256i *) (dst+i)); \
+        __m256i b = _mm256_loadu_si256((const __m256i *) (src+i)); \
+        _mm256_storeu_si256((__m256i *) (dst+i),INTRIN(a,b)); \
+    } \
+    for(;i<n;i++) \
+        dst[i] = dst[i] OP src[i]; \
+}
+
+SCREENKERNEL_AVX2(OrAVX2,_mm256_or_si256,|)
+SCREENKERNEL_AVX2(AndAVX2,_mm256_and_si256,&)
+SCREENKERNEL_AVX2(XorAVX2,_mm256_xor_si256,^)
+///@}
+
+static const ScreenKernelsType kernelsavx2 = {
+    "avx2", FillScalar, CopyScalar, OrAVX2, AndAVX2, XorAVX2
+};
+#endif
+
+
+const ScreenKernelsType *screenkernels = &kernelsscalar;
+
+static pthread_once_t screenkernelsonce = PTHREAD_ONCE_INIT;
+
+
+/**
+ * @brief   Choose the kernels for this CPU
+ */
+static void ScreenKernelsSelect(void) {
+
+#if SCREENKERNELS_X86
+    __builtin_cpu_init();
+    if( __builtin_cpu_supports("avx2") )
+        screenkernels = &kernelsavx2;
+    else if( __builtin_cpu_supports("sse2") )
+        screenkernels = &kernelssse2;
+#endif
+}
+
+
+/**
+ * @brief   Choose the kernels (only once)
+ */
+void ScreenKernelsInit(void) {
+
+    pthread_once(&screenkernelsonce,ScreenKernelsSelect);
+}
@@ -0,0 +1,40 @@
+#ifndef SCREENKERNELS_H
+#define SCREENKERNELS_H
+/**
+ * @file    screenkernels.h
+ * @brief   Byte kernels used by the bulk screen operations
+ *
+ * @version 1.0
+ * Date:    17/10/2026
+ *
+ */
+
+#ifndef SCREENSIMD
+#define SCREENSIMD          1
+#endif
+
+/**
+ * @brief  Kernels operating on n bytes
+ *
+ * @note   Source and destination must not overlap
+ */
+typedef struct {
+    const char *name;
+    void (*fill)(unsigned char *dst, int value, long n);
+    void (*copy)(unsigned char *dst, const unsigned char *src, long n);
+    void (*orbits)(unsigned char *dst, const unsigned char *src, long n);
+    void (*andbits)(unsigned char *dst, const unsigned char *src, long n);
+    void (*xorbits)(unsigned char *dst, const unsigned char *src, long n);
+} ScreenKernelsType;
+
+/**
+ * @brief  Kernels chosen for this CPU
+ *
+ * @note   Set to the scalar kernels until ScreenKernelsInit is called.
+ *         ScreenCreate calls it, so it is set before any screen exists
+ */
+extern const ScreenKernelsType *screenkernels;
+
+extern void ScreenKernelsInit(void);
+
+#endif // SCREENKERNELS_H
@@ -0,0 +1,379 @@
+/**
+ * @file    stroke.c
+ *
+ * @brief   Draw thick lines, circles and ellipses with a pen of w pixels
+ *
+ * @note    The pen covers its pixels once: each row is sent as one or two
+ *          horizontal runs, so the cost grows with the rows covered, not with
+ *          w times the length. There are no pinholes on the diagonals.
+ *
+ * @note    A line covers the pixels whose perpendicular distance c/len to
+ *          the line is in (-w/2,w/2] and whose projection on the line falls
+ *          between the end points (butt caps). c and the projection are
+ *          integer cross and dot products, linear in x on a row, so the run
+ *          of each row is found with two pairs of divisions. The bound
+ *          w*len/2 is an integer square root, computed once.
+ *
+ * @note    A circle or an ellipse covers the annulus between an outer and an
+ *          inner midpoint curve (radii r+w/2 and r-w+w/2). The half width of
+ *          each row of both filled curves is recorded thru a context, and
+ *          each row sends the outer run without the inner one. In fill mode,
+ *          the outer curve is filled. Only the rows inside the clip are
+ *          recorded, STROKE_ROWS at a time, with the curves clipped to them
+ *          (see MarkCurveWindows), so nothing is allocated and a large
+ *          figure costs the rows it covers.
+ *
+ * @note    The products of the lines grow as w^2*len^2. LONG128 is used if
+ *          available (coordinates up to STROKE_MAXCOORD). Otherwise, LONG64
+ *          limits them to about a million. Lines out of range are not drawn.
+ *
+ * @author  Hans
+ *
+ * @version 1.0
+ *
+ * @date    17/10/2026
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <limits.h>
+#include "stroke.h"
+#include "bresenham.h"
+#include "midpoint.h"
+#include "mark.h"
+
+#ifdef LONG128
+#define STROKEWIDE          LONG128
+#define STROKE_MAXCOORD     (1<<30)
+#define STROKE_MAXWIDTH     (1<<20)
+#else
+#define STROKEWIDE          LONG64
+#define STROKE_MAXCOORD     (1<<20)
+#define STROKE_MAXWIDTH     (1<<10)
+#endif
+
+#define STROKE_ROWS         256             // Rows recorded at a time
+
+#define ABS(X)  ((X)>0?(X):-(X))
+
+
+/*
+ * @brief   Integer division rounding toward -infinity and +infinity
+ *
+ * @note    Divisor can be negative
+ */
+///@{
+static STROKEWIDE strokefloordiv(STROKEWIDE a, STROKEWIDE b) {
+STROKEWIDE q = a/b;
+
+    if( a%b != 0 && ((a < 0) != (b < 0)) ) q--;
+    return q;
+}
+
+static STROKEWIDE strokeceildiv(STROKEWIDE a, STROKEWIDE b) {
+STROKEWIDE q = a/b;
+
+    if( a%b != 0 && ((a < 0) == (b < 0)) ) q++;
+    return q;
+}
+///@}
+
+
+/**
+ * @brief   Integer square root (largest r with r*r <= v)
+ */
+static STROKEWIDE strokeisqrt(STROKEWIDE v) {
+STROKEWIDE r = 0;
+STROKEWIDE b = (STROKEWIDE) 1 << (sizeof(STROKEWIDE)*8-2);
+
+    while( b > v ) b >>= 2;
+    while( b != 0 ) {
+        if( v >= r+b ) {
+            v -= r+b;
+            r = (r>>1)+b;
+        } else {
+            r >>= 1;
+        }
+        b >>= 2;
+    }
+    return r;
+}
+
+
+/**
+ * @brief   Send the run x1..x2 of row y, clipped
+ */
+static void strokerun(DrawContextType *ctx, MarkClipType *clip, LONG64 x1, LONG64 x2, LONG64 y) {
+
+    if( y < clip->ymin || y > clip->ymax ) return;
+    if( x1 < clip->xmin ) x1 = clip->xmin;
+    if( x2 > clip->xmax ) x2 = clip->xmax;
+    if( x1 <= x2 ) MARKHRUN(ctx,(INT) x1,(INT) x2,(INT) y);
+}
+
+
+/**
+ * @brief   Draw a line with a pen of w pixels
+ *
+ * @note    Pixel (x,y) is covered if, with c = (x-x1)*dy - (y-y1)*dx and
+ *          p = (x-x1)*dx + (y-y1)*dy, -w*len/2 < c <= w*len/2 and
+ *          0 <= p <= len^2. A line of length 0 is a w x w square.
+ *
+ * @note    Widths up to 1 draw the line of drawlinebctx
+ */
+void drawthicklinectx(DrawContextType *ctx, INT x1, INT y1, INT x2, INT y2, INT w) {
+MarkClipType clip;
+STROKEWIDE dx,dy,l2,s,t,tl,e,lo,hi;
+LONG64 ymin,ymax;
+
+    if( w <= 1 ) {
+        if( w == 1 ) drawlinebctx(ctx,x1,y1,x2,y2);
+        return;
+    }
+    if( w > STROKE_MAXWIDTH ||
+        ABS((LONG64) x1) > STROKE_MAXCOORD || ABS((LONG64) y1) > STROKE_MAXCOORD ||
+        ABS((LONG64) x2) > STROKE_MAXCOORD || ABS((LONG64) y2) > STROKE_MAXCOORD )
+        return;
+    if( !MarkGetClip(ctx,&clip) ) return;
+
+    dx = (STROKEWIDE) x2-x1;
+    dy = (STROKEWIDE) y2-y1;
+    l2 = dx*dx+dy*dy;
+    if( l2 == 0 ) {
+        for(LONG64 y=(LONG64) y1-(w-1)/2;y<=(LONG64) y1+w/2;y++)
+            strokerun(ctx,&clip,(LONG64) x1-(w-1)/2,(LONG64) x1+w/2,y);
+        return;
+    }
+
+    // c <= t and -c <= tl (-c < w*len/2: one less if w*len/2 is an integer)
+    s = strokeisqrt((STROKEWIDE) w*w*l2);
+    t = s/2;
+    tl = (s*s == (STROKEWIDE) w*w*l2 && s%2 == 0) ? t-1 : t;
+
+    // Rows of the line, widened by w/2 (the caps do not go further)
+    ymin = (y1 < y2 ? y1 : y2)-(LONG64) w/2-1;
+    ymax = (y1 < y2 ? y2 : y1)+(LONG64) w/2+1;
+    if( ymin < clip.ymin ) ymin = clip.ymin;
+    if( ymax > clip.ymax ) ymax = clip.ymax;
+
+    for(LONG64 y=ymin;y<=ymax;y++) {
+        e = (STROKEWIDE) y-y1;
+        lo = (STROKEWIDE) clip.xmin-x1;
+        hi = (STROKEWIDE) clip.xmax-x1;
+
+        // Across: e*dx-tl <= (x-x1)*dy <= e*dx+t
+        if( dy > 0 ) {
+            s = strokeceildiv(e*dx-tl,dy);
+            if( s > lo ) lo = s;
+            s = strokefloordiv(e*dx+t,dy);
+            if( s < hi ) hi = s;
+        } else if( dy < 0 ) {
+            s = strokeceildiv(e*dx+t,dy);
+            if( s > lo ) lo = s;
+            s = strokefloordiv(e*dx-tl,dy);
+            if( s < hi ) hi = s;
+        } else if( e*dx > tl || -e*dx > t ) {
+            continue;
+        }
+
+        // Along: -e*dy <= (x-x1)*dx <= l2-e*dy
+        if( dx > 0 ) {
+            s = strokeceildiv(-e*dy,dx);
+            if( s > lo ) lo = s;
+            s = strokefloordiv(l2-e*dy,dx);
+            if( s < hi ) hi = s;
+        } else if( dx < 0 ) {
+            s = strokeceildiv(l2-e*dy,dx);
+            if( s > lo ) lo = s;
+            s = strokefloordiv(-e*dy,dx);
+            if( s < hi ) hi = s;
+        } else if( e*dy < 0 || e*dy > l2 ) {
+            continue;
+        }
+
+        if( lo <= hi ) MARKHRUN(ctx,(INT) (x1+lo),(INT) (x1+hi),(INT) y);
+    }
+}
+
+
+/**
+ * @brief   Half widths of the rows of a filled curve centered at (0,0)
+ *
+ * @note    half[y-y0] is the largest x of row y (y0 <= y < y0+n), -1 if the
+ *          row is empty
+ */
+typedef struct {
+    INT         half[STROKE_ROWS];
+    INT         y0,n;
+} StrokeRowsType;
+
+
+/**
+ * @brief   Sinks of the context that records the rows
+ */
+///@{
+static void strokerowsrun(DrawContextType *sub, INT x1, INT x2, INT y) {
+StrokeRowsType *rows = (StrokeRowsType *) sub->user;
+
+    (void) x1;
+    if( y >= rows->y0 && y-rows->y0 < rows->n && x2 > rows->half[y-rows->y0] )
+        rows->half[y-rows->y0] = x2;
+}
+
+static void strokerowspoint(DrawContextType *sub, INT x, INT y) {
+
+    strokerowsrun(sub,x,x,y);
+}
+
+static void strokerowsvrun(DrawContextType *sub, INT x, INT y1, INT y2) {
+
+    for(INT y=y1;y<=y2;y++) strokerowsrun(sub,x,x,y);
+}
+///@}
+
+
+/**
+ * @brief   Record rows y0 to y0+n-1 of the filled midpoint circle (rx == ry)
+ *          or ellipse centered at (0,0)
+ *
+ * @note    The curve is clipped to the rows, so its loop walks only the steps
+ *          that reach them. Nothing is recorded for negative radii (all rows
+ *          empty)
+ */
+static void strokerows(DrawContextType *ctx, StrokeRowsType *rows, INT y0, INT n,
+                       INT rx, INT ry, int circle) {
+DrawContextType sub;
+
+    rows->y0 = y0;
+    rows->n = n;
+    for(INT i=0;i<n;i++) rows->half[i] = -1;
+    if( rx < 0 || ry < 0 || y0 > ry ) return;
+
+    sub = *ctx;
+    sub.screen = 0;
+    sub.clipped = 1;
+    sub.clip.xmin = -rx;
+    sub.clip.xmax = rx;
+    sub.clip.ymin = y0;
+    sub.clip.ymax = n-1 < ry-y0 ? y0+n-1 : ry;
+    sub.drawmode = MARK_FILL;
+    sub.linemode = MARK_LINE_POINTS;
+    sub.point = strokerowspoint;
+    sub.hrun = strokerowsrun;
+    sub.vrun = strokerowsvrun;
+    sub.blend = 0;
+    sub.user = rows;
+    sub.fillpending = 0;
+    sub.order = MARK_ORDER_MIRROR;
+    sub.ordering = 0;
+    sub.patternlen = 0;
+    if( circle )
+        drawcirclemctx(&sub,0,0,rx);
+    else
+        drawellipsemctx(&sub,0,0,rx,ry);
+}
+
+
+/**
+ * @brief   Draw the annulus of a circle (rx == ry) or an ellipse
+ */
+static void strokeannulus(DrawContextType *ctx, INT xc, INT yc, INT rx, INT ry, INT w,
+                          int circle) {
+MarkClipType clip;
+StrokeRowsType outer,inner;
+INT rxo,ryo,rxi,ryi;
+LONG64 ymin,ymax,y1,y2,k,k1,k2,xo,xi;
+
+    if( rx < 0 || ry < 0 || w < 1 ) return;
+    if( w == 1 && ctx->drawmode == MARK_CONTOUR ) {
+        if( circle )
+            drawcirclemctx(ctx,xc,yc,rx);
+        else
+            drawellipsemctx(ctx,xc,yc,rx,ry);
+        return;
+    }
+    if( (LONG64) rx+w/2 > INT_MAX || (LONG64) ry+w/2 > INT_MAX ) return;
+    rxo = rx+w/2;
+    ryo = ry+w/2;
+    rxi = rx-(w-w/2);
+    ryi = ry-(w-w/2);
+    if( ctx->drawmode == MARK_FILL ) rxi = ryi = -1;
+    if( MarkEllipseRange(xc,yc,rxo,ryo) == MARK_RANGE_NONE ) return;
+    if( MarkClipBox(ctx,xc-rxo,yc-ryo,xc+rxo,yc+ryo) == MARK_OUTSIDE ) return;
+    if( !MarkGetClip(ctx,&clip) ) return;
+
+    ymin = (LONG64) yc-ryo;
+    ymax = (LONG64) yc+ryo;
+    if( ymin < clip.ymin ) ymin = clip.ymin;
+    if( ymax > clip.ymax ) ymax = clip.ymax;
+    for(y1=ymin;y1<=ymax;y1=y2+1) {
+        // Rows y1 to y2 are k1 to k2 away from the center (at most STROKE_ROWS)
+        y2 = y1+STROKE_ROWS-1 < ymax ? y1+STROKE_ROWS-1 : ymax;
+        k1 = ABS(y1-yc) < ABS(y2-yc) ? ABS(y1-yc) : ABS(y2-yc);
+        k2 = ABS(y1-yc) < ABS(y2-yc) ? ABS(y2-yc) : ABS(y1-yc);
+        if( y1 <= yc && yc <= y2 ) k1 = 0;
+        strokerows(ctx,&outer,(INT) k1,(INT) (k2-k1+1),rxo,ryo,circle);
+        strokerows(ctx,&inner,(INT) k1,(INT) (k2-k1+1),rxi,ryi,circle);
+
+        for(LONG64 y=y1;y<=y2;y++) {
+            k = ABS(y-yc)-k1;
+            xo = outer.half[k];
+            xi = inner.half[k];
+            if( xo < 0 ) continue;
+            if( xi < 0 ) {
+                strokerun(ctx,&clip,xc-xo,xc+xo,y);
+            } else {
+                strokerun(ctx,&clip,xc-xo,xc-xi-1,y);
+                strokerun(ctx,&clip,xc+xi+1,xc+xo,y);
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief   Draw a circle or an ellipse with a pen of w pixels
+ *
+ * @note    The pen goes w/2 pixels outside the curve and the rest inside.
+ *          Width 1 draws the curve of midpoint.c
+ */
+///@{
+void drawthickcirclectx(DrawContextType *ctx, INT xc, INT yc, INT r, INT w) {
+
+    strokeannulus(ctx,xc,yc,r,r,w,1);
+}
+
+void drawthickellipsectx(DrawContextType *ctx, INT xc, INT yc, INT rx, INT ry, INT w) {
+
+    strokeannulus(ctx,xc,yc,rx,ry,w,0);
+}
+///@}
+
+
+/**
+ * @brief   Old interface. Draw on markscreen using the global variables
+ *
+ * @note    A context is built from them at each call (see MarkGlobalContext)
+ */
+///@{
+void drawthickline(INT x1, INT y1, INT x2, INT y2, INT w) {
+DrawContextType ctx;
+
+    MarkGlobalContext(&ctx);
+    drawthicklinectx(&ctx,x1,y1,x2,y2,w);
+}
+
+void drawthickcircle(INT xc, INT yc, INT r, INT w) {
+DrawContextType ctx;
+
+    MarkGlobalContext(&ctx);
+    drawthickcirclectx(&ctx,xc,yc,r,w);
+}
+
+void drawthickellipse(INT xc, INT yc, INT rx, INT ry, INT w) {
+DrawContextType ctx;
+
+    MarkGlobalContext(&ctx);
+    drawthickellipsectx(&ctx,xc,yc,rx,ry,w);
+}
+///@}
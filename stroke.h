@@ -0,0 +1,34 @@
+#ifndef STROKE_H
+#define STROKE_H
+/**
+ * @file    stroke.h
+ * @brief   Thick lines, circles and ellipses (pen width in pixels)
+ *
+ * @note    The pixels covered by the pen are sent as horizontal runs, one or
+ *          two for each row (see stroke.c). A width of 1 draws the thin
+ *          figures of bresenham.c and midpoint.c.
+ *
+ * @version 1.0
+ * Date:    17/10/2026
+ *
+ */
+
+#ifndef INT
+#define INT     int
+#endif
+
+#ifndef LONG
+#define LONG    long
+#endif
+
+#include "mark.h"
+
+void drawthickline(INT x1, INT y1, INT x2, INT y2, INT w);
+void drawthickcircle(INT xc, INT yc, INT r, INT w);
+void drawthickellipse(INT xc, INT yc, INT rx, INT ry, INT w);
+
+void drawthicklinectx(DrawContextType *ctx, INT x1, INT y1, INT x2, INT y2, INT w);
+void drawthickcirclectx(DrawContextType *ctx, INT xc, INT yc, INT r, INT w);
+void drawthickellipsectx(DrawContextType *ctx, INT xc, INT yc, INT rx, INT ry, INT w);
+
+#endif // STROKE_H
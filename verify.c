@@ -0,0 +1,2090 @@
+/**
+ * @file    verify.c
+ *
+ * @brief   Check the integer ellipse routines against a floating point
+ *          reference, from small radii to very large ones
+ *
+ * @note    The points of the first quadrant are collected by a sink. For
+ *          each ellipse, it is checked that
+ *              - the contour starts at (0,ry) and ends at (rx,0)
+ *              - it is 8-connected and monotonic (x grows, y decreases)
+ *              - each point is near the exact ellipse. The distance is
+ *                computed in double precision (Eberly method)
+ *              - in fill mode, the same rows are filled up to the contour
+ *              - ellipses out of range (see MarkEllipseRange) draw nothing
+ *
+ * @note    Rotated ellipses and arcs are drawn on grids: each point once,
+ *          near the ellipse and connected, and arcs are the part of the full
+ *          figure inside the sector. Bézier curves go from the first to the
+ *          last control point, 8-connected and near the curve. Polylines
+ *          have the points of drawlinebctx, with the joints sent once.
+ *          Filled polygons are the pixels whose center is inside (exact
+ *          test), each one once. Circles and ellipses sent to a motion
+ *          stream (path order) are rebuilt from the steps: same pixels,
+ *          one pen down. The changed rows recorded by a screen cover the
+ *          pixels changed. Screens stored in a file and sparse
+ *          screens hold the same pixels. Thick figures cover each pixel of
+ *          their definition once. Dashed figures are the points of the
+ *          solid ones whose bit of the pattern is on. Circles and ellipses
+ *          clipped to a small window send the points of the unclipped ones
+ *          inside it.
+ *
+ * @note    The workload is: all radii up to VERIFY_SMALL, radii around the
+ *          limits of the 32 and 64 bit terms and random radii up to maxr
+ *          (with random centers)
+ *
+ * @note    No screen is used, so the coordinates can be as large as INT
+ *          allows. Usage: verify [ellipses [maxr [seed]]]
+ *
+ * @note    Use make CFLAGS=-O2 verify
+ *
+ * @author  Hans
+ *
+ * @version 1.0
+ *
+ * @date    17/10/2026
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "mark.h"
+#include "backend.h"
+#include "drawloop.h"
+#include "bresenham.h"
+#include "midpoint.h"
+#include "arc.h"
+#include "curve.h"
+#include "motion.h"
+#include "wu.h"
+#include "stroke.h"
+#include "displaylist.h"
+
+#define VERIFY_SMALL        64          // All radii up to it
+#define VERIFY_ELLIPSES     20          // Random ellipses
+#define VERIFY_MAXR         1000000     // Largest random radius
+#define VERIFY_MAXDIST      1.0         // Largest distance to the ellipse
+#define VERIFY_MAXERRORS    10          // Failures printed by algorithm
+#define VERIFY_SMALLROT     16          // Rotated ellipses and arcs: all radii up to it
+#define VERIFY_MAXROT       1000        //  and random ones up to it
+#define VERIFY_SMALLCURVES  10000       // Curves and polylines in a small box
+#define VERIFY_MAXCURVE     2000        //  and random ones up to it
+#define VERIFY_MAXVERTICES  16          // Largest polyline
+#define VERIFY_MAXPOLYGON   200         // Largest random filled polygon
+
+
+/**
+ * @brief   State of the collecting sink for an ellipse
+ *
+ * @note    The rows of the contour are hashed (with the largest x of each
+ *          row) to be compared with the rows of the fill mode
+ */
+typedef struct {
+    INT             xc,yc,rx,ry;
+    int             n;                  // Points in the first quadrant
+    INT             lastx,lasty;        // Last point (relative to center)
+    unsigned long   hash;               // Rows seen
+    unsigned long   rows;
+    INT             rowx,rowy;          // Row being hashed
+    double          maxdist;
+    const char     *error;              // First failure
+} VerifyType;
+
+/**
+ * @brief   Algorithms checked
+ *
+ * @note    maxr is the largest radius supported
+ */
+typedef struct {
+    const char     *name;
+    void          (*ellipse)(DrawContextType *ctx, INT xc, INT yc, INT rx, INT ry);
+    INT             maxr;
+    unsigned long   ellipses;
+    unsigned long   points;
+    unsigned long   failures;
+    double          maxdist;
+} VerifyAlgType;
+
+/**
+ * @brief   Checks of the other figures and of the screens
+ *
+ * @note    count figures are drawn for each ellipse of the workload. total
+ *          adds up what units says (pixels, steps or bytes checked)
+ */
+typedef struct VerifyCheckStruct VerifyCheckType;
+
+struct VerifyCheckStruct {
+    const char     *name;
+    void          (*run)(VerifyCheckType *check, int n);
+    int             count;
+    const char     *units;
+    unsigned long   figures;
+    unsigned long   total;
+    unsigned long   failures;
+};
+
+
+/**
+ * @brief   Root of the equation of the closest point
+ *
+ * @note    g(s) is decreasing and convex. Newton steps are used from s = 0
+ *          (the points are near the ellipse), kept inside the bracket
+ *          [s0,s1]. Otherwise, the bracket is bisected
+ */
+static double verifyroot(double r0, double z0, double z1, double g) {
+double n0,s0,s1,s,sn,ratio0,ratio1,dg;
+
+    n0 = r0*z0;
+    s0 = z1-1;
+    s1 = (g < 0) ? 0 : hypot(n0,z1)-1;
+    s = 0;
+    for(int i=0;i<200;i++) {
+        ratio0 = n0/(s+r0);
+        ratio1 = z1/(s+1);
+        g = ratio0*ratio0+ratio1*ratio1-1;
+        if( g > 0 )       s0 = s;
+        else if( g < 0 )  s1 = s;
+        else              break;
+        dg = -2*(ratio0*ratio0/(s+r0)+ratio1*ratio1/(s+1));
+        sn = s-g/dg;
+        if( !(sn > s0 && sn < s1) ) sn = (s0+s1)/2;
+        if( sn == s ) break;
+        s = sn;
+    }
+    return s;
+}
+
+
+/**
+ * @brief   Distance from the point (x,y) of the first quadrant to the ellipse
+ *          with semi axes a and b
+ *
+ * @note    From D. Eberly, "Distance from a point to an ellipse, an ellipsoid
+ *          or a hyperellipsoid". The semi axes can be 0 (a segment)
+ */
+static double verifydist(double a, double b, double x, double y) {
+double t,z0,z1,g,r0,s,x0,x1,numer,denom;
+
+    if( a < b ) {
+        t = a; a = b; b = t;
+        t = x; x = y; y = t;
+    }
+    if( a == 0 ) return hypot(x,y);
+    if( b == 0 ) return (x <= a) ? y : hypot(x-a,y);
+
+    if( y > 0 ) {
+        if( x > 0 ) {
+            z0 = x/a;
+            z1 = y/b;
+            g = z0*z0+z1*z1-1;
+            if( g == 0 ) return 0;
+            r0 = (a/b)*(a/b);
+            s = verifyroot(r0,z0,z1,g);
+            x0 = r0*x/(s+r0);
+            x1 = y/(s+1);
+            return hypot(x0-x,x1-y);
+        }
+        return fabs(y-b);
+    }
+    numer = a*x;
+    denom = a*a-b*b;
+    if( numer < denom ) {
+        t = numer/denom;
+        x0 = a*t;
+        x1 = b*sqrt(1-t*t);
+        return hypot(x0-x,x1);
+    }
+    return fabs(x-a);
+}
+
+
+static void verifyfail(VerifyType *v, const char *error) {
+
+    if( !v->error ) v->error = error;
+}
+
+
+/**
+ * @brief   Hash a row (y and largest x)
+ */
+static void verifyrow(VerifyType *v, INT x, INT y) {
+
+    v->hash = (v->hash ^ (unsigned long) (unsigned) y) * 1099511628211UL;
+    v->hash = (v->hash ^ (unsigned long) (unsigned) x) * 1099511628211UL;
+    v->rows++;
+}
+
+
+/**
+ * @brief   Sink for the contour. Only the first quadrant is checked
+ */
+static void verifypoint(VerifyType *v, INT px, INT py) {
+LONG64 x,y;
+double d;
+
+    x = (LONG64) px-v->xc;
+    y = (LONG64) py-v->yc;
+    if( x < 0 || y < 0 ) return;
+    if( x > v->rx || y > v->ry ) {
+        verifyfail(v,"point outside the bounding box");
+        return;
+    }
+
+    if( v->n == 0 ) {
+        if( x != 0 || y != v->ry ) verifyfail(v,"first point is not (0,ry)");
+    } else {
+        if( x < v->lastx || y > v->lasty )
+            verifyfail(v,"contour is not monotonic");
+        if( x-v->lastx > 1 || v->lasty-y > 1 )
+            verifyfail(v,"gap in the contour");
+    }
+    v->n++;
+    v->lastx = (INT) x;
+    v->lasty = (INT) y;
+
+    d = verifydist(v->rx,v->ry,(double) x,(double) y);
+    if( d > v->maxdist ) v->maxdist = d;
+    if( d > VERIFY_MAXDIST ) verifyfail(v,"point too far from the ellipse");
+
+    // Rows arrive in order (y decreasing)
+    if( v->n > 1 && y != v->rowy ) verifyrow(v,v->rowx,v->rowy);
+    v->rowx = (INT) x;
+    v->rowy = (INT) y;
+}
+
+
+/**
+ * @brief   Sink for the fill mode. Each row of the lower half is hashed
+ */
+static void verifyspan(VerifyType *v, INT x1, INT x2, INT y) {
+
+    if( (LONG64) y < v->yc ) return;
+    if( (LONG64) v->xc-x1 != (LONG64) x2-v->xc )
+        verifyfail(v,"span is not symmetric");
+    verifyrow(v,(INT) ((LONG64) x2-v->xc),(INT) ((LONG64) y-v->yc));
+}
+
+
+/**
+ * @brief   Context sinks
+ */
+///@{
+static void verifyctxpoint(DrawContextType *ctx, INT x, INT y) {
+
+    verifypoint((VerifyType *) ctx->user,x,y);
+}
+
+static void verifyctxhrun(DrawContextType *ctx, INT x1, INT x2, INT y) {
+
+    verifyspan((VerifyType *) ctx->user,x1,x2,y);
+}
+///@}
+
+
+/**
+ * @brief   Loops of drawloop.h for the collecting sink
+ */
+///@{
+#define VERIFY_POINT(S,X,Y)         verifypoint((S),(X),(Y))
+#define VERIFY_HSPAN(S,X1,X2,Y)     verifyspan((S),(X1),(X2),(Y))
+
+DRAWLOOP_ELLIPSE(verifyloop,VerifyType *,VERIFY_POINT)
+DRAWLOOP_ELLIPSEFILL(verifyloopfill,VerifyType *,VERIFY_HSPAN)
+
+static void verifyloopctx(DrawContextType *ctx, INT xc, INT yc, INT rx, INT ry) {
+
+    if( MarkEllipseRange(xc,yc,rx,ry) != MARK_RANGE_LONG64 ) return;
+    if( ctx->drawmode == MARK_FILL )
+        verifyloopfill((VerifyType *) ctx->user,xc,yc,rx,ry);
+    else
+        verifyloop((VerifyType *) ctx->user,xc,yc,rx,ry);
+}
+///@}
+
+
+static void verifyinit(VerifyType *v, INT xc, INT yc, INT rx, INT ry) {
+
+    v->xc = xc;
+    v->yc = yc;
+    v->rx = rx;
+    v->ry = ry;
+    v->n = 0;
+    v->hash = 14695981039346656037UL;
+    v->rows = 0;
+    v->maxdist = 0;
+    v->error = 0;
+}
+
+
+/**
+ * @brief   Check an ellipse with an algorithm, in contour and fill modes
+ */
+static void verifyellipse(VerifyAlgType *alg, INT xc, INT yc, INT rx, INT ry) {
+DrawContextType ctx;
+VerifyType v;
+unsigned long hash,rows;
+
+    if( rx > alg->maxr || ry > alg->maxr ) return;
+
+    MarkContextInit(&ctx,0);
+    ctx.point = verifyctxpoint;
+    ctx.hrun = verifyctxhrun;
+    ctx.vrun = 0;
+    ctx.blend = 0;
+    ctx.user = &v;
+
+    verifyinit(&v,xc,yc,rx,ry);
+    alg->ellipse(&ctx,xc,yc,rx,ry);
+    if( v.n == 0 ) {
+        verifyfail(&v,"nothing drawn");
+    } else {
+        if( v.lastx != rx || v.lasty != 0 ) verifyfail(&v,"last point is not (rx,0)");
+        verifyrow(&v,v.rowx,v.rowy);
+    }
+    hash = v.hash;
+    rows = v.rows;
+
+    alg->ellipses++;
+    alg->points += v.n;
+    if( v.maxdist > alg->maxdist ) alg->maxdist = v.maxdist;
+
+    if( !v.error ) {
+        ctx.drawmode = MARK_FILL;
+        verifyinit(&v,xc,yc,rx,ry);
+        alg->ellipse(&ctx,xc,yc,rx,ry);
+        if( v.n != 0 ) verifyfail(&v,"points drawn in fill mode");
+        else if( v.rows != rows || v.hash != hash )
+            verifyfail(&v,"fill rows differ from the contour");
+    }
+
+    if( v.error ) {
+        if( alg->failures < VERIFY_MAXERRORS )
+            printf("%s: ellipse (%d,%d) rx=%d ry=%d: %s\n",alg->name,
+                   (int) xc,(int) yc,(int) rx,(int) ry,v.error);
+        alg->failures++;
+    }
+}
+
+
+/**
+ * @brief   Check that an ellipse out of range draws nothing
+ */
+static void verifyreject(VerifyAlgType *alg, INT xc, INT yc, INT rx, INT ry) {
+DrawContextType ctx;
+VerifyType v;
+
+    MarkContextInit(&ctx,0);
+    ctx.point = verifyctxpoint;
+    ctx.hrun = verifyctxhrun;
+    ctx.user = &v;
+
+    verifyinit(&v,xc,yc,rx,ry);
+    alg->ellipse(&ctx,xc,yc,rx,ry);
+    ctx.drawmode = MARK_FILL;
+    alg->ellipse(&ctx,xc,yc,rx,ry);
+    if( v.n != 0 || v.rows != 0 ) {
+        if( alg->failures < VERIFY_MAXERRORS )
+            printf("%s: ellipse (%d,%d) rx=%d ry=%d: out of range but drawn\n",
+                   alg->name,(int) xc,(int) yc,(int) rx,(int) ry);
+        alg->failures++;
+    }
+}
+
+
+/**
+ * @brief   Random number in [0,n)
+ */
+static LONG64 verifyrandom(LONG64 n) {
+unsigned long r;
+
+    r = ((unsigned long) rand() << 31) ^ (unsigned long) rand();
+    return (LONG64) (r % (unsigned long) n);
+}
+
+
+static void verifyalgorithm(VerifyAlgType *alg, int n, INT maxr) {
+static const INT limits[] = {
+    1000, 20000, 23170, 23171, 29999, 30000, 30001, 46340, 46341,
+    65535, 65536, 100000, 1000000
+};
+INT r,xc,yc;
+
+    // All small radii
+    for(INT rx=0;rx<=VERIFY_SMALL;rx++)
+        for(INT ry=0;ry<=VERIFY_SMALL;ry++)
+            verifyellipse(alg,0,0,rx,ry);
+
+    // Around the limits of the terms (INT squares, LONG64, ...)
+    for(int i=0;i<(int) (sizeof(limits)/sizeof(limits[0]));i++) {
+        r = limits[i];
+        verifyellipse(alg,0,0,r,r);
+        verifyellipse(alg,0,0,r,r/3);
+        verifyellipse(alg,0,0,r/3,r);
+        verifyellipse(alg,0,0,r,1);
+        verifyellipse(alg,0,0,1,r);
+    }
+
+    // Random radii and centers (the bounding box fits in INT)
+    for(int i=0;i<n;i++) {
+        xc = (INT) (verifyrandom(2*(LONG64) (INT_MAX-maxr)+1)-(INT_MAX-maxr));
+        yc = (INT) (verifyrandom(2*(LONG64) (INT_MAX-maxr)+1)-(INT_MAX-maxr));
+        verifyellipse(alg,xc,yc,(INT) verifyrandom(maxr)+1,(INT) verifyrandom(maxr)+1);
+    }
+
+    // Out of range
+    verifyreject(alg,0,0,-1,10);
+    verifyreject(alg,0,0,10,-1);
+    verifyreject(alg,INT_MAX-5,0,10,10);
+    verifyreject(alg,0,INT_MIN+5,10,10);
+}
+
+
+/**
+ * @brief   Grid collecting the pixels of a figure drawn around (0,0)
+ *
+ * @note    Used for the rotated ellipses and the arcs, whose points do not
+ *          arrive in order. Each cell counts the points (or span pixels) on it
+ */
+typedef struct {
+    INT             r;                  // Covers [-r,r] in x and y
+    INT             size;
+    unsigned char  *cell;
+    unsigned long   count;              // Pixels drawn
+    int             outside;            // Pixels out of the grid
+} VerifyGridType;
+
+static int verifygridinit(VerifyGridType *g, INT r) {
+
+    g->r = r;
+    g->size = 2*r+1;
+    g->cell = (unsigned char *) calloc((size_t) g->size*g->size,1);
+    g->count = 0;
+    g->outside = 0;
+    return g->cell != 0;
+}
+
+static void verifygridclear(VerifyGridType *g) {
+
+    for(LONG64 i=0;i<(LONG64) g->size*g->size;i++) g->cell[i] = 0;
+    g->count = 0;
+    g->outside = 0;
+}
+
+static int verifygridget(VerifyGridType *g, INT x, INT y) {
+
+    if( x < -g->r || x > g->r || y < -g->r || y > g->r ) return 0;
+    return g->cell[(LONG64) (y+g->r)*g->size+(x+g->r)];
+}
+
+static void verifygridpoint(DrawContextType *ctx, INT x, INT y) {
+VerifyGridType *g = (VerifyGridType *) ctx->user;
+
+    g->count++;
+    if( x < -g->r || x > g->r || y < -g->r || y > g->r ) {
+        g->outside = 1;
+        return;
+    }
+    if( g->cell[(LONG64) (y+g->r)*g->size+(x+g->r)] < 255 )
+        g->cell[(LONG64) (y+g->r)*g->size+(x+g->r)]++;
+}
+
+static void verifygridhrun(DrawContextType *ctx, INT x1, INT x2, INT y) {
+
+    for(INT x=x1;x<=x2;x++) verifygridpoint(ctx,x,y);
+}
+
+
+/**
+ * @brief   A figure of arc.c, drawn on a grid
+ *
+ * @note    kind: 0 rotated ellipse, 1 ellipse, 2 circle. If arc is set, only
+ *          the arc from a1 to a2
+ */
+typedef struct {
+    int     kind;
+    INT     rx,ry,angle;
+    int     arc;
+    INT     a1,a2;
+} VerifyFigureType;
+
+static void verifydrawfigure(VerifyGridType *g, VerifyFigureType *f, MarkDrawModeType mode) {
+DrawContextType ctx;
+
+    // Use only the part of the grid around the figure
+    g->r = ((f->rx > f->ry) ? f->rx : f->ry)+2;
+    g->size = 2*g->r+1;
+
+    MarkContextInit(&ctx,0);
+    ctx.drawmode = mode;
+    ctx.point = verifygridpoint;
+    ctx.hrun = verifygridhrun;
+    ctx.vrun = 0;
+    ctx.blend = 0;
+    ctx.user = g;
+    verifygridclear(g);
+    switch( f->kind ) {
+    case 0:
+        if( f->arc ) drawellipserotarcctx(&ctx,0,0,f->rx,f->ry,f->angle,f->a1,f->a2);
+        else         drawellipserotctx(&ctx,0,0,f->rx,f->ry,f->angle);
+        break;
+    case 1:
+        if( f->arc ) drawellipsearcctx(&ctx,0,0,f->rx,f->ry,f->a1,f->a2);
+        else         drawellipsebctx(&ctx,0,0,f->rx,f->ry);
+        break;
+    default:
+        if( f->arc ) drawarcctx(&ctx,0,0,f->rx,f->a1,f->a2);
+        else         drawcirclebctx(&ctx,0,0,f->rx);
+        break;
+    }
+}
+
+
+/**
+ * @brief   Position of a point in the sector of an arc (floating point)
+ *
+ * @return  1 inside, -1 outside, 0 too near the sides to tell
+ */
+static int verifysector(VerifyFigureType *f, INT x, INT y) {
+double a,a1,sweep,d;
+
+    if( x == 0 && y == 0 ) return 0;
+    a1 = f->a1/(double) ARC_DEGREE;
+    sweep = fmod(f->a2/(double) ARC_DEGREE-a1,360);
+    if( sweep < 0 ) sweep += 360;
+    a = atan2(-(double) y,(double) x)*180/M_PI;
+    d = fmod(a-a1,360);
+    if( d < 0 ) d += 360;
+    // Distance (in pixels) to the nearest side. The directions of the sides
+    // are rounded to 1/ARC_SCALE
+    if( fmin(fabs(d),fmin(fabs(d-360),fabs(d-sweep)))*M_PI/180*hypot(x,y) <
+        0.01+2*hypot(x,y)/ARC_SCALE )
+        return 0;
+    return (d <= sweep) ? 1 : -1;
+}
+
+
+/**
+ * @brief   Check a rotated ellipse (or an arc of any figure) on grids
+ *
+ * @note    Full rotated ellipses: each point once, near the ellipse, with at
+ *          least two neighbors and connected. The fill covers the rows of
+ *          the contour. Arcs: the points (and filled pixels) of the full
+ *          figure inside the sector, and no others
+ */
+static void verifyfigure(VerifyAlgType *alg, VerifyGridType *full, VerifyGridType *part,
+                         VerifyFigureType *f) {
+const char *error = 0;
+double th,u,v,d;
+INT r = ((f->rx > f->ry) ? f->rx : f->ry)+2;
+INT x1,x2;
+int k,nb,in;
+LONG64 reached;
+INT *stack;
+
+    verifydrawfigure(full,f,MARK_CONTOUR);
+    if( full->outside ) error = "point outside the bounding box";
+
+    if( !error && !f->arc ) {
+        th = f->angle/(double) ARC_DEGREE*M_PI/180;
+        for(INT y=-r;y<=r && !error;y++) {
+            for(INT x=-r;x<=r && !error;x++) {
+                k = verifygridget(full,x,y);
+                if( !k ) continue;
+                if( k > 1 ) error = "point drawn twice";
+                u = x*cos(th)-y*sin(th);
+                v = -x*sin(th)-y*cos(th);
+                d = verifydist(f->rx,f->ry,fabs(u),fabs(v));
+                if( d > alg->maxdist ) alg->maxdist = d;
+                if( d > VERIFY_MAXDIST ) error = "point too far from the ellipse";
+                nb = 0;
+                for(INT j=-1;j<=1;j++)
+                    for(INT i=-1;i<=1;i++)
+                        if( (i || j) && verifygridget(full,x+i,y+j) ) nb++;
+                // Unless the tips are sharper than a pixel (the radius of
+                // curvature there is min(rx,ry)^2/max(rx,ry))
+                if( nb < 2 && (LONG64) f->rx*f->rx >= f->ry && (LONG64) f->ry*f->ry >= f->rx &&
+                    f->rx > 0 && f->ry > 0 )
+                    error = "gap in the contour";
+            }
+        }
+        // Connected: flood from one point, marking the cells with 2
+        stack = (INT *) malloc(2*sizeof(INT)*(full->count+1));
+        reached = 0;
+        if( stack && full->count > 0 && !error ) {
+            int sp = 0;
+            for(INT y=-r;y<=r && !sp;y++)
+                for(INT x=-r;x<=r && !sp;x++)
+                    if( verifygridget(full,x,y) == 1 ) {
+                        stack[0] = x; stack[1] = y; sp = 1;
+                        full->cell[(LONG64) (y+r)*full->size+(x+r)] = 2;
+                    }
+            while( sp > 0 ) {
+                INT x = stack[2*sp-2], y = stack[2*sp-1];
+                sp--;
+                reached++;
+                for(INT j=-1;j<=1;j++)
+                    for(INT i=-1;i<=1;i++)
+                        if( verifygridget(full,x+i,y+j) == 1 ) {
+                            full->cell[(LONG64) (y+j+r)*full->size+(x+i+r)] = 2;
+                            stack[2*sp] = x+i; stack[2*sp+1] = y+j; sp++;
+                        }
+            }
+            if( reached != (LONG64) full->count ) error = "contour not connected";
+        }
+        free(stack);
+    }
+    alg->ellipses++;
+    alg->points += full->count;
+
+    // Fill: the rows of the contour, from the leftmost to the rightmost point
+    if( !error && !f->arc ) {
+        verifydrawfigure(part,f,MARK_FILL);
+        for(INT y=-r;y<=r && !error;y++) {
+            x1 = r+1;
+            x2 = -r-1;
+            for(INT x=-r;x<=r;x++) {
+                if( verifygridget(full,x,y) ) {
+                    if( x < x1 ) x1 = x;
+                    x2 = x;
+                }
+            }
+            for(INT x=-r;x<=r;x++) {
+                k = verifygridget(part,x,y);
+                if( k > 1 ) error = "pixel filled twice";
+                else if( k != (x >= x1 && x <= x2) ) error = "fill differs from the contour";
+            }
+        }
+    }
+
+    // Arcs: compare with the full figure, in both modes
+    if( !error && f->arc ) {
+        for(int m=0;m<2 && !error;m++) {
+            f->arc = 0;
+            verifydrawfigure(full,f,m ? MARK_FILL : MARK_CONTOUR);
+            f->arc = 1;
+            verifydrawfigure(part,f,m ? MARK_FILL : MARK_CONTOUR);
+            for(INT y=-r;y<=r && !error;y++) {
+                for(INT x=-r;x<=r && !error;x++) {
+                    k = verifygridget(part,x,y);
+                    if( k > 1 ) error = "arc pixel drawn twice";
+                    if( k && !verifygridget(full,x,y) ) error = "arc pixel not in the figure";
+                    if( !verifygridget(full,x,y) ) continue;
+                    in = verifysector(f,x,y);
+                    if( in > 0 && !k ) error = m ? "pie pixel missing" : "arc point missing";
+                    if( in < 0 && k )  error = m ? "pie pixel outside the sector" : "arc point outside the sector";
+                }
+            }
+        }
+    }
+
+    if( error ) {
+        if( alg->failures < VERIFY_MAXERRORS )
+            printf("%s: rx=%d ry=%d angle=%d arc=%d (%d,%d): %s\n",alg->name,
+                   (int) f->rx,(int) f->ry,(int) f->angle,f->arc,(int) f->a1,
+                   (int) f->a2,error);
+        alg->failures++;
+    }
+}
+
+
+/**
+ * @brief   Rotated ellipses and arcs: all small radii at several angles and
+ *          random ones up to maxr
+ */
+static void verifyarcs(VerifyAlgType *alg, int kind, int arcs, int n, INT maxr) {
+VerifyGridType full,part;
+VerifyFigureType f;
+
+    if( !verifygridinit(&full,maxr+2) || !verifygridinit(&part,maxr+2) ) {
+        printf("%s: no memory\n",alg->name);
+        alg->failures++;
+        return;
+    }
+    f.kind = kind;
+    f.arc = arcs;
+    for(INT rx=0;rx<=VERIFY_SMALLROT;rx++) {
+        for(INT ry=(kind == 2 ? rx : 0);ry<=(kind == 2 ? rx : VERIFY_SMALLROT);ry++) {
+            for(INT a=0;a<ARC_FULL;a+=(kind == 0 ? 15 : 90)*ARC_DEGREE+(kind == 0 ? 7 : 0)) {
+                f.rx = rx;
+                f.ry = ry;
+                f.angle = a;
+                f.a1 = (INT) verifyrandom(ARC_FULL);
+                f.a2 = (INT) verifyrandom(ARC_FULL);
+                f.arc = arcs;
+                verifyfigure(alg,&full,&part,&f);
+            }
+        }
+    }
+    for(int i=0;i<n;i++) {
+        f.rx = (INT) verifyrandom(maxr)+1;
+        f.ry = (kind == 2) ? f.rx : (INT) verifyrandom(maxr)+1;
+        f.angle = (INT) verifyrandom(ARC_FULL);
+        f.a1 = (INT) verifyrandom(ARC_FULL);
+        f.a2 = (INT) verifyrandom(ARC_FULL);
+        f.arc = arcs;
+        verifyfigure(alg,&full,&part,&f);
+    }
+    free(full.cell);
+    free(part.cell);
+}
+
+
+/**
+ * @brief   Points of a path (curve or polyline), in the order they are sent
+ */
+typedef struct {
+    INT            *x,*y;
+    LONG64          n,size;
+    LONG64          runpoints;          // Points sent as runs
+} VerifyPathType;
+
+static void verifypathpoint(DrawContextType *ctx, INT x, INT y) {
+VerifyPathType *p = (VerifyPathType *) ctx->user;
+
+    if( p->n == p->size ) {
+        p->size = p->size ? 2*p->size : 1024;
+        p->x = (INT *) realloc(p->x,p->size*sizeof(INT));
+        p->y = (INT *) realloc(p->y,p->size*sizeof(INT));
+        if( !p->x || !p->y ) exit(2);
+    }
+    p->x[p->n] = x;
+    p->y[p->n] = y;
+    p->n++;
+}
+
+static void verifypathhrun(DrawContextType *ctx, INT x1, INT x2, INT y) {
+VerifyPathType *p = (VerifyPathType *) ctx->user;
+
+    (void) y;
+    p->runpoints += (LONG64) x2-x1+1;
+}
+
+static void verifypathvrun(DrawContextType *ctx, INT x, INT y1, INT y2) {
+VerifyPathType *p = (VerifyPathType *) ctx->user;
+
+    (void) x;
+    p->runpoints += (LONG64) y2-y1+1;
+}
+
+static void verifypathcontext(DrawContextType *ctx, VerifyPathType *p) {
+
+    MarkContextInit(ctx,0);
+    ctx->point = verifypathpoint;
+    ctx->hrun = verifypathhrun;
+    ctx->vrun = verifypathvrun;
+    ctx->user = p;
+    p->n = 0;
+    p->runpoints = 0;
+}
+
+
+/**
+ * @brief   Point of a Bézier curve (degree 2 or 3) at t
+ */
+static void verifybezier(const INT *px, const INT *py, int degree, double t,
+                         double *x, double *y) {
+double u = 1-t;
+
+    if( degree == 2 ) {
+        *x = u*u*px[0] + 2*u*t*px[1] + t*t*px[2];
+        *y = u*u*py[0] + 2*u*t*py[1] + t*t*py[2];
+    } else {
+        *x = u*u*u*px[0] + 3*u*u*t*px[1] + 3*u*t*t*px[2] + t*t*t*px[3];
+        *y = u*u*u*py[0] + 3*u*u*t*py[1] + 3*u*t*t*py[2] + t*t*t*py[3];
+    }
+}
+
+
+/**
+ * @brief   Check a path: it goes from (x1,y1) to (x2,y2), 8-connected and
+ *          without repeated points
+ */
+static const char *verifypath(VerifyPathType *p, INT x1, INT y1, INT x2, INT y2) {
+
+    if( p->n == 0 ) return "no points";
+    if( p->x[0] != x1 || p->y[0] != y1 ) return "wrong first point";
+    if( p->x[p->n-1] != x2 || p->y[p->n-1] != y2 ) return "wrong last point";
+    for(LONG64 i=1;i<p->n;i++) {
+        if( p->x[i] == p->x[i-1] && p->y[i] == p->y[i-1] ) return "point repeated";
+        if( abs(p->x[i]-p->x[i-1]) > 1 || abs(p->y[i]-p->y[i-1]) > 1 ) return "gap in the path";
+    }
+    return 0;
+}
+
+
+/**
+ * @brief   Check a Bézier curve. Also, each point must be near the curve
+ *
+ * @note    The curve is sampled densely. Since the points are in order, the
+ *          samples matched to the points must not go back: each point takes
+ *          the earliest sample near it, from the one of the previous point
+ *          (a curve can pass twice by the same pixel)
+ */
+static void verifycurve(VerifyAlgType *alg, VerifyPathType *p, const INT *px,
+                        const INT *py, int degree) {
+DrawContextType ctx;
+const char *error;
+double len,x,y,d,best;
+LONG64 m,j,k;
+
+    verifypathcontext(&ctx,p);
+    if( degree == 2 )
+        drawquadbezierctx(&ctx,px[0],py[0],px[1],py[1],px[2],py[2]);
+    else
+        drawcubicbezierctx(&ctx,px[0],py[0],px[1],py[1],px[2],py[2],px[3],py[3]);
+    alg->ellipses++;
+    alg->points += p->n;
+
+    error = verifypath(p,px[0],py[0],px[degree],py[degree]);
+    if( !error ) {
+        len = 0;
+        for(int i=0;i<degree;i++) len += hypot(px[i+1]-px[i],py[i+1]-py[i]);
+        m = (LONG64) (8*len)+8;
+        j = 0;
+        for(LONG64 i=0;i<p->n && !error;i++) {
+            // Earliest sample near the point, then the nearest one around it
+            for(k=j;k<=m;k++) {
+                verifybezier(px,py,degree,(double) k/m,&x,&y);
+                if( hypot(x-p->x[i],y-p->y[i]) <= VERIFY_MAXDIST ) break;
+            }
+            if( k > m ) {
+                error = "point too far from the curve";
+                break;
+            }
+            j = k;
+            best = HUGE_VAL;
+            for(;k<=m;k++) {
+                verifybezier(px,py,degree,(double) k/m,&x,&y);
+                d = hypot(x-p->x[i],y-p->y[i]);
+                if( d > VERIFY_MAXDIST+1 ) break;
+                if( d < best ) best = d;
+            }
+            // The curve can come back nearer later
+            for(k=0;k<=m && best > 0.75;k++) {
+                verifybezier(px,py,degree,(double) k/m,&x,&y);
+                d = hypot(x-p->x[i],y-p->y[i]);
+                if( d < best ) best = d;
+            }
+            if( best > alg->maxdist ) alg->maxdist = best;
+        }
+    }
+    if( error ) {
+        if( alg->failures < VERIFY_MAXERRORS ) {
+            printf("%s: degree=%d",alg->name,degree);
+            for(int i=0;i<=degree;i++) printf(" (%d,%d)",(int) px[i],(int) py[i]);
+            printf(": %s\n",error);
+        }
+        alg->failures++;
+    }
+}
+
+
+/**
+ * @brief   Check a polyline (or a polygon): the points of each segment are
+ *          the ones of drawlinebctx, in order, and the joints are sent once
+ */
+static void verifypolyline(VerifyAlgType *alg, VerifyPathType *p, VerifyPathType *q,
+                           const INT *px, const INT *py, int n, int closed) {
+DrawContextType ctx,lctx;
+const char *error = 0;
+LONG64 k,count,len;
+int segs = closed ? n : n-1;
+
+    verifypathcontext(&ctx,p);
+    if( closed )
+        drawpolygonctx(&ctx,px,py,n);
+    else
+        drawpolylinectx(&ctx,px,py,n);
+    alg->ellipses++;
+    alg->points += p->n;
+
+    count = (closed && n > 1) ? 0 : 1;
+    for(int i=0;i<segs;i++) {
+        int i2 = (i+1)%n;
+        len = abs(px[i2]-px[i]) > abs(py[i2]-py[i]) ? abs(px[i2]-px[i]) : abs(py[i2]-py[i]);
+        count += len;
+    }
+    if( p->n != count ) error = "wrong number of points";
+
+    // Each segment against drawlinebctx (same points, maybe reversed)
+    k = (closed && n > 1) ? 0 : 1;
+    for(int i=0;i<segs && !error;i++) {
+        int i2 = (i+1)%n;
+        verifypathcontext(&lctx,q);
+        drawlinebctx(&lctx,px[i],py[i],px[i2],py[i2]);
+        if( q->n > 1 && (q->x[0] != px[i] || q->y[0] != py[i]) ) {
+            for(LONG64 a=0,b=q->n-1;a<b;a++,b--) {
+                INT t = q->x[a]; q->x[a] = q->x[b]; q->x[b] = t;
+                t = q->y[a]; q->y[a] = q->y[b]; q->y[b] = t;
+            }
+        }
+        for(LONG64 j=1;j<q->n && !error;j++,k++)
+            if( k >= p->n || p->x[k] != q->x[j] || p->y[k] != q->y[j] )
+                error = "segment differs from drawlinebctx";
+    }
+    if( !error && !closed ) error = verifypath(p,px[0],py[0],px[n-1],py[n-1]);
+
+    // Same number of points as runs
+    if( !error ) {
+        verifypathcontext(&ctx,p);
+        ctx.linemode = MARK_LINE_RUNS;
+        if( closed )
+            drawpolygonctx(&ctx,px,py,n);
+        else
+            drawpolylinectx(&ctx,px,py,n);
+        if( p->runpoints != count ) error = "wrong number of points in runs";
+    }
+    if( error ) {
+        if( alg->failures < VERIFY_MAXERRORS ) {
+            printf("%s: n=%d closed=%d",alg->name,n,closed);
+            for(int i=0;i<n && i<8;i++) printf(" (%d,%d)",(int) px[i],(int) py[i]);
+            printf(": %s\n",error);
+        }
+        alg->failures++;
+    }
+}
+
+
+/**
+ * @brief   Curves and polylines: small ones with all control points in a
+ *          small box, and random ones up to maxc
+ */
+static void verifycurves(VerifyAlgType *alg, int polylines, int n, INT maxc) {
+VerifyPathType p = { 0 }, q = { 0 };
+INT px[VERIFY_MAXVERTICES],py[VERIFY_MAXVERTICES];
+INT size;
+int m;
+
+    for(int i=0;i<VERIFY_SMALLCURVES+n;i++) {
+        size = (i < VERIFY_SMALLCURVES) ? 8 : maxc;
+        m = polylines ? (int) verifyrandom(VERIFY_MAXVERTICES)+1 : 3+(i&1);
+        for(int j=0;j<m;j++) {
+            px[j] = (INT) verifyrandom(2*size+1)-size;
+            py[j] = (INT) verifyrandom(2*size+1)-size;
+        }
+        if( polylines )
+            verifypolyline(alg,&p,&q,px,py,m,i&1);
+        else
+            verifycurve(alg,&p,px,py,m-1);
+    }
+    free(p.x);
+    free(p.y);
+    free(q.x);
+    free(q.y);
+}
+
+
+/**
+ * @brief   Exact test of a pixel center against a polygon (same rules as
+ *          fillpolygonctx: the crossings xa <= x count)
+ */
+static int verifyinpolygon(const INT *px, const INT *py, int n,
+                           CurveFillRuleType rule, INT x, INT y) {
+LONG64 xa,ya,dx,dy;
+int w = 0, dir;
+
+    for(int i=0;i<n;i++) {
+        int j = (i+1)%n;
+        if( py[i] == py[j] ) continue;
+        dir = (py[i] < py[j]) ? 1 : -1;
+        xa = (dir > 0) ? px[i] : px[j];
+        ya = (dir > 0) ? py[i] : py[j];
+        dx = (LONG64) ((dir > 0) ? px[j] : px[i]) - xa;
+        dy = (LONG64) ((dir > 0) ? py[j] : py[i]) - ya;
+        if( y < ya || y >= ya+dy ) continue;
+        if( (x-xa)*dy >= (y-ya)*dx ) w += (rule == CURVE_EVENODD) ? 1 : dir;
+    }
+    return (rule == CURVE_EVENODD) ? (w & 1) : (w != 0);
+}
+
+
+/**
+ * @brief   Filled polygons against the exact test, with both rules and
+ *          sometimes a clipping window. Each pixel once
+ */
+static void verifypolygons(VerifyCheckType *check, int n) {
+INT maxc = VERIFY_MAXPOLYGON;
+VerifyGridType g;
+DrawContextType ctx;
+INT px[VERIFY_MAXVERTICES],py[VERIFY_MAXVERTICES];
+INT size,cx1,cy1,cx2,cy2;
+CurveFillRuleType rule;
+const char *error;
+int m,in,clipped;
+
+    if( !verifygridinit(&g,maxc+1) ) {
+        printf("%s: no memory\n",check->name);
+        check->failures++;
+        return;
+    }
+    for(int i=0;i<VERIFY_SMALLCURVES+n;i++) {
+        size = (i < VERIFY_SMALLCURVES) ? 8 : maxc;
+        m = (int) verifyrandom(VERIFY_MAXVERTICES-2)+3;
+        for(int j=0;j<m;j++) {
+            px[j] = (INT) verifyrandom(2*size+1)-size;
+            py[j] = (INT) verifyrandom(2*size+1)-size;
+        }
+        rule = (i & 1) ? CURVE_NONZERO : CURVE_EVENODD;
+        clipped = (i & 2) != 0;
+        cx1 = (INT) verifyrandom(size+1)-size;
+        cy1 = (INT) verifyrandom(size+1)-size;
+        cx2 = (INT) verifyrandom(size+1);
+        cy2 = (INT) verifyrandom(size+1);
+
+        verifygridclear(&g);
+        MarkContextInit(&ctx,0);
+        ctx.point = verifygridpoint;
+        ctx.hrun = verifygridhrun;
+        ctx.user = &g;
+        if( clipped ) MarkContextSetClip(&ctx,cx1,cy1,cx2,cy2);
+        fillpolygonctx(&ctx,px,py,m,rule);
+        check->figures++;
+        check->total += g.count;
+
+        error = g.outside ? "pixel outside the bounding box" : 0;
+        for(INT y=-size-1;y<=size+1 && !error;y++) {
+            for(INT x=-size-1;x<=size+1 && !error;x++) {
+                in = verifyinpolygon(px,py,m,rule,x,y);
+                if( clipped && (x < cx1 || x > cx2 || y < cy1 || y > cy2) ) in = 0;
+                if( verifygridget(&g,x,y) > 1 ) error = "pixel filled twice";
+                else if( verifygridget(&g,x,y) != in ) error = in ? "pixel missing" : "pixel outside the polygon";
+            }
+        }
+        if( error ) {
+            if( check->failures < VERIFY_MAXERRORS ) {
+                printf("%s: n=%d rule=%d clipped=%d",check->name,m,(int) rule,clipped);
+                for(int j=0;j<m && j<8;j++) printf(" (%d,%d)",(int) px[j],(int) py[j]);
+                printf(": %s\n",error);
+            }
+            check->failures++;
+        }
+    }
+    free(g.cell);
+}
+
+
+/**
+ * @brief   Consumer of a motion stream: follows the pen on a grid
+ */
+typedef struct {
+    MotionType     *m;
+    VerifyGridType *g;
+    INT             x,y;
+    int             pen;
+    int             pendowns;
+    int             outside;
+} VerifyMotionType;
+
+static void verifymotionmark(VerifyMotionType *c) {
+VerifyGridType *g = c->g;
+
+    if( c->x < -g->r || c->x > g->r || c->y < -g->r || c->y > g->r ) {
+        c->outside = 1;
+        return;
+    }
+    if( g->cell[(LONG64) (c->y+g->r)*g->size+(c->x+g->r)] < 255 )
+        g->cell[(LONG64) (c->y+g->r)*g->size+(c->x+g->r)]++;
+}
+
+static void *verifymotionconsumer(void *arg) {
+VerifyMotionType *c = (VerifyMotionType *) arg;
+unsigned char buf[8];
+size_t got;
+int dx,dy,n;
+
+    while( (got = MotionRead(c->m,buf,sizeof(buf),1)) > 0 ) {
+        for(size_t i=0;i<got;i++) {
+            switch( MotionDecode(buf[i],&dx,&dy,&n) ) {
+            case MOTION_PENUP:
+                c->pen = 0;
+                break;
+            case MOTION_PENDOWN:
+                c->pen = 1;
+                c->pendowns++;
+                verifymotionmark(c);
+                break;
+            case MOTION_STEP:
+                for(int k=0;k<n;k++) {
+                    c->x += dx;
+                    c->y += dy;
+                    if( c->pen ) verifymotionmark(c);
+                }
+                break;
+            }
+        }
+    }
+    return 0;
+}
+
+
+/**
+ * @brief   Check the circles and ellipses of a motion stream (path order)
+ *
+ * @note    The pixels rebuilt from the steps (read by another thread from a
+ *          small ring) must be the ones of the figure in mirror order, each
+ *          one once, drawn with a single pen down (unless clipped). Bresenham
+ *          and midpoint routines are used in turn
+ */
+static void verifymotion(VerifyCheckType *check, int n) {
+INT maxr = VERIFY_MAXROT;
+VerifyGridType g,ref;
+VerifyMotionType c;
+MotionType m;
+MarkPointType *quad;
+DrawContextType ctx;
+unsigned char ring[16];
+pthread_t thread;
+INT rx,ry,cx1,cy1,cx2,cy2;
+const char *error;
+int circle,total,mid,clipped;
+
+    quad = (MarkPointType *) malloc((size_t) (2*maxr+2)*sizeof(*quad));
+    if( !quad || !verifygridinit(&g,maxr+1) || !verifygridinit(&ref,maxr+1) ) {
+        printf("%s: no memory\n",check->name);
+        check->failures++;
+        return;
+    }
+    total = (VERIFY_SMALL+1)+(VERIFY_SMALLROT+1)*(VERIFY_SMALLROT+1)+n;
+    for(int i=0;i<total;i++) {
+        circle = i <= VERIFY_SMALL;
+        if( circle ) {
+            rx = ry = i;
+        } else if( i-(VERIFY_SMALL+1) < (VERIFY_SMALLROT+1)*(VERIFY_SMALLROT+1) ) {
+            rx = (i-(VERIFY_SMALL+1)) % (VERIFY_SMALLROT+1);
+            ry = (i-(VERIFY_SMALL+1)) / (VERIFY_SMALLROT+1);
+        } else {
+            rx = (INT) verifyrandom(maxr+1);
+            ry = (INT) verifyrandom(maxr+1);
+        }
+        mid = i & 1;
+        clipped = (i & 6) == 6;
+        cx1 = (INT) verifyrandom(rx+1)-rx;
+        cy1 = (INT) verifyrandom(ry+1)-ry;
+        cx2 = (INT) verifyrandom(rx+1);
+        cy2 = (INT) verifyrandom(ry+1);
+        for(INT y=-ry-1;y<=ry+1;y++)
+            for(INT x=-rx-1;x<=rx+1;x++) {
+                g.cell[(LONG64) (y+g.r)*g.size+(x+g.r)] = 0;
+                ref.cell[(LONG64) (y+ref.r)*ref.size+(x+ref.r)] = 0;
+            }
+
+        MarkContextInit(&ctx,0);
+        ctx.point = verifygridpoint;
+        ctx.user = &ref;
+        if( clipped ) MarkContextSetClip(&ctx,cx1,cy1,cx2,cy2);
+        if( circle )
+            mid ? drawcirclemctx(&ctx,0,0,rx) : drawcirclebctx(&ctx,0,0,rx);
+        else
+            mid ? drawellipsemctx(&ctx,0,0,rx,ry) : drawellipsebctx(&ctx,0,0,rx,ry);
+
+        MotionInit(&m,ring,sizeof(ring),quad,(size_t) (2*maxr+2));
+        c = (VerifyMotionType) { &m, &g, 0, 0, 0, 0, 0 };
+        if( pthread_create(&thread,0,verifymotionconsumer,&c) != 0 ) {
+            printf("%s: no thread\n",check->name);
+            check->failures++;
+            break;
+        }
+        MotionContextInit(&ctx,&m);
+        if( clipped ) MarkContextSetClip(&ctx,cx1,cy1,cx2,cy2);
+        if( circle )
+            mid ? drawcirclemctx(&ctx,0,0,rx) : drawcirclebctx(&ctx,0,0,rx);
+        else
+            mid ? drawellipsemctx(&ctx,0,0,rx,ry) : drawellipsebctx(&ctx,0,0,rx,ry);
+        MotionClose(&m);
+        pthread_join(thread,0);
+        MotionDestroy(&m);
+        check->figures++;
+        check->total += m.steps+1;
+
+        error = c.outside ? "step outside the figure" : 0;
+        // Thin tips are spikes (walked once), so the path jumps back
+        if( !error && !clipped && c.pendowns != 1 &&
+            (((LONG64) rx*rx >= ry && (LONG64) ry*ry >= rx) || c.pendowns > 3) )
+            error = "not continuous";
+        for(INT y=-ry-1;y<=ry+1 && !error;y++)
+            for(INT x=-rx-1;x<=rx+1 && !error;x++)
+                if( verifygridget(&g,x,y) != verifygridget(&ref,x,y) )
+                    error = verifygridget(&g,x,y) > verifygridget(&ref,x,y) ?
+                            "pixel not in the figure or repeated" : "pixel missing";
+        if( error ) {
+            if( check->failures < VERIFY_MAXERRORS )
+                printf("%s: %s rx=%d ry=%d clipped=%d pendowns=%d: %s\n",check->name,
+                       mid ? "midpoint" : "bresenham",(int) rx,(int) ry,clipped,
+                       c.pendowns,error);
+            check->failures++;
+        }
+    }
+    free(ref.cell);
+    free(g.cell);
+    free(quad);
+}
+
+
+/**
+ * @brief   Check the changed rows recorded by a screen
+ *
+ * @note    Random figures (also the batch and antialiased routines) are drawn
+ *          on a tracked PBM or PGM screen. Each changed pixel must be inside
+ *          the span of its row and the rectangles and the band must cover
+ *          the spans. Some figures are rendered from a display list by
+ *          several threads, each one tracking the rows of its bands
+ */
+#define VERIFY_DIRTYSIZE    256
+
+static void verifydirty(VerifyCheckType *check, int n) {
+ScreenType *screen;
+DrawContextType ctx;
+DisplayListType *dl;
+ScreenRectType rects[4];
+unsigned char *copy;
+INT a[4][4],size,wb,band,y0,x1,x2,first,last;
+const char *error;
+FILE *f;
+long bytes;
+int nrects,covered,kind;
+
+    size = VERIFY_DIRTYSIZE;
+    for(int i=0;i<n;i++) {
+        ImageFormatType fmt = (i & 1) ? PGM : PBM;
+
+        screen = ScreenCreateFormat(size,size,fmt);
+        copy = (unsigned char *) malloc((size_t) size*size);
+        if( !screen || !copy || !ScreenTrackDirty(screen,1) ) {
+            printf("%s: no memory\n",check->name);
+            check->failures++;
+            if( screen ) ScreenDestroy(screen);
+            free(copy);
+            return;
+        }
+        wb = screen->wbytes;
+        for(int j=0;j<4;j++)
+            for(int k=0;k<4;k++)
+                a[j][k] = (INT) verifyrandom(size+size/2)-size/4;
+        MarkContextInit(&ctx,screen);
+        drawcirclebctx(&ctx,a[0][0],a[0][1],a[0][2]/4);
+        ScreenClearDirty(screen);
+        memcpy(copy,screen->data,(size_t) wb*size);
+
+        kind = (int) verifyrandom(9);
+        ctx.drawmode = (i & 2) ? MARK_FILL : MARK_CONTOUR;
+        switch(kind) {
+        case 0: drawlinebctx(&ctx,a[1][0],a[1][1],a[1][2],a[1][3]);                 break;
+        case 1: drawcirclebctx(&ctx,a[1][0],a[1][1],a[1][2]/2);                     break;
+        case 2: drawellipsebctx(&ctx,a[1][0],a[1][1],a[1][2]/2,a[1][3]/3);          break;
+        case 3: drawlinesbctx(&ctx,a[1],a[2],a[3],a[0],4);                          break;
+        case 4: drawcirclesbctx(&ctx,a[1],a[2],a[3],4);                             break;
+        case 5: fillpolygonctx(&ctx,a[1],a[2],4,CURVE_NONZERO);                     break;
+        case 6: drawellipsewctx(&ctx,a[1][0],a[1][1],a[1][2]/2,a[1][3]/3);          break;
+        case 7:
+            dl = DisplayListCreate();
+            if( !dl ) break;
+            DisplayListSetDrawMode(dl,ctx.drawmode);
+            for(int j=0;j<4;j++) {
+                DisplayListLine(dl,a[j][0],a[j][1],a[j][2],a[j][3]);
+                DisplayListCircle(dl,a[j][1],a[j][2],a[j][3]/4);
+                DisplayListEllipse(dl,a[j][2],a[j][3],a[j][0]/3,a[j][1]/5);
+            }
+            DisplayListRender(dl,screen,8);
+            DisplayListDestroy(dl);
+            break;
+        default:
+            ScreenBlit(screen,a[1][0],a[1][1],screen,a[1][2],a[1][3],a[2][0],a[2][1],SCREEN_XOR);
+            break;
+        }
+        check->figures++;
+
+        error = 0;
+        first = size;
+        last = -1;
+        for(INT y=0;y<size && !error;y++) {
+            x1 = screen->dirty->x1[y];
+            x2 = screen->dirty->x2[y];
+            if( x1 <= x2 ) {
+                if( first == size ) first = y;
+                last = y;
+            }
+            for(INT x=0;x<size && !error;x++) {
+                int changed = fmt == PBM ?
+                    ((screen->data[y*wb+(x>>3)] ^ copy[y*wb+(x>>3)]) & (0x80>>(x&7))) != 0 :
+                    screen->data[y*wb+x] != copy[y*wb+x];
+                if( !changed ) continue;
+                check->total++;
+                if( x < x1 || x > x2 ) error = "changed pixel outside the span of its row";
+                covered = 0;
+                nrects = ScreenDirtyRects(screen,rects,4);
+                for(int r=0;r<nrects;r++)
+                    if( x >= rects[r].x1 && x <= rects[r].x2 && y >= rects[r].y1 && y <= rects[r].y2 )
+                        covered = 1;
+                if( !error && !covered ) error = "changed pixel outside the rectangles";
+            }
+        }
+
+        // The band written is a whole image
+        f = tmpfile();
+        if( !error && f ) {
+            band = ScreenWriteDirty(screen,f,&y0);
+            bytes = ftell(f);
+            if( band != (first <= last ? last-first+1 : 0) || (band > 0 && y0 != first) )
+                error = "wrong band";
+            else if( band > 0 && bytes < (long) band*wb ) error = "band not written";
+            else if( band == 0 && bytes != 0 ) error = "clean screen written";
+        }
+        if( f ) fclose(f);
+        ScreenClearDirty(screen);
+        if( !error && ScreenDirtyRects(screen,rects,4) != 0 ) error = "not clean after clear";
+
+        if( error ) {
+            if( check->failures < VERIFY_MAXERRORS )
+                printf("%s: %s kind=%d mode=%d: %s\n",check->name,fmt == PBM ? "pbm" : "pgm",
+                       kind,(int) ctx.drawmode,error);
+            check->failures++;
+        }
+        ScreenDestroy(screen);
+        free(copy);
+    }
+}
+
+
+/**
+ * @brief   Check the screens stored in a file
+ *
+ * @note    The same figures are drawn on a mapped screen and an allocated
+ *          one. The file must hold the raster of the allocated screen after
+ *          the header, and must be opened again as it is. A canvas of
+ *          another size and a file of something else must be refused and
+ *          left as they are. A raster over INT_MAX bytes must be refused
+ *          unless INT is as wide as size_t
+ */
+#define VERIFY_MAPPEDSIZE   300
+
+static void verifymapped(VerifyCheckType *check, int n) {
+ScreenType *screen,*mapped;
+DrawContextType ctx,mctx;
+char path[] = "/tmp/verifyXXXXXX";
+INT a[4],size,rasterbytes;
+unsigned char *file;
+const char *error = 0;
+long bytes;
+FILE *f;
+int fd;
+
+    size = VERIFY_MAPPEDSIZE;
+    fd = mkstemp(path);
+    if( fd < 0 ) {
+        printf("%s: no temporary file\n",check->name);
+        check->failures++;
+        return;
+    }
+    close(fd);
+
+    screen = ScreenCreate(size+3,size);
+    mapped = ScreenCreateMapped(path,size+3,size);
+    if( !screen || !mapped ) error = "not created";
+    rasterbytes = screen ? screen->wbytes*size : 0;
+    if( !error ) {
+        MarkContextInit(&ctx,screen);
+        MarkContextInit(&mctx,mapped);
+        for(int i=0;i<n;i++) {
+            for(int k=0;k<4;k++) a[k] = (INT) verifyrandom(size+size/2)-size/4;
+            ctx.drawmode = mctx.drawmode = (i & 1) ? MARK_FILL : MARK_CONTOUR;
+            drawlinebctx(&ctx,a[0],a[1],a[2],a[3]);
+            drawlinebctx(&mctx,a[0],a[1],a[2],a[3]);
+            drawellipsebctx(&ctx,a[1],a[2],a[3]/2,a[0]/3);
+            drawellipsebctx(&mctx,a[1],a[2],a[3]/2,a[0]/3);
+            check->figures++;
+        }
+        if( memcmp(screen->data,mapped->data,rasterbytes) != 0 ) error = "different pixels";
+    }
+    ScreenDestroy(mapped);
+
+    // The file is a P4 image of the same pixels
+    file = (unsigned char *) malloc(rasterbytes);
+    f = fopen(path,"rb");
+    if( !error && (!file || !f) ) error = "file not read";
+    if( !error ) {
+        fseek(f,0,SEEK_END);
+        bytes = ftell(f);
+        if( bytes < rasterbytes ) {
+            error = "file too short";
+        } else {
+            fseek(f,bytes-rasterbytes,SEEK_SET);
+            if( fread(file,1,rasterbytes,f) != (size_t) rasterbytes ||
+                memcmp(file,screen->data,rasterbytes) != 0 )
+                error = "file raster different";
+            fseek(f,0,SEEK_SET);
+            if( !error && (fgetc(f) != 'P' || fgetc(f) != '4') ) error = "not a P4 file";
+        }
+    }
+    if( f ) fclose(f);
+    check->total += rasterbytes;
+
+    // Opened again as it is
+    if( !error ) {
+        mapped = ScreenCreateMapped(path,size+3,size);
+        if( !mapped || memcmp(screen->data,mapped->data,rasterbytes) != 0 )
+            error = "not opened again";
+        if( mapped ) ScreenDestroy(mapped);
+    }
+
+    // Another canvas, or another file, is not replaced
+    if( !error ) {
+        struct stat st[2];
+
+        if( stat(path,&st[0]) != 0 ) error = "file lost";
+        mapped = error ? 0 : ScreenCreateMapped(path,size,size+3);
+        if( mapped ) {
+            error = "canvas of another size replaced";
+            ScreenDestroy(mapped);
+        } else if( !error && (stat(path,&st[1]) != 0 || st[1].st_size != st[0].st_size) ) {
+            error = "canvas of another size changed";
+        }
+    }
+    if( !error ) {
+        f = fopen(path,"wb");
+        if( !f || fputs("not a canvas\n",f) < 0 ) error = "file not written";
+        if( f ) fclose(f);
+        mapped = error ? 0 : ScreenCreateMapped(path,size+3,size);
+        if( mapped ) {
+            error = "other file replaced";
+            ScreenDestroy(mapped);
+        }
+        f = fopen(path,"rb");
+        if( !error && (!f || fread(file,1,13,f) != 13 || memcmp(file,"not a canvas\n",13) != 0) )
+            error = "other file changed";
+        if( f ) fclose(f);
+    }
+
+    // A raster that INT offsets cannot address is refused
+    if( !error && sizeof(INT) < sizeof(size_t) ) {
+        mapped = ScreenCreateMapped(path,200000,200000);
+        if( mapped ) {
+            error = "raster larger than INT offsets mapped";
+            ScreenDestroy(mapped);
+        }
+    }
+
+    if( error ) {
+        printf("%s: %s\n",check->name,error);
+        check->failures++;
+    }
+    if( screen ) ScreenDestroy(screen);
+    free(file);
+    unlink(path);
+}
+
+
+/**
+ * @brief   Check the sparse screens
+ *
+ * @note    The same figures, fills and blits are applied to a sparse screen
+ *          and to an allocated one. The P4 and P1 files must be the same.
+ *          Display lists are rendered on the sparse screen by several
+ *          threads, whose bands share tiles, and serially on the other one
+ */
+#define VERIFY_SPARSESIZE   200
+
+static long verifyfile(ScreenType *screen, int ascii, unsigned char **bytes) {
+FILE *f;
+long n;
+
+    *bytes = 0;
+    f = tmpfile();
+    if( !f ) return -1;
+    if( ascii )
+        ScreenWritePBM(screen,f);
+    else
+        ScreenWritePBMBinary(screen,f);
+    n = ftell(f);
+    *bytes = (unsigned char *) malloc(n > 0 ? n : 1);
+    rewind(f);
+    if( !*bytes || fread(*bytes,1,n,f) != (size_t) n ) n = -1;
+    fclose(f);
+    return n;
+}
+
+static void verifysparse(VerifyCheckType *check, int n) {
+ScreenType *screen[2],*other;
+DrawContextType ctx[2];
+DisplayListType *dl;
+INT a[4][4],w,h;
+unsigned char *file[2];
+long bytes[2];
+const char *error;
+int kind;
+
+    for(int i=0;i<n;i++) {
+        w = VERIFY_SPARSESIZE+(INT) verifyrandom(70);
+        h = VERIFY_SPARSESIZE+(INT) verifyrandom(70);
+        screen[0] = ScreenCreate(w,h);
+        screen[1] = ScreenCreateSparse(w,h);
+        other = ScreenCreate(w,h);
+        if( !screen[0] || !screen[1] || !other ) {
+            printf("%s: no memory\n",check->name);
+            check->failures++;
+            if( screen[0] ) ScreenDestroy(screen[0]);
+            if( screen[1] ) ScreenDestroy(screen[1]);
+            if( other ) ScreenDestroy(other);
+            return;
+        }
+        MarkContextInit(&ctx[0],other);
+        ctx[0].drawmode = MARK_FILL;
+        drawellipsebctx(&ctx[0],w/2,h/2,w/3,h/4);
+        for(int j=0;j<4;j++)
+            for(int k=0;k<4;k++)
+                a[j][k] = (INT) verifyrandom(w+w/2)-w/4;
+        kind = (int) verifyrandom(11);
+        for(int s=0;s<2;s++) {
+            if( kind == 9 ) ScreenFill(screen[s],0xFF);
+            MarkContextInit(&ctx[s],screen[s]);
+            ctx[s].drawmode = (i & 1) ? MARK_FILL : MARK_CONTOUR;
+            ctx[s].linemode = (i & 2) ? MARK_LINE_RUNS : MARK_LINE_POINTS;
+            drawcirclebctx(&ctx[s],a[0][0],a[0][1],a[0][2]/3);
+            switch(kind) {
+            case 0: drawlinebctx(&ctx[s],a[1][0],a[1][1],a[1][2],a[1][3]);              break;
+            case 1: drawellipsebctx(&ctx[s],a[1][0],a[1][1],a[1][2]/2,a[1][3]/3);       break;
+            case 2: drawlinesbctx(&ctx[s],a[1],a[2],a[3],a[0],4);                       break;
+            case 3: drawcirclesbctx(&ctx[s],a[1],a[2],a[3],4);                          break;
+            case 4: fillpolygonctx(&ctx[s],a[1],a[2],4,CURVE_EVENODD);                  break;
+            case 5: drawellipsewctx(&ctx[s],a[1][0],a[1][1],a[1][2]/2,a[1][3]/3);       break;
+            case 6: ScreenDrawVertLine(screen[s],a[1][0],a[1][1],a[1][2]);              break;
+            case 7:
+                ScreenBlit(screen[s],a[1][0],a[1][1],screen[s],a[1][2],a[1][3],
+                           a[2][0],a[2][1],(ScreenOpType) (i&3));
+                break;
+            case 8: ScreenCombine(screen[s],other,(ScreenOpType) (i&3));                break;
+            case 10:
+                dl = DisplayListCreate();
+                if( !dl ) break;
+                DisplayListSetDrawMode(dl,ctx[s].drawmode);
+                for(int j=0;j<4;j++) {
+                    DisplayListLine(dl,a[j][0],a[j][1],a[j][2],a[j][3]);
+                    DisplayListCircle(dl,a[j][1],a[j][2],abs(a[j][3])/3);
+                    DisplayListEllipse(dl,a[j][2],a[j][3],abs(a[j][0])/2,abs(a[j][1])/4);
+                }
+                DisplayListRender(dl,screen[s],s ? 8 : 1);
+                DisplayListDestroy(dl);
+                break;
+            default: drawcirclebctx(&ctx[s],a[1][0],a[1][1],a[1][2]);                   break;
+            }
+        }
+        ScreenDestroy(other);
+        check->figures++;
+
+        error = 0;
+        for(int ascii=0;ascii<2 && !error;ascii++) {
+            bytes[0] = verifyfile(screen[0],ascii,&file[0]);
+            bytes[1] = verifyfile(screen[1],ascii,&file[1]);
+            if( bytes[0] < 0 || bytes[0] != bytes[1] || memcmp(file[0],file[1],bytes[0]) != 0 )
+                error = ascii ? "different P1 files" : "different P4 files";
+            check->total += bytes[0] > 0 ? bytes[0] : 0;
+            free(file[0]);
+            free(file[1]);
+        }
+        if( !error && ScreenSparseTiles(screen[1]) >
+            (unsigned long) ((w+SCREEN_TILESIZE-1)/SCREEN_TILESIZE)*((h+SCREEN_TILESIZE-1)/SCREEN_TILESIZE) )
+            error = "too many tiles";
+        if( error ) {
+            if( check->failures < VERIFY_MAXERRORS )
+                printf("%s: %dx%d kind=%d mode=%d: %s\n",check->name,w,h,kind,i&3,error);
+            check->failures++;
+        }
+        ScreenDestroy(screen[0]);
+        ScreenDestroy(screen[1]);
+    }
+}
+
+
+/**
+ * @brief   Check the thick lines, circles and ellipses
+ *
+ * @note    The runs are counted in a grid (clipped to a screen), so a pixel
+ *          sent twice is found.
+ *          Lines are compared with their definition (distance and
+ *          projection, for each pixel). Annuli are compared with the outer
+ *          filled curve less the inner one
+ */
+#define VERIFY_STROKESIZE   160
+
+static void verifygridvrun(DrawContextType *ctx, INT x, INT y1, INT y2) {
+
+    for(INT y=y1;y<=y2;y++) verifygridpoint(ctx,x,y);
+}
+
+static void verifygridcontext(DrawContextType *ctx, ScreenType *screen, VerifyGridType *g) {
+
+    MarkContextInit(ctx,screen);
+    ctx->point = verifygridpoint;
+    ctx->hrun = verifygridhrun;
+    ctx->vrun = verifygridvrun;
+    ctx->blend = 0;
+    ctx->user = g;
+    verifygridclear(g);
+}
+
+static void verifystroke(VerifyCheckType *check, int n) {
+ScreenType *screen;
+DrawContextType ctx;
+VerifyGridType g,outer,inner;
+INT size,x1,y1,x2,y2,w,rx,ry;
+LONG64 dx,dy,l2,c,p,expect;
+const char *error;
+int kind,circle,k;
+
+    size = VERIFY_STROKESIZE;
+    screen = ScreenCreate(size,size);
+    g.cell = outer.cell = inner.cell = 0;
+    if( !screen || !verifygridinit(&g,size) || !verifygridinit(&outer,size) ||
+        !verifygridinit(&inner,size) ) {
+        printf("%s: no memory\n",check->name);
+        check->failures++;
+        n = 0;
+    }
+
+    for(int i=0;i<n;i++) {
+        kind = (int) verifyrandom(3);
+        w = 2+(INT) verifyrandom(12);
+        x1 = (INT) verifyrandom(size+2*w)-w;
+        y1 = (INT) verifyrandom(size+2*w)-w;
+        x2 = (INT) verifyrandom(size+2*w)-w;
+        y2 = (INT) verifyrandom(size+2*w)-w;
+        if( i%7 == 0 ) x2 = x1;
+        if( i%11 == 0 ) y2 = y1;
+        rx = (INT) verifyrandom(size/2);
+        ry = kind == 1 ? rx : (INT) verifyrandom(size/2);
+        circle = kind == 1;
+        verifygridcontext(&ctx,screen,&g);
+        ctx.drawmode = (i%5 == 0) ? MARK_FILL : MARK_CONTOUR;
+        if( kind == 0 )
+            drawthicklinectx(&ctx,x1,y1,x2,y2,w);
+        else if( circle )
+            drawthickcirclectx(&ctx,x1,y1,rx,w);
+        else
+            drawthickellipsectx(&ctx,x1,y1,rx,ry,w);
+        check->figures++;
+
+        // Reference
+        if( kind != 0 ) {
+            verifygridcontext(&ctx,screen,&outer);
+            ctx.drawmode = MARK_FILL;
+            if( circle )
+                drawcirclemctx(&ctx,x1,y1,rx+w/2);
+            else
+                drawellipsemctx(&ctx,x1,y1,rx+w/2,ry+w/2);
+            verifygridcontext(&ctx,screen,&inner);
+            ctx.drawmode = MARK_FILL;
+            if( i%5 != 0 && rx-(w-w/2) >= 0 && ry-(w-w/2) >= 0 ) {
+                if( circle )
+                    drawcirclemctx(&ctx,x1,y1,rx-(w-w/2));
+                else
+                    drawellipsemctx(&ctx,x1,y1,rx-(w-w/2),ry-(w-w/2));
+            }
+        }
+        dx = x2-x1;
+        dy = y2-y1;
+        l2 = dx*dx+dy*dy;
+        error = 0;
+        for(INT y=0;y<size && !error;y++) {
+            for(INT x=0;x<size && !error;x++) {
+                k = verifygridget(&g,x,y);
+                if( kind != 0 ) {
+                    expect = verifygridget(&outer,x,y) && !verifygridget(&inner,x,y);
+                } else if( l2 == 0 ) {
+                    expect = x >= x1-(w-1)/2 && x <= x1+w/2 && y >= y1-(w-1)/2 && y <= y1+w/2;
+                } else {
+                    c = (x-x1)*dy-(y-y1)*dx;
+                    p = (x-x1)*dx+(y-y1)*dy;
+                    expect = (c <= 0 || 4*c*c <= w*w*l2) && (c >= 0 || 4*c*c < w*w*l2) &&
+                             p >= 0 && p <= l2;
+                }
+                if( k > 1 ) error = "pixel sent twice";
+                else if( k != expect ) error = expect ? "pixel missing" : "pixel not covered";
+                check->total += k;
+            }
+        }
+        if( error ) {
+            if( check->failures < VERIFY_MAXERRORS )
+                printf("%s: kind=%d (%d,%d) (%d,%d) r=%d,%d w=%d mode=%d: %s\n",check->name,kind,
+                       x1,y1,x2,y2,rx,ry,w,(int) (i%5 == 0),error);
+            check->failures++;
+        }
+    }
+    if( screen ) ScreenDestroy(screen);
+    free(g.cell);
+    free(outer.cell);
+    free(inner.cell);
+}
+
+
+/**
+ * @brief   Check the dashed lines, curves and circles
+ *
+ * @note    The reference is the solid figure, whose points are taken in
+ *          order (no clip) and kept if their bit of the pattern is on, the
+ *          phase going on from one segment to the next. The dashed figure is
+ *          drawn (clipped) on a grid, as points or runs, and on PBM and PGM
+ *          screens with the default sinks. The phase left in the context
+ *          must count all the points, clipped ones too (also for circles and
+ *          arcs, see verifypatterncircle)
+ */
+#define VERIFY_PATTERNSIZE  200
+#define VERIFY_PATTERNORDER 1024
+
+static void verifypatternfigure(DrawContextType *ctx, int kind, const INT *px,
+                                const INT *py, int m) {
+
+    if( kind == 0 )
+        drawpolylinectx(ctx,px,py,m);
+    else if( kind == 1 )
+        drawcubicbezierctx(ctx,px[0],py[0],px[1],py[1],px[2],py[2],px[3],py[3]);
+    else
+        drawcirclebctx(ctx,px[0],py[0],px[1]);
+}
+
+/**
+ * @brief   Dashed circles: a circle whose octant does not fit the buffer of
+ *          the path order is the mirrored one, and the phase after a circle
+ *          (clipped or not, mirrored or in path order) or an arc of it is
+ *          the same
+ */
+#define VERIFY_PATTERNSMALL 20
+
+static const char *verifypatterncircle(VerifyGridType *g, VerifyGridType *h, ScreenType *clip,
+                                       uint64_t pattern, int len, INT xc, INT yc, INT r,
+                                       INT a1, INT a2) {
+DrawContextType ctx;
+MarkPointType order[VERIFY_PATTERNORDER];
+int phase[2];
+
+    // An octant has more than r/2 points
+    if( r >= 2*VERIFY_PATTERNSMALL ) {
+        verifygridcontext(&ctx,clip,g);
+        MarkContextSetPattern(&ctx,pattern,len);
+        drawcirclebctx(&ctx,xc,yc,r);
+        phase[0] = ctx.patternphase;
+        verifygridcontext(&ctx,clip,h);
+        MarkContextSetOrder(&ctx,MARK_ORDER_PATH,order,VERIFY_PATTERNSMALL);
+        MarkContextSetPattern(&ctx,pattern,len);
+        drawcirclebctx(&ctx,xc,yc,r);
+        if( ctx.patternphase != phase[0] ) return "wrong phase after a circle over the buffer";
+        if( memcmp(g->cell,h->cell,(size_t) g->size*g->size) != 0 )
+            return "circle over the buffer not dashed by octants";
+    }
+
+    for(int o=0;o<2;o++) {
+        // Whole circle, then the same one outside the clip, then an arc
+        verifygridcontext(&ctx,clip,g);
+        if( o ) MarkContextSetOrder(&ctx,MARK_ORDER_PATH,order,VERIFY_PATTERNORDER);
+        MarkContextSetPattern(&ctx,pattern,len);
+        drawcirclebctx(&ctx,xc,yc,r);
+        phase[0] = ctx.patternphase;
+        MarkContextSetPattern(&ctx,pattern,len);
+        drawcirclebctx(&ctx,xc+3*clip->w,yc,r);
+        if( ctx.patternphase != phase[0] ) return "wrong phase after a clipped circle";
+        MarkContextSetPattern(&ctx,pattern,len);
+        drawarcctx(&ctx,xc,yc,r,a1,a2);
+        if( ctx.patternphase != phase[0] ) return "wrong phase after an arc";
+    }
+    return 0;
+}
+
+static void verifypattern(VerifyCheckType *check, int n) {
+ScreenType *clip,*screen,*ref;
+DrawContextType ctx;
+VerifyPathType p = { 0 };
+VerifyGridType g,h;
+MarkPointType order[VERIFY_PATTERNORDER];
+INT px[VERIFY_MAXVERTICES],py[VERIFY_MAXVERTICES],size;
+uint64_t pattern;
+const char *error;
+int kind,mode,len,m,k,expect;
+
+    size = VERIFY_PATTERNSIZE;
+    clip = ScreenCreate(size,size);
+    g.cell = h.cell = 0;
+    if( !clip || !verifygridinit(&g,size) || !verifygridinit(&h,size) ) {
+        printf("%s: no memory\n",check->name);
+        check->failures++;
+        n = 0;
+    }
+
+    for(int i=0;i<n;i++) {
+        kind = (int) verifyrandom(3);
+        mode = i&3;
+        len = 1+(int) verifyrandom(MARK_PATTERNMAX);
+        pattern = (uint64_t) verifyrandom(1L<<30) << 34 ^ (uint64_t) verifyrandom(1L<<30) << 4 ^
+                  (uint64_t) verifyrandom(16);
+        m = kind == 0 ? 2+(int) verifyrandom(VERIFY_MAXVERTICES-1) : 4;
+        for(int j=0;j<m;j++) {
+            px[j] = (INT) verifyrandom(size+size/2)-size/4;
+            py[j] = (INT) verifyrandom(size+size/2)-size/4;
+        }
+        if( kind == 2 ) {
+            px[0] = (INT) verifyrandom(size);
+            py[0] = (INT) verifyrandom(size);
+            px[1] = (INT) verifyrandom(size/2);
+        }
+
+        // Solid figure, in order
+        verifypathcontext(&ctx,&p);
+        MarkContextSetOrder(&ctx,MARK_ORDER_PATH,order,VERIFY_PATTERNORDER);
+        verifypatternfigure(&ctx,kind,px,py,m);
+
+        // Dashed figure
+        screen = ref = 0;
+        if( mode < 2 ) {
+            verifygridcontext(&ctx,clip,&g);
+        } else {
+            screen = ScreenCreateFormat(size,size,mode == 2 ? PBM : PGM);
+            ref = ScreenCreateFormat(size,size,mode == 2 ? PBM : PGM);
+            if( !screen || !ref ) exit(2);
+            MarkContextInit(&ctx,screen);
+        }
+        MarkContextSetOrder(&ctx,MARK_ORDER_PATH,order,VERIFY_PATTERNORDER);
+        MarkContextSetPattern(&ctx,pattern,len);
+        if( mode != 0 ) ctx.linemode = MARK_LINE_RUNS;
+        verifypatternfigure(&ctx,kind,px,py,m);
+        check->figures++;
+
+        error = 0;
+        if( ctx.patternphase != (int) (p.n%len) ) error = "wrong phase after the figure";
+        if( mode < 2 ) {
+            // Each pixel on as many times as the reference has it
+            for(LONG64 j=0;j<p.n && !error;j++) {
+                if( !((pattern >> (len-1-j%len)) & 1) ) continue;
+                if( p.x[j] < 0 || p.x[j] >= size || p.y[j] < 0 || p.y[j] >= size ) continue;
+                k = verifygridget(&g,p.x[j],p.y[j]);
+                if( k == 0 ) error = "dash point missing";
+                else g.cell[(LONG64) (p.y[j]+g.r)*g.size+(p.x[j]+g.r)]--;
+            }
+            for(INT y=0;y<size && !error;y++)
+                for(INT x=0;x<size && !error;x++)
+                    if( verifygridget(&g,x,y) ) error = "point of a gap drawn";
+        } else {
+            for(LONG64 j=0;j<p.n;j++) {
+                expect = (int) ((pattern >> (len-1-j%len)) & 1);
+                if( expect ) ScreenDrawPoint(ref,p.x[j],p.y[j]);
+            }
+            if( !error && memcmp(screen->data,ref->data,(size_t) screen->wbytes*size) != 0 )
+                error = "screen differs from the dashed points";
+            ScreenDestroy(screen);
+            ScreenDestroy(ref);
+        }
+        check->total += p.n;
+        if( !error && kind == 2 )
+            error = verifypatterncircle(&g,&h,clip,pattern,len,px[0],py[0],px[1],
+                                        (INT) verifyrandom(ARC_FULL),(INT) verifyrandom(ARC_FULL));
+
+        if( error ) {
+            if( check->failures < VERIFY_MAXERRORS ) {
+                printf("%s: kind=%d mode=%d len=%d",check->name,kind,mode,len);
+                for(int j=0;j<m && j<8;j++) printf(" (%d,%d)",(int) px[j],(int) py[j]);
+                printf(": %s\n",error);
+            }
+            check->failures++;
+        }
+    }
+    if( clip ) ScreenDestroy(clip);
+    free(g.cell);
+    free(h.cell);
+    free(p.x);
+    free(p.y);
+}
+
+
+/**
+ * @brief   Check the circles and ellipses clipped to a small window
+ *
+ * @note    The loops skip the steps whose points miss the window (see
+ *          MarkCurveWindows). The points and runs sent must be the ones of
+ *          the unclipped figure inside the window, in the same order. The
+ *          windows are put on the curve, most of them small
+ */
+#define VERIFY_CLIPMAXR     50000
+#define VERIFY_CLIPSIZE     200
+
+typedef struct {
+    VerifyPathType  p;
+    MarkClipType    w;
+    int             filter;             // Reference: keep what is inside w
+} VerifyWindowType;
+
+static void verifywindowpoint(DrawContextType *ctx, INT x, INT y) {
+VerifyWindowType *v = (VerifyWindowType *) ctx->user;
+
+    if( v->filter && (x < v->w.xmin || x > v->w.xmax || y < v->w.ymin || y > v->w.ymax) )
+        return;
+    ctx->user = &v->p;
+    verifypathpoint(ctx,x,y);
+    ctx->user = v;
+}
+
+// A run is sent as its two ends
+static void verifywindowhrun(DrawContextType *ctx, INT x1, INT x2, INT y) {
+VerifyWindowType *v = (VerifyWindowType *) ctx->user;
+
+    if( v->filter ) {
+        if( y < v->w.ymin || y > v->w.ymax || x2 < v->w.xmin || x1 > v->w.xmax ) return;
+        if( x1 < v->w.xmin ) x1 = v->w.xmin;
+        if( x2 > v->w.xmax ) x2 = v->w.xmax;
+    }
+    ctx->user = &v->p;
+    verifypathpoint(ctx,x1,y);
+    verifypathpoint(ctx,x2,y);
+    ctx->user = v;
+}
+
+static void verifywindowdraw(VerifyWindowType *v, int kind, MarkDrawModeType mode,
+                             INT xc, INT yc, INT rx, INT ry, int filter) {
+DrawContextType ctx;
+
+    MarkContextInit(&ctx,0);
+    ctx.point = verifywindowpoint;
+    ctx.hrun = verifywindowhrun;
+    ctx.vrun = 0;
+    ctx.user = v;
+    ctx.drawmode = mode;
+    if( !filter ) MarkContextSetClip(&ctx,v->w.xmin,v->w.ymin,v->w.xmax,v->w.ymax);
+    v->filter = filter;
+    v->p.n = 0;
+    if( kind == 0 )         drawcirclebctx(&ctx,xc,yc,rx);
+    else if( kind == 1 )    drawcirclemctx(&ctx,xc,yc,rx);
+    else if( kind == 2 )    drawellipsebctx(&ctx,xc,yc,rx,ry);
+    else                    drawellipsemctx(&ctx,xc,yc,rx,ry);
+}
+
+static void verifyclip(VerifyCheckType *check, int n) {
+VerifyWindowType v = { { 0 } },ref = { { 0 } };
+MarkDrawModeType mode;
+INT xc,yc,rx,ry,maxr,px,py,w,h;
+double a;
+const char *error;
+int kind;
+
+    for(int i=0;i<n;i++) {
+        kind = i&3;
+        mode = (i>>2)&1 ? MARK_FILL : MARK_CONTOUR;
+        maxr = verifyrandom(4) ? VERIFY_CLIPMAXR : 100;
+        rx = (INT) verifyrandom(maxr+1);
+        ry = kind < 2 ? rx : (INT) verifyrandom(maxr+1);
+        xc = (INT) verifyrandom(2*VERIFY_CLIPMAXR+1)-VERIFY_CLIPMAXR;
+        yc = (INT) verifyrandom(2*VERIFY_CLIPMAXR+1)-VERIFY_CLIPMAXR;
+
+        // Window near a point of the curve (or anywhere in its box)
+        w = 1+(INT) verifyrandom(verifyrandom(8) ? VERIFY_CLIPSIZE : 2*maxr+1);
+        h = 1+(INT) verifyrandom(verifyrandom(8) ? VERIFY_CLIPSIZE : 2*maxr+1);
+        a = 2*M_PI*(double) verifyrandom(1L<<20)/(1L<<20);
+        px = xc+(INT) lround(rx*cos(a))-(INT) verifyrandom(w);
+        py = yc+(INT) lround(ry*sin(a))-(INT) verifyrandom(h);
+        if( !verifyrandom(8) ) {
+            px = xc-rx+(INT) verifyrandom(2*(LONG64) rx+1)-w/2;
+            py = yc-ry+(INT) verifyrandom(2*(LONG64) ry+1)-h/2;
+        }
+        v.w = ref.w = (MarkClipType) { px, py, px+w-1, py+h-1 };
+
+        verifywindowdraw(&ref,kind,mode,xc,yc,rx,ry,1);
+        verifywindowdraw(&v,kind,mode,xc,yc,rx,ry,0);
+        check->figures++;
+        check->total += ref.p.n;
+
+        error = 0;
+        if( v.p.n != ref.p.n ) error = "not the points of the window";
+        for(LONG64 j=0;j<ref.p.n && !error;j++)
+            if( v.p.x[j] != ref.p.x[j] || v.p.y[j] != ref.p.y[j] )
+                error = "points of the window out of order";
+
+        if( error ) {
+            if( check->failures < VERIFY_MAXERRORS )
+                printf("%s: kind=%d mode=%d c=(%d,%d) r=(%d,%d) window=(%d,%d)-(%d,%d): %s\n",
+                       check->name,kind,(int) mode,(int) xc,(int) yc,(int) rx,(int) ry,
+                       (int) v.w.xmin,(int) v.w.ymin,(int) v.w.xmax,(int) v.w.ymax,error);
+            check->failures++;
+        }
+    }
+    free(v.p.x);
+    free(v.p.y);
+    free(ref.p.x);
+    free(ref.p.y);
+}
+
+
+int main(int argc, char *argv[]) {
+static VerifyCheckType checks[] = {
+    { "polygon-fill",   verifypolygons, 10, "pixels", 0, 0, 0 },
+    { "motion",         verifymotion,   10, "steps",  0, 0, 0 },
+    { "dirty",          verifydirty,    10, "pixels", 0, 0, 0 },
+    { "mapped",         verifymapped,   10, "bytes",  0, 0, 0 },
+    { "sparse",         verifysparse,   10, "bytes",  0, 0, 0 },
+    { "stroke",         verifystroke,   20, "pixels", 0, 0, 0 },
+    { "pattern",        verifypattern,  20, "points", 0, 0, 0 },
+    { "clip-window",    verifyclip,     20, "points", 0, 0, 0 },
+};
+VerifyAlgType algs[DRAWBACKEND_MAX+1];
+const DrawBackendType *b;
+int nalgs = 0;
+int n = VERIFY_ELLIPSES;
+INT maxr = VERIFY_MAXR;
+unsigned long failures = 0;
+
+    if( argc > 1 ) n = atoi(argv[1]);
+    if( argc > 2 ) maxr = (INT) atol(argv[2]);
+    if( n < 0 ) n = VERIFY_ELLIPSES;
+    if( maxr <= 0 || maxr > MARK_ELLIPSE_MAXLONG128 ) maxr = VERIFY_MAXR;
+    srand(argc > 3 ? (unsigned) atoi(argv[3]) : 1);
+
+    // Aliased backends of the registry and the loops of drawloop.h
+    for(int i=0;i<DrawBackendCount();i++) {
+        b = DrawBackendGet(i);
+        if( b->antialiased ) continue;
+        algs[nalgs++] = (VerifyAlgType) { b->name, b->ellipse, INT_MAX, 0, 0, 0, 0 };
+    }
+    algs[nalgs++] = (VerifyAlgType) { "drawloop", verifyloopctx, MARK_ELLIPSE_MAXLONG64, 0, 0, 0, 0 };
+
+    printf("algorithm,ellipses,points,max_distance,failures\n");
+    for(int i=0;i<nalgs;i++) {
+        srand(argc > 3 ? (unsigned) atoi(argv[3]) : 1);
+        verifyalgorithm(&algs[i],n,maxr);
+        printf("%s,%lu,%lu,%.3f,%lu\n",algs[i].name,algs[i].ellipses,
+               algs[i].points,algs[i].maxdist,algs[i].failures);
+        failures += algs[i].failures;
+    }
+
+    // Rotated ellipses and arcs (on grids, so the radii are smaller)
+    for(int i=0;i<4;i++) {
+        static const char *names[] = { "rotated", "arc-rotated", "arc-ellipse", "arc-circle" };
+        static const int kinds[] = { 0, 0, 1, 2 };
+        VerifyAlgType alg = { names[i], 0, VERIFY_MAXROT, 0, 0, 0, 0 };
+
+        srand(argc > 3 ? (unsigned) atoi(argv[3]) : 1);
+        verifyarcs(&alg,kinds[i],i > 0,n,VERIFY_MAXROT);
+        printf("%s,%lu,%lu,%.3f,%lu\n",alg.name,alg.ellipses,alg.points,
+               alg.maxdist,alg.failures);
+        failures += alg.failures;
+    }
+
+    // Bézier curves and polylines
+    for(int i=0;i<2;i++) {
+        VerifyAlgType alg = { i ? "polyline" : "bezier", 0, VERIFY_MAXCURVE, 0, 0, 0, 0 };
+
+        srand(argc > 3 ? (unsigned) atoi(argv[3]) : 1);
+        verifycurves(&alg,i,n*10,VERIFY_MAXCURVE);
+        printf("%s,%lu,%lu,%.3f,%lu\n",alg.name,alg.ellipses,alg.points,
+               alg.maxdist,alg.failures);
+        failures += alg.failures;
+    }
+
+    // Other figures and screens: figures drawn and pixels, steps or bytes checked
+    printf("check,figures,total,units,failures\n");
+    for(int i=0;i<(int) (sizeof(checks)/sizeof(checks[0]));i++) {
+        VerifyCheckType *c = &checks[i];
+
+        srand(argc > 3 ? (unsigned) atoi(argv[3]) : 1);
+        c->run(c,n*c->count);
+        printf("%s,%lu,%lu,%s,%lu\n",c->name,c->figures,c->total,c->units,c->failures);
+        failures += c->failures;
+    }
+    return failures ? 1 : 0;
+}
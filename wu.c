@@ -0,0 +1,312 @@
+/**
+ * @file    wu.c
+ *
+ * @brief   Draw antialiased line, circle and ellipse using the Xiaolin Wu
+ *          algorithm
+ *
+ * @note   Only integer operations are used. The lines use a 16 bit fixed
+ *         point error accumulator (as in the Abrash implementation). The
+ *         circles and ellipses keep the integer part of the exact curve and
+ *         get the fractional part from the residue of the implicit equation,
+ *         with one division for each step.
+ *
+ * @note   Each pixel is sent with its coverage (0 to 255) to the blend sink
+ *         of the context. The default one blends the ink into the screen,
+ *         so a PGM (or PPM) screen is needed to see the gray levels.
+ *
+ * @note   Only contours are drawn. The draw mode of the context is ignored.
+ *
+ * @note   LONG64 is used for circles and ellipses, and for the shifted terms
+ *         of the lines, so a 32 bit long is enough
+ *
+ * @author  Hans
+ *
+ * @version 1.0
+ *
+ * @date    17/10/2026
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include "wu.h"
+#include "mark.h"
+
+
+/**
+ * @brief   Send a point with its coverage to the blend sink
+ *
+ * @note    When the figure is not inside the clipping window, each point is
+ *          tested
+ */
+static inline void wuplot(DrawContextType *ctx, MarkClipType *clip, int inside,
+                          INT x, INT y, INT alpha) {
+
+    if( alpha <= 0 ) return;
+    if( !inside && (x < clip->xmin || x > clip->xmax ||
+                    y < clip->ymin || y > clip->ymax) ) return;
+    MARKBLEND(ctx,x,y,alpha);
+}
+
+
+/**
+ * @brief   Plot points mirroring along the axes (each distinct point once)
+ */
+static void wuquad(DrawContextType *ctx, MarkClipType *clip, int inside,
+                   INT xc, INT yc, INT x, INT y, INT alpha) {
+
+    wuplot(ctx,clip,inside,xc+x,yc+y,alpha);
+    if( x != 0 ) wuplot(ctx,clip,inside,xc-x,yc+y,alpha);
+    if( y != 0 ) {
+        wuplot(ctx,clip,inside,xc+x,yc-y,alpha);
+        if( x != 0 ) wuplot(ctx,clip,inside,xc-x,yc-y,alpha);
+    }
+}
+
+
+/**
+ * @brief   Plot points mirroring along the axes and the diagonals
+ */
+static void wuoct(DrawContextType *ctx, MarkClipType *clip, int inside,
+                  INT xc, INT yc, INT x, INT y, INT alpha) {
+
+    wuquad(ctx,clip,inside,xc,yc,x,y,alpha);
+    if( x != y ) wuquad(ctx,clip,inside,xc,yc,y,x,alpha);
+}
+
+
+/**
+ * @brief   Draw an antialiased line using Wu algorithm
+ *
+ * @note    The end points are drawn with full coverage. At each step along the
+ *          major axis, the two pixels around the line share the coverage
+ *          according to the fractional part kept in the error accumulator
+ *
+ * @note    Horizontal, vertical and diagonal lines have no intermediate levels
+ */
+void drawlinewctx(DrawContextType *ctx, INT x1, INT y1, INT x2, INT y2) {
+MarkClipType clip;
+MarkClipResultType c;
+uint64_t erradj,erracc,tmp;
+INT dx,dy,xdir,t;
+INT x,y,w;
+int inside;
+
+    if( !MarkGetClip(ctx,&clip) ) return;
+
+    // Upper half plane (y1 <= y2)
+    if( y1 > y2 ) {
+        t = x1; x1 = x2; x2 = t;
+        t = y1; y1 = y2; y2 = t;
+    }
+    // The pixels beside the line are one row (or column) away
+    c = MarkClipBox(ctx,(x1<x2?x1:x2)-1,y1-1,(x1<x2?x2:x1)+1,y2+1);
+    if( c == MARK_OUTSIDE ) return;
+    inside = c == MARK_INSIDE;
+
+    dx = x2-x1;
+    dy = y2-y1;
+    xdir = 1;
+    if( dx < 0 ) {
+        xdir = -1;
+        dx = -dx;
+    }
+
+    wuplot(ctx,&clip,inside,x1,y1,255);
+    x = x1;
+    y = y1;
+    if( dy == 0 ) {
+        while( dx-- > 0 ) {
+            x += xdir;
+            wuplot(ctx,&clip,inside,x,y,255);
+        }
+        return;
+    }
+    if( dx == 0 ) {
+        while( dy-- > 0 ) {
+            y++;
+            wuplot(ctx,&clip,inside,x,y,255);
+        }
+        return;
+    }
+    if( dx == dy ) {
+        while( dy-- > 0 ) {
+            x += xdir;
+            y++;
+            wuplot(ctx,&clip,inside,x,y,255);
+        }
+        return;
+    }
+
+    erracc = 0;
+    if( dy > dx ) {
+        // Y major. Fractional part of x in 16 bits
+        erradj = ((uint64_t) dx<<16)/(uint64_t) dy;
+        while( --dy > 0 ) {
+            tmp = erracc;
+            erracc = (erracc+erradj)&0xFFFF;
+            if( erracc <= tmp ) x += xdir;
+            y++;
+            w = (INT) (erracc>>8);
+            wuplot(ctx,&clip,inside,x,y,255-w);
+            wuplot(ctx,&clip,inside,x+xdir,y,w);
+        }
+    } else {
+        // X major. Fractional part of y in 16 bits
+        erradj = ((uint64_t) dy<<16)/(uint64_t) dx;
+        while( --dx > 0 ) {
+            tmp = erracc;
+            erracc = (erracc+erradj)&0xFFFF;
+            if( erracc <= tmp ) y++;
+            x += xdir;
+            w = (INT) (erracc>>8);
+            wuplot(ctx,&clip,inside,x,y,255-w);
+            wuplot(ctx,&clip,inside,x,y+1,w);
+        }
+    }
+    wuplot(ctx,&clip,inside,x2,y2,255);
+}
+
+
+/**
+ * @brief   Draw an antialiased circle using Wu algorithm
+ *
+ * @note    For each y in the first octant, x is the integer part of
+ *          sqrt(r*r-y*y), kept incrementally as in the midpoint algorithm.
+ *          The residue e = r*r-y*y-x*x is between 0 and 2*x, so the
+ *          fractional part is approximately e/(2*x+1).
+ *          Pixel x gets the coverage 1-f and pixel x+1 the coverage f.
+ */
+void drawcirclewctx(DrawContextType *ctx, INT xc, INT yc, INT r) {
+MarkClipType clip;
+MarkClipResultType c;
+LONG64 t,xx,e;
+INT x,y,alpha;
+int inside;
+
+    if( r < 0 ) return;
+    if( !MarkGetClip(ctx,&clip) ) return;
+    c = MarkClipBox(ctx,xc-r-1,yc-r-1,xc+r+1,yc+r+1);
+    if( c == MARK_OUTSIDE ) return;
+    inside = c == MARK_INSIDE;
+
+    x  = r;
+    y  = 0;
+    t  = (LONG64) r*r;              // r*r-y*y
+    xx = t;                         // x*x
+    while( y <= x ) {
+        while( xx > t ) {
+            xx -= 2*(LONG64)x-1;
+            x--;
+        }
+        if( y > x ) break;
+        e = t-xx;
+        alpha = (INT) ((e*255)/(2*(LONG64)x+1));
+        wuoct(ctx,&clip,inside,xc,yc,x,y,255-alpha);
+        wuoct(ctx,&clip,inside,xc,yc,x+1,y,alpha);
+        t -= 2*(LONG64)y+1;
+        y++;
+    }
+}
+
+
+/**
+ * @brief   Draw an antialiased ellipse using Wu algorithm
+ *
+ * @note    Ellipse axes are horizontal and vertical
+ *
+ * @note    The first quadrant is split where the slope is -1. In the first
+ *          region, x is incremented and y is the integer part of the
+ *          exact curve. The residue of rx2*y*y <= ry2*(rx2-x*x) gives the
+ *          fractional part, as for the circle. The second region is the
+ *          same with x and y swapped.
+ *
+ * @note    The terms (up to rx2*ry2) use LONG64. Radii larger than
+ *          MARK_ELLIPSE_MAXLONG64 are not drawn
+ */
+void drawellipsewctx(DrawContextType *ctx, INT xc, INT yc, INT rx, INT ry) {
+MarkClipType clip;
+MarkClipResultType c;
+LONG64 rx2,ry2,t,yy,xx,e;
+INT x,y,alpha;
+int inside;
+
+    if( MarkEllipseRange(xc,yc,rx,ry) == MARK_RANGE_NONE ) return;
+    if( rx == 0 || ry == 0 ) {
+        drawlinewctx(ctx,xc-rx,yc-ry,xc+rx,yc+ry);
+        return;
+    }
+    if( rx > MARK_ELLIPSE_MAXLONG64 || ry > MARK_ELLIPSE_MAXLONG64 ) return;
+    if( MarkEllipseRange(xc,yc,rx+1,ry+1) == MARK_RANGE_NONE ) return;
+    if( !MarkGetClip(ctx,&clip) ) return;
+    c = MarkClipBox(ctx,xc-rx-1,yc-ry-1,xc+rx+1,yc+ry+1);
+    if( c == MARK_OUTSIDE ) return;
+    inside = c == MARK_INSIDE;
+
+    rx2 = (LONG64) rx*rx;
+    ry2 = (LONG64) ry*ry;
+
+    // Region 1: |slope| < 1, step in x
+    x  = 0;
+    y  = ry;
+    t  = rx2*ry2;                   // ry2*(rx2-x*x)
+    yy = t;                         // rx2*y*y
+    while( ry2*x <= rx2*y ) {
+        while( yy > t ) {
+            yy -= rx2*(2*(LONG64)y-1);
+            y--;
+        }
+        e = t-yy;
+        alpha = (INT) ((e*255)/(rx2*(2*(LONG64)y+1)));
+        wuquad(ctx,&clip,inside,xc,yc,x,y,255-alpha);
+        wuquad(ctx,&clip,inside,xc,yc,x,y+1,alpha);
+        t -= ry2*(2*(LONG64)x+1);
+        x++;
+    }
+
+    // Region 2: |slope| > 1, step in y
+    x  = rx;
+    y  = 0;
+    t  = rx2*ry2;                   // rx2*(ry2-y*y)
+    xx = t;                         // ry2*x*x
+    while( rx2*y < ry2*x ) {
+        while( xx > t ) {
+            xx -= ry2*(2*(LONG64)x-1);
+            x--;
+        }
+        e = t-xx;
+        alpha = (INT) ((e*255)/(ry2*(2*(LONG64)x+1)));
+        wuquad(ctx,&clip,inside,xc,yc,x,y,255-alpha);
+        wuquad(ctx,&clip,inside,xc,yc,x+1,y,alpha);
+        t -= rx2*(2*(LONG64)y+1);
+        y++;
+    }
+}
+
+
+/**
+ * @brief   Old interface. Draw on markscreen using the global variables
+ *
+ * @note    A context is built from them at each call (see MarkGlobalContext)
+ */
+///@{
+void drawlinew(INT x1, INT y1, INT x2, INT y2) {
+DrawContextType ctx;
+
+    MarkGlobalContext(&ctx);
+    drawlinewctx(&ctx,x1,y1,x2,y2);
+}
+
+void drawcirclew(INT xc, INT yc, INT r) {
+DrawContextType ctx;
+
+    MarkGlobalContext(&ctx);
+    drawcirclewctx(&ctx,xc,yc,r);
+}
+
+void drawellipsew(INT xc, INT yc, INT rx, INT ry) {
+DrawContextType ctx;
+
+    MarkGlobalContext(&ctx);
+    drawellipsewctx(&ctx,xc,yc,rx,ry);
+}
+///@}
@@ -0,0 +1,32 @@
+#ifndef WU_H
+#define WU_H
+/**
+ * @file    wu.h
+ * @brief   Antialiased (Xiaolin Wu) routines for line, circle and ellipse
+ *
+ * @version 1.0
+ * Date:    17/10/2026
+ *
+ */
+
+#ifndef INT
+#define INT     int
+#endif
+
+#ifndef LONG
+#define LONG    long
+#endif
+
+#include "mark.h"
+
+
+void drawlinew(INT x1, INT y1, INT x2, INT y2);
+void drawcirclew(INT xc, INT yc, INT r);
+void drawellipsew(INT xc, INT yc, INT rx, INT ry);
+
+void drawlinewctx(DrawContextType *ctx, INT x1, INT y1, INT x2, INT y2);
+void drawcirclewctx(DrawContextType *ctx, INT xc, INT yc, INT r);
+void drawellipsewctx(DrawContextType *ctx, INT xc, INT yc, INT rx, INT ry);
+
+
+#endif // WU_H